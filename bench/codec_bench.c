@@ -0,0 +1,231 @@
+﻿/// \file codec_bench.c
+/// \brief 十六进制和base64批量编解码性能测试
+///
+/// \details
+/// 先以随机数据、随机插入非法字符的字符串和不同的目的缓冲区大小检查各实现与通用实现的结果和错误位置完全相同，
+/// 再测试各实现在不同数据长度下的吞吐量，结果以JSON格式输出到stdout，检查失败时返回1
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/28 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "estring.h"
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define CODEC_MAXLEN        (1 << 20)   // 最大数据长度
+#define CODEC_CHECKS        (20000)     // 每种实现的检查次数
+#define CODEC_REPEAT        (5)         // 每项测试重复次数 取最好结果
+
+// ********************************************************************************************
+// 内部变量
+
+static uint8_t data[CODEC_MAXLEN + 64];
+static char text[CODEC_MAXLEN * 2 + 64];
+static uint8_t out[CODEC_MAXLEN + 64];
+static char outtext[CODEC_MAXLEN * 2 + 64];
+static uint32_t seed = 12345;
+static bool firstresult = true;
+
+static const char* levelname[] = {"scalar", "sse2", "avx2", "neon"};
+
+// estring.c的eprintf需要
+void eputchar(char chr)
+{
+    putchar(chr);
+}
+
+static uint64_t GetTimeNs(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)(count.QuadPart * 1e9 / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// ********************************************************************************************
+// 结果检查
+
+typedef struct
+{
+    int32_t res;
+    uint32_t errpos;
+    uint32_t len;
+}CheckResult;
+
+// 以指定的实现解码 记录返回值、错误位置和输出
+static CheckResult Decode(int level, bool base64, const char* str, uint32_t len, uint32_t size, uint8_t* dest)
+{
+    CheckResult r = {0, 0xFFFFFFFF, 0};
+
+    ecodecSelect(level);
+    r.res = base64 ? ebase64decode(dest, size, str, len, &r.errpos) : ehexdecode(dest, size, str, len, &r.errpos);
+    return r;
+}
+
+// 以指定的实现编码
+static uint32_t Encode(int level, bool base64, const uint8_t* src, uint32_t len, uint32_t size, char* dest)
+{
+    ecodecSelect(level);
+    return base64 ? ebase64encode(dest, size, src, len) : ehexencode(dest, size, src, len, (int)(len & 1));
+}
+
+// 检查一种实现与通用实现的结果相同
+static bool CheckLevel(int level)
+{
+    static uint8_t ref[4096 + 64];
+    static char reftext[8192 + 64];
+
+    for (uint32_t n = 0; n < CODEC_CHECKS; ++n)
+    {
+        bool base64 = n & 1;
+        uint32_t len = Random() % (n < CODEC_CHECKS / 2 ? 300 : 4096);
+        for (uint32_t i = 0; i < len; ++i)
+            data[i] = (uint8_t)Random();
+
+        // 编码 随机截断目的缓冲区
+        uint32_t size = (Random() & 3) ? sizeof(reftext) : Random() % (len * 2 + 2);
+        uint32_t reflen = Encode(ECODEC_SCALAR, base64, data, len, size, reftext);
+        uint32_t outlen = Encode(level, base64, data, len, size, outtext);
+        if (reflen != outlen || memcmp(reftext, outtext, reflen + (size ? 1 : 0)))
+        {
+            fprintf(stderr, "%s %s encode mismatch len=%u size=%u\n", levelname[level], base64 ? "base64" : "hex", len, size);
+            return false;
+        }
+
+        // 解码 随机改变字符或去除填充
+        uint32_t textlen = Encode(ECODEC_SCALAR, base64, data, len, sizeof(reftext), text);
+        uint32_t change = Random() % 4;
+        for (uint32_t i = 0; i < change && textlen; ++i)
+            text[Random() % textlen] = (char)Random();
+        if (base64 && 0 == Random() % 4)
+            for (; textlen && '=' == text[textlen - 1]; --textlen);
+        if (0 == Random() % 16 && textlen)
+            --textlen;
+        size = (Random() & 3) ? sizeof(ref) : Random() % (len + 2);
+
+        memset(ref, 0, len + 64);
+        memset(out, 0, len + 64);
+        CheckResult r1 = Decode(ECODEC_SCALAR, base64, text, textlen, size, ref);
+        CheckResult r2 = Decode(level, base64, text, textlen, size, out);
+        if (r1.res != r2.res || r1.errpos != r2.errpos || (r1.res > 0 && memcmp(ref, out, (size_t)r1.res)))
+        {
+            fprintf(stderr, "%s %s decode mismatch len=%u res=%d/%d errpos=%u/%u\n", levelname[level],
+                base64 ? "base64" : "hex", textlen, r1.res, r2.res, r1.errpos, r2.errpos);
+            return false;
+        }
+        if (0 == change && textlen == Encode(ECODEC_SCALAR, base64, data, len, sizeof(reftext), outtext)
+            && size >= len && (r1.res != (int32_t)len || memcmp(ref, data, len)))
+        {
+            fprintf(stderr, "%s %s round trip failed len=%u\n", levelname[level], base64 ? "base64" : "hex", len);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ********************************************************************************************
+// 性能测试
+
+static void Report(const char* name, int level, uint32_t len, uint32_t inbytes, uint64_t ns, uint32_t ops)
+{
+    double gbps = ns ? (double)inbytes * ops / ns : 0.0;
+
+    printf("%s    {\"name\":\"%s\",\"impl\":\"%s\",\"bytes\":%u,\"ns_per_op\":%.1f,\"gb_per_s\":%.2f}",
+        firstresult ? "" : ",\n", name, levelname[level], len, (double)ns / ops, gbps);
+    firstresult = false;
+}
+
+// 测试一种实现 吞吐量按数据字节计算
+static void BenchLevel(int level, uint32_t len)
+{
+    uint32_t ops = (uint32_t)(64u * 1024 * 1024 / (len + 16));
+    uint32_t hexlen = ehexencode(text, sizeof(text), data, len, 0);
+    uint32_t b64len;
+    static char b64text[CODEC_MAXLEN * 4 / 3 + 64];
+    uint64_t best[4] = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+
+    b64len = ebase64encode(b64text, sizeof(b64text), data, len);
+    ecodecSelect(level);
+    for (int r = 0; r < CODEC_REPEAT; ++r)
+    {
+        uint64_t start = GetTimeNs();
+        for (uint32_t i = 0; i < ops; ++i)
+            ehexencode(outtext, sizeof(outtext), data, len, 0);
+        uint64_t t1 = GetTimeNs();
+        for (uint32_t i = 0; i < ops; ++i)
+            ehexdecode(out, sizeof(out), text, hexlen, NULL);
+        uint64_t t2 = GetTimeNs();
+        for (uint32_t i = 0; i < ops; ++i)
+            ebase64encode(outtext, sizeof(outtext), data, len);
+        uint64_t t3 = GetTimeNs();
+        for (uint32_t i = 0; i < ops; ++i)
+            ebase64decode(out, sizeof(out), b64text, b64len, NULL);
+        uint64_t t4 = GetTimeNs();
+
+        uint64_t ns[4] = {t1 - start, t2 - t1, t3 - t2, t4 - t3};
+        for (int k = 0; k < 4; ++k)
+            if (ns[k] < best[k])
+                best[k] = ns[k];
+    }
+    Report("hexencode", level, len, len, best[0], ops);
+    Report("hexdecode", level, len, hexlen, best[1], ops);
+    Report("base64encode", level, len, len, best[2], ops);
+    Report("base64decode", level, len, b64len, best[3], ops);
+}
+
+// ********************************************************************************************
+// 主函数
+
+int main(void)
+{
+    static const uint32_t lens[] = {64, 4096, CODEC_MAXLEN};
+    int maxlevel = ecodecSelect(ECODEC_AUTO);
+    bool ok = true;
+
+    // 检查所有支持的实现
+    for (int level = ECODEC_SSE2; level <= ECODEC_NEON; ++level)
+        if (ecodecSelect(level) == level && !CheckLevel(level))
+            ok = false;
+
+    printf("{\n  \"suite\":\"codec\",\n  \"best\":\"%s\",\n  \"check\":%s,\n  \"results\":[\n",
+        levelname[maxlevel], ok ? "true" : "false");
+    for (uint32_t i = 0; i < CODEC_MAXLEN; ++i)
+        data[i] = (uint8_t)Random();
+    for (uint32_t n = 0; n < sizeof(lens) / sizeof(lens[0]); ++n)
+        for (int level = ECODEC_SCALAR; level <= ECODEC_NEON; ++level)
+            if (ecodecSelect(level) == level)
+                BenchLevel(level, lens[n]);
+    printf("\n  ]\n}\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+﻿/// \file format_bench.cpp
+/// \brief uecli::format检查和性能测试
+///
+/// \details
+/// 先以随机参数检查uecli::format与snprintf的结果相同，再测试几种格式下uecli::format、
+/// esnprintf、snprintf和std::format(标准库支持时)每次调用的耗时，
+/// 结果以JSON格式输出到stdout，检查失败时返回1。需要C++20
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/28 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "uecli.hpp"
+
+#if defined(__has_include)
+#if __has_include(<format>)
+#include <format>
+#endif
+#endif
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define FMT_CHECKS          (100000)    // 随机检查次数
+#define FMT_OPS             (1000000)   // 每项测试调用次数
+#define FMT_REPEAT          (5)         // 每项测试重复次数 取最好结果
+#define FMT_VALUES          (256)       // 参数组数
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE
+#endif
+
+// ********************************************************************************************
+// 内部变量
+
+struct FmtValues
+{
+    int32_t num;
+    uint32_t hex;
+    const char* name;
+    char ch;
+};
+
+static FmtValues values[FMT_VALUES];
+static uint32_t seed = 12345;
+static bool firstresult = true;
+static volatile uint32_t sink;
+
+// estring.c的eprintf需要
+extern "C" void eputchar(char chr)
+{
+    putchar(chr);
+}
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static uint64_t GetTimeNs(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ********************************************************************************************
+// 测试格式 每种格式分别以四种方法实现
+
+typedef uint32_t(*BenchFun)(char* buff, uint32_t size, const FmtValues& v);
+
+// 整数
+static NOINLINE uint32_t UInt(char* buff, uint32_t size, const FmtValues& v)
+{
+    return uecli::format<"%d">(buff, size, v.num);
+}
+static NOINLINE uint32_t EInt(char* buff, uint32_t size, const FmtValues& v)
+{
+    esnprintf(buff, size, "%d", v.num);
+    return buff[0];
+}
+static NOINLINE uint32_t LInt(char* buff, uint32_t size, const FmtValues& v)
+{
+    return (uint32_t)snprintf(buff, size, "%d", v.num);
+}
+
+// 名称和十六进制数
+static NOINLINE uint32_t UHex(char* buff, uint32_t size, const FmtValues& v)
+{
+    return uecli::format<"%s=%08x">(buff, size, v.name, v.hex);
+}
+static NOINLINE uint32_t EHex(char* buff, uint32_t size, const FmtValues& v)
+{
+    esnprintf(buff, size, "%s=%08x", v.name, v.hex);
+    return buff[0];
+}
+static NOINLINE uint32_t LHex(char* buff, uint32_t size, const FmtValues& v)
+{
+    return (uint32_t)snprintf(buff, size, "%s=%08x", v.name, v.hex);
+}
+
+// 命令输出中常见的一行
+static NOINLINE uint32_t ULine(char* buff, uint32_t size, const FmtValues& v)
+{
+    return uecli::format<"id=%d name=%-8s val=%#x ch=%c\r\n">(buff, size, v.num, v.name, v.hex, v.ch);
+}
+static NOINLINE uint32_t ELine(char* buff, uint32_t size, const FmtValues& v)
+{
+    esnprintf(buff, size, "id=%d name=%-8s val=%#x ch=%c\r\n", v.num, v.name, v.hex, v.ch);
+    return buff[0];
+}
+static NOINLINE uint32_t LLine(char* buff, uint32_t size, const FmtValues& v)
+{
+    return (uint32_t)snprintf(buff, size, "id=%d name=%-8s val=%#x ch=%c\r\n", v.num, v.name, v.hex, v.ch);
+}
+
+#if defined(__cpp_lib_format)
+static NOINLINE uint32_t SInt(char* buff, uint32_t size, const FmtValues& v)
+{
+    return (uint32_t)std::format_to_n(buff, size - 1, "{}", v.num).size;
+}
+static NOINLINE uint32_t SHex(char* buff, uint32_t size, const FmtValues& v)
+{
+    return (uint32_t)std::format_to_n(buff, size - 1, "{}={:08x}", v.name, v.hex).size;
+}
+static NOINLINE uint32_t SLine(char* buff, uint32_t size, const FmtValues& v)
+{
+    return (uint32_t)std::format_to_n(buff, size - 1, "id={} name={:<8} val={:#x} ch={}\r\n",
+        v.num, v.name, v.hex, v.ch).size;
+}
+#else
+#define SInt NULL
+#define SHex NULL
+#define SLine NULL
+#endif
+
+// ********************************************************************************************
+// 检查
+
+static void FillValues(void)
+{
+    static const char* const names[] = {"led", "param", "", "temperature", "x"};
+    for (uint32_t i = 0; i < FMT_VALUES; ++i)
+    {
+        uint32_t r = Random();
+        values[i].num = (int32_t)(Random() << 8) >> (r & 31);
+        values[i].hex = (Random() << 8 | r) >> (Random() & 31);
+        values[i].name = names[r % 5];
+        values[i].ch = (char)('!' + r % 90);
+    }
+    values[0].num = INT32_MIN;
+    values[1].num = 0;
+    values[1].hex = 0x12345678;
+}
+
+// uecli::format与snprintf的结果相同 esnprintf的%#x对0也加前缀、负数填充位置不同，不与其比较
+static bool CheckAll(void)
+{
+    static const BenchFun funs[][2] = {{UInt, LInt}, {UHex, LHex}, {ULine, LLine}};
+    char a[96], b[96];
+
+    for (uint32_t n = 0; n < FMT_CHECKS; ++n)
+    {
+        const FmtValues& v = values[n % FMT_VALUES];
+        uint32_t size = 1 + Random() % sizeof(a);
+        for (const auto& f : funs)
+        {
+            uint32_t la = f[0](a, size, v);
+            uint32_t lb = f[1](b, size, v);
+            if (strcmp(a, b) || la != (lb < size ? lb : size - 1))
+            {
+                fprintf(stderr, "check failed: size %u [%s] [%s]\n", size, a, b);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ********************************************************************************************
+// 性能测试
+
+// 返回每次调用的最短平均耗时
+static double BenchOne(BenchFun fun)
+{
+    char buff[96];
+    uint64_t best = UINT64_MAX;
+    uint32_t total = 0;
+
+    for (int r = 0; r < FMT_REPEAT; ++r)
+    {
+        uint64_t start = GetTimeNs();
+        for (uint32_t i = 0; i < FMT_OPS; ++i)
+            total += fun(buff, sizeof(buff), values[i % FMT_VALUES]);
+        uint64_t ns = GetTimeNs() - start;
+        if (ns < best)
+            best = ns;
+    }
+    sink = total;
+    return (double)best / FMT_OPS;
+}
+
+static void Report(const char* name, double format, double estr, double libc, double stdfmt)
+{
+    printf("%s    {\"name\":\"%s\",\"format_ns\":%.1f,\"esnprintf_ns\":%.1f,\"snprintf_ns\":%.1f,",
+        firstresult ? "" : ",\n", name, format, estr, libc);
+    if (stdfmt > 0)
+        printf("\"std_format_ns\":%.1f}", stdfmt);
+    else
+        printf("\"std_format_ns\":null}");
+    firstresult = false;
+}
+
+// ********************************************************************************************
+// 主函数
+
+int main(void)
+{
+    static const struct
+    {
+        const char* name;
+        BenchFun format, estr, libc, stdfmt;
+    } funs[] =
+    {
+        {"%d", UInt, EInt, LInt, SInt},
+        {"%s=%08x", UHex, EHex, LHex, SHex},
+        {"id=%d name=%-8s val=%#x ch=%c", ULine, ELine, LLine, SLine},
+    };
+
+    FillValues();
+    bool ok = CheckAll();
+
+    printf("{\n  \"suite\":\"format\",\n  \"check\":%s,\n  \"results\":[\n", ok ? "true" : "false");
+    for (const auto& f : funs)
+    {
+        Report(f.name, BenchOne(f.format), BenchOne(f.estr), BenchOne(f.libc),
+            f.stdfmt ? BenchOne(f.stdfmt) : 0);
+    }
+    printf("\n  ]\n}\n");
+    return ok ? 0 : 1;
+}
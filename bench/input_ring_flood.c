@@ -0,0 +1,206 @@
+﻿/// \file input_ring_flood.c
+/// \brief 中断输入队列压力测试
+///
+/// \details
+/// 生产者线程以最快速度调用uecli_PushInputISR放入"seq N\r"命令，主线程循环调用uecli_DrainInput处理：
+/// - lossless：生产者在队列满时重试剩余部分，检查所有命令按顺序执行且没有丢失，溢出计数为被拒绝后重试的字节数
+/// - flood：生产者不重试，检查处理字节数加溢出字节数等于放入字节数
+/// 需要打开UECLI_01_INPUT_RING，结果以JSON格式输出到stdout，检查失败时返回1
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+#include "uecli.h"
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define FLOOD_COMMANDS      (2000000)   // 每项测试的命令数量
+#define FLOOD_MAX_BURST     (64)        // 生产者每次放入的最大字节数 模拟中断中的突发接收
+
+// ********************************************************************************************
+// 内部变量
+
+static volatile uint32_t producing;     // 生产者运行中
+static bool retry;                      // 队列满时重试
+static uint64_t pushed;                 // 放入的字节数 包括溢出部分
+static uint32_t lastseq;                // 上一个执行的命令序号
+static uint32_t executed;               // 执行的命令数量
+static uint32_t outoforder;             // 序号不连续的次数
+
+// ********************************************************************************************
+// 端口
+
+bool uecli_port_init(void)
+{
+    return true;
+}
+
+void uecli_port_out(const void* buff, uint32_t num)
+{
+    (void)buff;
+    (void)num;
+}
+
+uint64_t uecli_port_time_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void eputchar(char chr)
+{
+    (void)chr;
+}
+
+// ********************************************************************************************
+// 测试命令
+
+static void seqfun(int argc, char** argv)
+{
+    uint32_t seq = (uint32_t)strtoul(argc > 1 ? argv[1] : "0", NULL, 10);
+
+    if (seq != lastseq + 1)
+        ++outoforder;
+    lastseq = seq;
+    ++executed;
+}
+
+static const uecli_MenuItem handtalbe[] =
+{
+    UECLI_DECLARE_COMMAND(seqfun, "seq", "序号命令"),
+    UECLI_DECLARE_END()
+};
+
+// 让出CPU 单核上生产者和消费者需要交替运行
+static void Yield(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+// ********************************************************************************************
+// 生产者
+
+#ifdef _WIN32
+static DWORD WINAPI Producer(LPVOID arg)
+#else
+static void* Producer(void* arg)
+#endif
+{
+    char line[32];
+    uint32_t burst = 1;
+
+    for (uint32_t seq = 1; seq <= FLOOD_COMMANDS; ++seq)
+    {
+        int len = snprintf(line, sizeof(line), "seq %u\r", seq);
+        pushed += (uint64_t)len;
+
+        // 按不同的突发长度放入
+        for (int pos = 0; pos < len; )
+        {
+            uint32_t num = (uint32_t)(len - pos) < burst ? (uint32_t)(len - pos) : burst;
+            uint32_t done = uecli_PushInputISR(&line[pos], num);
+            pos += retry ? (int)done : (int)num;
+            if (done < num)
+                Yield();
+            burst = burst % FLOOD_MAX_BURST + 1;
+        }
+    }
+    uecli_atomic_store(&producing, 0);
+    (void)arg;
+    return 0;
+}
+
+// ********************************************************************************************
+// 测试项
+
+static bool RunFlood(const char* name, bool lossless)
+{
+    uint64_t processed = 0;
+    uint32_t overflow = uecli_InputOverflow();
+
+    retry = lossless;
+    pushed = 0;
+    lastseq = 0;
+    executed = 0;
+    outoforder = 0;
+    producing = 1;
+
+    uint64_t start = uecli_port_time_ns();
+#ifdef _WIN32
+    HANDLE thread = CreateThread(NULL, 0, Producer, NULL, 0, NULL);
+#else
+    pthread_t thread;
+    pthread_create(&thread, NULL, Producer, NULL);
+#endif
+
+    // 生产者结束后再处理一次剩余数据
+    while (uecli_atomic_load(&producing))
+    {
+        uint32_t num = uecli_DrainInput();
+        if (!num)
+            Yield();
+        processed += num;
+    }
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+    processed += uecli_DrainInput();
+    double seconds = (uecli_port_time_ns() - start) / 1e9;
+
+    overflow = uecli_InputOverflow() - overflow;
+    bool pass = lossless ? (FLOOD_COMMANDS == executed && 0 == outoforder && processed == pushed)
+                         : (processed + overflow == pushed);
+
+    printf("  {\"name\":\"%s\",\"pushed_bytes\":%llu,\"processed_bytes\":%llu,\"overflow_bytes\":%u,"
+        "\"commands\":%u,\"executed\":%u,\"out_of_order\":%u,\"in_bytes_per_s\":%.0f,\"pass\":%s}",
+        name, (unsigned long long)pushed, (unsigned long long)processed, overflow,
+        FLOOD_COMMANDS, executed, outoforder, processed / seconds, pass ? "true" : "false");
+    return pass;
+}
+
+int main(void)
+{
+    uecli_Initialize(handtalbe);
+
+    printf("{\"ring_size\":%d,\"results\":[\n", UECLI_CFG_INPUT_RINGSIZE);
+    bool pass = RunFlood("lossless", true);
+    printf(",\n");
+    pass = RunFlood("flood", false) && pass;
+    printf("\n]}\n");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,462 @@
+﻿/// \file string_bench.c
+/// \brief estring核心字符串函数检查和性能测试
+///
+/// \details
+/// 先以随机字符串检查estrlen、estrnlen、estrchr、estrcmpNocase、estrncpy与C库函数的结果相同，
+/// estrcmpNocase和eStrSplit另外与原逐字节实现逐项对比，字符串放在不可访问页之前的各个对齐位置，
+/// 检查按块读取不会越过页边界；再测试不同长度下各函数与逐字节实现、C库函数的耗时，
+/// 结果以JSON格式输出到stdout，检查失败时返回1
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/28 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "estring.h"
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define STR_PAGE            (4096)      // 页大小
+#define STR_CHECKS          (200000)    // 随机检查次数
+#define STR_MAXLEN          (300)       // 随机字符串最大长度
+#define STR_REPEAT          (5)         // 每项测试重复次数 取最好结果
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE
+#endif
+
+// 与estring.c的选择条件相同
+#if !defined(ESTR_NO_SIMD) && defined(__AVX2__)
+#define STR_IMPL "avx2"
+#elif !defined(ESTR_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STR_IMPL "sse2"
+#elif !defined(ESTR_NO_SWAR) && (UINTPTR_MAX >= 0xFFFFFFFFu)
+#define STR_IMPL "swar"
+#else
+#define STR_IMPL "bytewise"
+#endif
+
+// ********************************************************************************************
+// 内部变量
+
+static char* guard[2];              // 后面紧跟不可访问页的页
+static char heap[2][8192];
+static uint32_t seed = 12345;
+static bool firstresult = true;
+static volatile uintptr_t sink;
+
+// estring.c的eprintf需要
+void eputchar(char chr)
+{
+    putchar(chr);
+}
+
+static uint64_t GetTimeNs(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)(count.QuadPart * 1e9 / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// 分配一页 其后的一页不可访问 访问越界时程序崩溃
+static char* AllocGuardPage(void)
+{
+#ifdef _WIN32
+    char* p = (char*)VirtualAlloc(NULL, STR_PAGE * 2, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    DWORD old;
+    if (p)
+        VirtualProtect(p + STR_PAGE, STR_PAGE, PAGE_NOACCESS, &old);
+    return p;
+#else
+    char* p = (char*)mmap(NULL, STR_PAGE * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == p)
+        return NULL;
+    mprotect(p + STR_PAGE, STR_PAGE, PROT_NONE);
+    return p;
+#endif
+}
+
+// ********************************************************************************************
+// 原逐字节实现 作为结果和耗时的对照
+
+static NOINLINE unsigned int RefStrlen(const char* str)
+{
+    const char* eos = str;
+    while (*eos++);
+    return (unsigned int)(eos - str - 1);
+}
+
+static NOINLINE unsigned int RefStrnlen(const char* str, unsigned int maxlen)
+{
+    unsigned int i = maxlen;
+    for (; *str && i; --i, ++str);
+    return maxlen - i;
+}
+
+static NOINLINE char* RefStrchr(const char* str, char chr)
+{
+    char c;
+    for (; '\0' != (c = *str); ++str)
+        if (c == chr)
+            return (char*)str;
+    return 0;
+}
+
+static NOINLINE int RefCmpNocase(const char* src, const char* dst)
+{
+    char temp1, temp2;
+    int ret;
+
+    if (src == dst) return 0;
+    for (; temp2 = *src, '\0' != (temp1 = *dst); ++src, ++dst)
+    {
+        if (temp1 >= 'A' && temp1 <= 'Z')
+            temp1 += 32;
+        if (temp2 >= 'A' && temp2 <= 'Z')
+            temp2 += 32;
+        if (temp2 != temp1)
+            break;
+    }
+    ret = temp2 - temp1;
+    return ret < 0 ? -1 : ret > 0;
+}
+
+static NOINLINE unsigned int RefStrncpy(char* dest, const char* source, unsigned int size)
+{
+    if (size)
+    {
+        unsigned int i = size;
+        for (; --i && '\0' != (*dest = *source); ++dest, ++source);
+        *dest = '\0';
+        return size - i - 1;
+    }
+    return 0;
+}
+
+static NOINLINE unsigned int RefSplit(char* str, char separator, char* substr[], unsigned int size)
+{
+    unsigned int count = 0;
+    char c, ischar = 0;
+
+    for (; '\0' != (c = *str); ++str)
+    {
+        if (c < ' ' || c > '\x7f')
+            *str = ' ';
+        if (' ' == c || separator == c)
+        {
+            ischar = 0;
+            *str = '\0';
+        }
+        else if (!ischar)
+        {
+            ischar = 1;
+            substr[count++] = str;
+            if (count >= size) break;
+        }
+    }
+    return count;
+}
+
+// ********************************************************************************************
+// 结果检查
+
+// 随机字符 偏向字母、空白和分隔符，包含控制字符和大于0x7F的字符
+static char RandomChar(void)
+{
+    static const char common[] = "abcxyzABCXYZ@[`{09 ,,";
+    uint32_t r = Random() % 16;
+
+    if (r < 10)
+        return common[Random() % (sizeof(common) - 1)];
+    if (r < 12)
+        return (char)(1 + Random() % 31);
+    if (r < 14)
+        return (char)(0x80 + Random() % 128);
+    return (char)(1 + Random() % 255);
+}
+
+// 在buff末尾生成长度为len的字符串 结束符为buff的最后一个字节
+static char* MakeString(char* buff, uint32_t buffsize, uint32_t len)
+{
+    char* str = buff + buffsize - len - 1;
+    for (uint32_t i = 0; i < len; ++i)
+        str[i] = RandomChar();
+    str[len] = '\0';
+    return str;
+}
+
+// 由a生成b 大部分相同 随机改变大小写、字符或长度
+static char* MakeSimilar(char* buff, uint32_t buffsize, const char* a, uint32_t len)
+{
+    uint32_t blen = len;
+    uint32_t r = Random() % 8;
+
+    if (1 == r && blen)
+        blen = Random() % blen;
+    else if (2 == r)
+        blen += Random() % 20;
+    char* b = buff + buffsize - blen - 1;
+    for (uint32_t i = 0; i < blen; ++i)
+    {
+        char c = i < len ? a[i] : RandomChar();
+        if (c >= 'a' && c <= 'z' && (Random() & 1))
+            c -= 32;
+        b[i] = c;
+    }
+    b[blen] = '\0';
+    if (3 == r && blen)
+        b[Random() % blen] = RandomChar();
+    return b;
+}
+
+static bool CheckFail(const char* name, uint32_t n, const char* str)
+{
+    fprintf(stderr, "%s mismatch at check %u, len=%u\n", name, n, (uint32_t)strlen(str));
+    return false;
+}
+
+// 检查各函数与C库函数及原逐字节实现的结果相同
+static bool CheckAll(void)
+{
+    char dest[STR_MAXLEN + 64], ref[STR_MAXLEN + 64];
+    char split1[STR_MAXLEN + 64], split2[STR_MAXLEN + 64];
+    char* sub1[STR_MAXLEN];
+    char* sub2[STR_MAXLEN];
+
+    for (uint32_t n = 0; n < STR_CHECKS; ++n)
+    {
+        // 一半放在页末尾 一半放在普通缓冲区的随机位置
+        bool atguard = n & 1;
+        uint32_t len = Random() % STR_MAXLEN;
+        char* a = atguard ? MakeString(guard[0], STR_PAGE, len)
+            : MakeString(heap[0], sizeof(heap[0]) - Random() % 64, len);
+        char* b = atguard ? MakeSimilar(guard[1], STR_PAGE, a, len)
+            : MakeSimilar(heap[1], sizeof(heap[1]) - Random() % 64, a, len);
+
+        // 长度
+        if (estrlen(a) != strlen(a))
+            return CheckFail("estrlen", n, a);
+        uint32_t maxlen = Random() % (len + 40);
+        if (estrnlen(a, maxlen) != RefStrnlen(a, maxlen))
+            return CheckFail("estrnlen", n, a);
+
+        // 搜索 C库在搜索'\0'时返回结束符位置 estrchr返回0
+        char chr = (Random() & 3) && len ? a[Random() % len] : RandomChar();
+        if (estrchr(a, chr) != strchr(a, chr) || estrchr(a, '\0'))
+            return CheckFail("estrchr", n, a);
+
+        // 忽略大小写比较 只含7位字符时与strcasecmp的符号相同
+        int r1 = estrcmpNocase(a, b);
+        if (r1 != RefCmpNocase(a, b))
+            return CheckFail("estrcmpNocase", n, a);
+        bool ascii = true;
+        for (const char* p = a; *p && ascii; ++p)
+            ascii = *p > 0;
+        for (const char* p = b; *p && ascii; ++p)
+            ascii = *p > 0;
+        int r2 = strcasecmp(a, b);
+        if (ascii && r1 != (r2 < 0 ? -1 : r2 > 0))
+            return CheckFail("estrcmpNocase/strcasecmp", n, a);
+
+        // 拷贝 检查返回值、内容和缓冲区之后的字节未被改变
+        uint32_t size = Random() % (len + 8);
+        memset(dest, 0x5A, sizeof(dest));
+        memset(ref, 0x5A, sizeof(ref));
+        unsigned int c1 = estrncpy(dest, a, size), c2 = RefStrncpy(ref, a, size);
+        if (c1 != c2 || memcmp(dest, ref, sizeof(dest)) || (size && c1 != strnlen(a, size - 1)))
+            return CheckFail("estrncpy", n, a);
+
+        // 分割 比较子字符串位置和分割后的缓冲区内容
+        // 达到数组大小会触发断言 定义NDEBUG时才检查数组大小限制
+#ifdef NDEBUG
+        uint32_t count = (Random() & 1) ? 1 + Random() % 16 : STR_MAXLEN;
+#else
+        uint32_t count = STR_MAXLEN;
+#endif
+        char separator = (Random() & 1) ? ',' : RandomChar();
+        char* s1 = atguard ? guard[1] + STR_PAGE - len - 1 : split1;
+        memcpy(split2, a, len + 1);
+        memcpy(s1, a, len + 1);
+        unsigned int k1 = eStrSplit(s1, separator, sub1, count);
+        unsigned int k2 = RefSplit(split2, separator, sub2, count);
+        bool same = k1 == k2 && !memcmp(s1, split2, len + 1);
+        for (unsigned int i = 0; i < k1 && same; ++i)
+            same = sub1[i] - s1 == sub2[i] - split2;
+        if (!same)
+            return CheckFail("eStrSplit", n, a);
+    }
+    return true;
+}
+
+// ********************************************************************************************
+// 性能测试
+
+typedef uintptr_t(*BenchFun)(char* str, uint32_t len);
+
+static uintptr_t EStrlen(char* str, uint32_t len) { (void)len; return estrlen(str); }
+static uintptr_t BStrlen(char* str, uint32_t len) { (void)len; return RefStrlen(str); }
+static uintptr_t LStrlen(char* str, uint32_t len) { (void)len; return strlen(str); }
+static uintptr_t EStrnlen(char* str, uint32_t len) { return estrnlen(str, len + 1); }
+static uintptr_t BStrnlen(char* str, uint32_t len) { return RefStrnlen(str, len + 1); }
+static uintptr_t LStrnlen(char* str, uint32_t len) { return strnlen(str, len + 1); }
+static uintptr_t EStrchr(char* str, uint32_t len) { (void)len; return (uintptr_t)estrchr(str, '#'); }
+static uintptr_t BStrchr(char* str, uint32_t len) { (void)len; return (uintptr_t)RefStrchr(str, '#'); }
+static uintptr_t LStrchr(char* str, uint32_t len) { (void)len; return (uintptr_t)strchr(str, '#'); }
+static uintptr_t ECmp(char* str, uint32_t len) { return (uintptr_t)estrcmpNocase(str, str + len + 1); }
+static uintptr_t BCmp(char* str, uint32_t len) { return (uintptr_t)RefCmpNocase(str, str + len + 1); }
+static uintptr_t LCmp(char* str, uint32_t len) { return (uintptr_t)strcasecmp(str, str + len + 1); }
+static uintptr_t ECopy(char* str, uint32_t len) { return estrncpy(str + len + 1, str, len + 1); }
+static uintptr_t BCopy(char* str, uint32_t len) { return RefStrncpy(str + len + 1, str, len + 1); }
+static uintptr_t ESplit(char* str, uint32_t len)
+{
+    static char* sub[1024];
+    memcpy(str + len + 1, str, len + 1);
+    return eStrSplit(str + len + 1, ',', sub, 1024);
+}
+static uintptr_t BSplit(char* str, uint32_t len)
+{
+    static char* sub[1024];
+    memcpy(str + len + 1, str, len + 1);
+    return RefSplit(str + len + 1, ',', sub, 1024);
+}
+static uintptr_t LSplit(char* str, uint32_t len)
+{
+    char* save;
+    uintptr_t count = 0;
+    memcpy(str + len + 1, str, len + 1);
+    for (char* p = strtok_r(str + len + 1, ", ", &save); p; p = strtok_r(NULL, ", ", &save))
+        ++count;
+    return count;
+}
+
+// 返回每次调用的最短平均耗时
+static double BenchOne(BenchFun fun, char* str, uint32_t len)
+{
+    uint32_t ops = (uint32_t)(16u * 1024 * 1024 / (len + 16));
+    uint64_t best = UINT64_MAX;
+
+    for (int r = 0; r < STR_REPEAT; ++r)
+    {
+        uint64_t start = GetTimeNs();
+        for (uint32_t i = 0; i < ops; ++i)
+            sink += fun(str, len);
+        uint64_t ns = GetTimeNs() - start;
+        if (ns < best)
+            best = ns;
+    }
+    return (double)best / ops;
+}
+
+static void Report(const char* name, uint32_t len, double estr, double bytewise, double libc)
+{
+    printf("%s    {\"name\":\"%s\",\"bytes\":%u,\"estring_ns\":%.1f,\"bytewise_ns\":%.1f,",
+        firstresult ? "" : ",\n", name, len, estr, bytewise);
+    if (libc > 0)
+        printf("\"libc_ns\":%.1f}", libc);
+    else
+        printf("\"libc_ns\":null}");
+    firstresult = false;
+}
+
+// 测试所有函数 字符串为命令行形式 没有'#'字符，比较的两个字符串只有大小写不同
+static void BenchLen(uint32_t len)
+{
+    static const char words[] = "Set,param value LED1 on ";
+    static const struct
+    {
+        const char* name;
+        BenchFun estr, bytewise, libc;
+    } funs[] =
+    {
+        {"estrlen", EStrlen, BStrlen, LStrlen},
+        {"estrnlen", EStrnlen, BStrnlen, LStrnlen},
+        {"estrchr", EStrchr, BStrchr, LStrchr},
+        {"estrcmpNocase", ECmp, BCmp, LCmp},
+        {"estrncpy", ECopy, BCopy, NULL},
+        {"eStrSplit", ESplit, BSplit, LSplit},
+    };
+    static char buff[2 * 4096 + 64];
+    char* str = buff + 1;
+
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        str[i] = words[i % (sizeof(words) - 1)];
+        str[len + 1 + i] = (str[i] >= 'a' && str[i] <= 'z') ? (char)(str[i] - 32) : str[i];
+    }
+    str[len] = '\0';
+    str[2 * len + 1] = '\0';
+
+    for (uint32_t n = 0; n < sizeof(funs) / sizeof(funs[0]); ++n)
+    {
+        // 拷贝和分割会写入后半部分 每项测试前恢复
+        double e = BenchOne(funs[n].estr, str, len);
+        double b = BenchOne(funs[n].bytewise, str, len);
+        double l = funs[n].libc ? BenchOne(funs[n].libc, str, len) : 0;
+        Report(funs[n].name, len, e, b, l);
+        for (uint32_t i = 0; i <= len; ++i)
+            str[len + 1 + i] = (str[i] >= 'a' && str[i] <= 'z') ? (char)(str[i] - 32) : str[i];
+    }
+}
+
+// ********************************************************************************************
+// 主函数
+
+int main(void)
+{
+    static const uint32_t lens[] = {8, 32, 256, 4096};
+    bool ok;
+
+    guard[0] = AllocGuardPage();
+    guard[1] = AllocGuardPage();
+    if (!guard[0] || !guard[1])
+    {
+        fprintf(stderr, "guard page allocation failed\n");
+        return 1;
+    }
+    ok = CheckAll();
+
+    printf("{\n  \"suite\":\"string\",\n  \"impl\":\"%s\",\n  \"check\":%s,\n  \"results\":[\n",
+        STR_IMPL, ok ? "true" : "false");
+    for (uint32_t n = 0; n < sizeof(lens) / sizeof(lens[0]); ++n)
+        BenchLen(lens[n]);
+    printf("\n  ]\n}\n");
+    return ok ? 0 : 1;
+}
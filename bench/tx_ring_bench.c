@@ -0,0 +1,276 @@
+﻿/// \file tx_ring_bench.c
+/// \brief 慢速链路上发送队列的效果测试
+///
+/// \details
+/// 模拟115200波特率的串口，每次写入调用有1ms固定延迟(USB串口的帧间隔)，写入调用等待数据发送完成后返回，
+/// 与Windows端口中GetOverlappedResult(..., TRUE)的行为相同。分别测试以下项目中命令函数的执行时间和链路发送完成的时间：
+/// - echo：逐字输入24个字符的回显
+/// - help：32条命令的帮助信息
+/// - dump：500行输出，超过发送队列大小
+/// 分别在UECLI_01_TX_RING为0和1时编译运行以对比，结果以JSON格式输出到stdout。只支持POSIX平台
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "uecli.h"
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define LINK_BAUD           (115200)    // 模拟链路波特率
+#define LINK_CALL_NS        (1000000)   // 每次写入调用的固定延迟
+#define LINK_BYTE_NS        (10 * 1000000000ull / LINK_BAUD)    // 每字节发送时间 8N1
+
+// ********************************************************************************************
+// 内部变量
+
+// 模拟链路
+static struct
+{
+    pthread_mutex_t lock;
+    uint64_t freetime;          // 链路空闲的时间
+    uint32_t calls;             // 写入调用次数
+    uint32_t bytes;             // 发送字节数
+}link = { PTHREAD_MUTEX_INITIALIZER, 0, 0, 0 };
+
+#if UECLI_01_TX_RING>0
+// 发送线程同步
+static pthread_mutex_t txlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t txkick = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t txdone = PTHREAD_COND_INITIALIZER;
+static bool kicked = false;
+static bool txbusy = false;
+#endif
+
+// ********************************************************************************************
+// 模拟链路
+
+uint64_t uecli_port_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 阻塞写入 直到数据全部发送完成
+static void LinkWrite(uint32_t num)
+{
+    uint64_t now = uecli_port_time_ns();
+
+    pthread_mutex_lock(&link.lock);
+    uint64_t start = link.freetime > now ? link.freetime : now;
+    uint64_t done = start + LINK_CALL_NS + num * LINK_BYTE_NS;
+    link.freetime = done;
+    ++link.calls;
+    link.bytes += num;
+    pthread_mutex_unlock(&link.lock);
+
+    struct timespec ts;
+    ts.tv_sec = (time_t)(done / 1000000000ull);
+    ts.tv_nsec = (long)(done % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL));
+}
+
+bool uecli_port_init(void)
+{
+    return true;
+}
+
+void uecli_port_out(const void* buff, uint32_t num)
+{
+    LinkWrite(num);
+    (void)buff;
+}
+
+void eputchar(char chr)
+{
+    uecli_port_out(&chr, 1);
+}
+
+#if UECLI_01_TX_RING>0
+// 发送线程 每次发送队列中连续的一段
+static void* TxThread(void* arg)
+{
+    const char* pbuff;
+    uint32_t num;
+
+    pthread_mutex_lock(&txlock);
+    for (;;)
+    {
+        while (!kicked)
+            pthread_cond_wait(&txkick, &txlock);
+        kicked = false;
+        txbusy = true;
+        pthread_mutex_unlock(&txlock);
+
+        while ((num = uecli_TxPeek(&pbuff)) > 0)
+        {
+            LinkWrite(num);
+            uecli_TxConsume(num);
+            pthread_mutex_lock(&txlock);
+            pthread_cond_broadcast(&txdone);
+            pthread_mutex_unlock(&txlock);
+        }
+
+        pthread_mutex_lock(&txlock);
+        txbusy = false;
+        pthread_cond_broadcast(&txdone);
+    }
+    (void)arg;
+    return NULL;
+}
+
+void uecli_port_tx_kick(void)
+{
+    pthread_mutex_lock(&txlock);
+    kicked = true;
+    pthread_cond_signal(&txkick);
+    pthread_mutex_unlock(&txlock);
+}
+
+void uecli_port_tx_wait(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 10000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_nsec -= 1000000000;
+        ++ts.tv_sec;
+    }
+    pthread_mutex_lock(&txlock);
+    pthread_cond_timedwait(&txdone, &txlock, &ts);
+    pthread_mutex_unlock(&txlock);
+}
+#endif
+
+// 等待链路上的数据全部发送完成
+static void WaitLinkIdle(void)
+{
+#if UECLI_01_TX_RING>0
+    pthread_mutex_lock(&txlock);
+    while (txbusy || kicked || uecli_TxPending())
+        pthread_cond_wait(&txdone, &txlock);
+    pthread_mutex_unlock(&txlock);
+#endif
+}
+
+// ********************************************************************************************
+// 测试命令
+
+static void nopfun(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+}
+
+static void dumpfun(int argc, char** argv)
+{
+    char buff[64];
+
+    for (int i = 0; i < 500; ++i)
+    {
+        esnprintf(buff, sizeof(buff), "line %d 0123456789abcdef\r\n", i);
+        uecli_PrintString(buff);
+    }
+    (void)argc;
+    (void)argv;
+}
+
+static const uecli_MenuItem handtalbe[] =
+{
+    UECLI_DECLARE_COMMAND(dumpfun, "dump", "输出500行数据"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd00", "测试命令00 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd01", "测试命令01 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd02", "测试命令02 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd03", "测试命令03 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd04", "测试命令04 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd05", "测试命令05 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd06", "测试命令06 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd07", "测试命令07 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd08", "测试命令08 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd09", "测试命令09 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd10", "测试命令10 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd11", "测试命令11 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd12", "测试命令12 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd13", "测试命令13 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd14", "测试命令14 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd15", "测试命令15 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd16", "测试命令16 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd17", "测试命令17 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd18", "测试命令18 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd19", "测试命令19 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd20", "测试命令20 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd21", "测试命令21 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd22", "测试命令22 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd23", "测试命令23 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd24", "测试命令24 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd25", "测试命令25 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd26", "测试命令26 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd27", "测试命令27 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd28", "测试命令28 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd29", "测试命令29 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd30", "测试命令30 用于生成帮助信息"),
+    UECLI_DECLARE_COMMAND(nopfun, "cmd31", "测试命令31 用于生成帮助信息"),
+    UECLI_DECLARE_END()
+};
+
+// ********************************************************************************************
+// 测试项
+
+static bool firstresult = true;
+
+// 执行一项测试 输出命令执行时间和链路发送完成时间
+static void RunCase(const char* name, const char* input, bool typing)
+{
+    WaitLinkIdle();
+    uint32_t calls = link.calls;
+    uint32_t bytes = link.bytes;
+    uint64_t start = uecli_port_time_ns();
+
+    if (typing)
+    {
+        for (const char* p = input; *p; ++p)
+            uecli_ProcessRecChar(p, 1);
+    }
+    else
+        uecli_ProcessRecChar(input, (int)strlen(input));
+
+    uint64_t handler = uecli_port_time_ns() - start;
+    WaitLinkIdle();
+    uint64_t drain = (link.freetime > start ? link.freetime : uecli_port_time_ns()) - start;
+
+    printf("%s  {\"name\":\"%s\",\"bytes\":%u,\"link_calls\":%u,\"handler_ms\":%.3f,\"drain_ms\":%.3f}",
+        firstresult ? "" : ",\n", name, link.bytes - bytes, link.calls - calls, handler / 1e6, drain / 1e6);
+    firstresult = false;
+}
+
+int main(void)
+{
+#if UECLI_01_TX_RING>0
+    pthread_t thread;
+    pthread_create(&thread, NULL, TxThread, NULL);
+#endif
+    uecli_Initialize(handtalbe);
+
+    printf("{\"tx_ring\":%d,\"baud\":%d,\"call_ns\":%d,\"results\":[\n", UECLI_01_TX_RING, LINK_BAUD, LINK_CALL_NS);
+    RunCase("echo", "abcdefghijklmnopqrstuvwx", true);
+    uecli_ProcessRecChar("\r", 1);
+    RunCase("help", "help\r", false);
+    RunCase("dump", "dump\r", false);
+    printf("\n]}\n");
+    return 0;
+}
@@ -0,0 +1,698 @@
+﻿/// \file uecli_bench.c
+/// \brief 输入到输出热路径的性能测试
+///
+/// \details
+/// 使用内存回环端口(uecli_port_out写入内存缓存)测试以下项目：
+/// - uecli_ProcessRecChar在逐字输入和整块粘贴时的吞吐量
+/// - 不同命令表大小和子菜单深度下的命令分派延迟
+/// - 命令补全延迟
+/// - 长参数列表的分割吞吐量 与之前不处理转义的分割函数对比
+/// - esnprintf与libc snprintf的对比
+/// - 结构化输出模式下每秒处理的命令记录数量(UECLI_01_JSON)
+/// 每项同时记录每次操作输出的字节数，结果以JSON格式输出到stdout。
+/// 打开UECLI_01_JSON时先检查结构化输出中的文本(含GBK编码的内置提示)是否为有效的UTF-8，检查失败时返回1
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "uecli.h"
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define BENCH_MAX_COMMANDS  (512)   // 测试命令表最大命令数量
+#define BENCH_MAX_DEPTH     (UECLI_CFG_STACK_COUNT - 1)  // 测试子菜单最大深度
+#define BENCH_NAME_LEN      (12)    // 测试命令名长度
+#define BENCH_REPEAT        (5)     // 每项重复次数 取最快的一次
+#define BENCH_OUT_BUFFSIZE  (65536) // 回环端口缓存大小 必须为2的幂
+#define BENCH_SPLIT_ARGS    (256)   // 分割测试参数表大小
+#define BENCH_SPLIT_LEN     (8192)  // 分割测试命令行最大长度
+
+// ********************************************************************************************
+// 内部变量
+
+// 回环端口
+static struct
+{
+    char buff[BENCH_OUT_BUFFSIZE];  // 输出数据 循环覆盖
+    uint64_t bytes;                 // 输出字节总数
+}loopback;
+
+// 测试命令表 每级子菜单一个命令表，最后一项为结束标记
+static uecli_MenuItem cmdtable[BENCH_MAX_DEPTH + 1][BENCH_MAX_COMMANDS + 2];
+static char cmdname[BENCH_MAX_COMMANDS][BENCH_NAME_LEN];
+
+// 防止测试结果被优化掉
+static volatile uint32_t sink;
+static bool firstresult = true;
+
+// ********************************************************************************************
+// 回环端口接口
+
+bool uecli_port_init(void)
+{
+    return true;
+}
+
+void uecli_port_out(const void* buff, uint32_t num)
+{
+    uint32_t pos = (uint32_t)loopback.bytes & (BENCH_OUT_BUFFSIZE - 1);
+    if (num > BENCH_OUT_BUFFSIZE - pos)
+        num = BENCH_OUT_BUFFSIZE - pos;
+    memcpy(&loopback.buff[pos], buff, num);
+    loopback.bytes += num;
+}
+
+// estring中eprintf的字符输出接口
+void eputchar(char chr)
+{
+    uecli_port_out(&chr, 1);
+}
+
+uint64_t uecli_port_time_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000ull +
+        (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000ull / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// 打开重定向时需要的文件接口由uecli_file.c提供
+
+// ********************************************************************************************
+// 测试命令
+
+// 空命令 只统计参数
+static void Cmd_Nop(int argc, char* argv[])
+{
+    sink += (uint32_t)argc;
+    (void)argv;
+}
+
+// 生成测试命令表 depth级子菜单，每级num个命令
+static void BuildTables(int num, int depth)
+{
+    memset(cmdtable, 0, sizeof(cmdtable));
+    for (int i = 0; i < num; ++i)
+        snprintf(cmdname[i], BENCH_NAME_LEN, "cmd%04d", i);
+
+    for (int level = 0; level <= depth; ++level)
+    {
+        uecli_MenuItem* pitem = cmdtable[level];
+        if (level < depth)
+        {
+            pitem->pdata = cmdtable[level + 1];
+            pitem->itemType = UECLI_TYPE_SUBMENU;
+            pitem->exename = "sub";
+            pitem->desc = "submenu";
+            ++pitem;
+        }
+        for (int i = 0; i < num; ++i, ++pitem)
+        {
+            pitem->pdata = (const void*)Cmd_Nop;
+            pitem->itemType = UECLI_TYPE_FUN;
+            pitem->exename = cmdname[i];
+            pitem->desc = "bench command";
+        }
+    }
+}
+
+// 使用测试命令表初始化 并进入depth级子菜单
+static void InitCli(int num, int depth)
+{
+    BuildTables(num, depth);
+    uecli_Initialize(cmdtable[0]);
+    for (int i = 0; i < depth; ++i)
+        uecli_ExeCmdine("sub");
+}
+
+// ********************************************************************************************
+// 结果输出
+
+// 输出一项测试结果
+static void Report(const char* name, const char* param, uint32_t ops, uint64_t ns,
+    uint64_t outbytes, uint64_t inbytes)
+{
+    double nsop = (double)ns / ops;
+
+    printf("%s    {\"name\":\"%s\",\"param\":\"%s\",\"ops\":%u,\"ns_per_op\":%.1f,"
+        "\"ops_per_s\":%.0f,\"out_bytes_per_op\":%.1f",
+        firstresult ? "" : ",\n", name, param, ops, nsop,
+        ns ? 1e9 * ops / ns : 0.0, (double)outbytes / ops);
+    if (inbytes)
+        printf(",\"in_bytes_per_s\":%.0f", ns ? 1e9 * inbytes / ns : 0.0);
+    printf("}");
+    firstresult = false;
+}
+
+// ********************************************************************************************
+// 测试项目
+
+// 输入处理吞吐量 chunk为每次调用uecli_ProcessRecChar的字节数，0表示整块一次输入
+static void BenchProcess(const char* name, int chunk, uint32_t lines)
+{
+    static char input[1 << 20];
+    const char* line = "cmd0007 arg1 arg2 arg3\r";
+    uint32_t linelen = (uint32_t)strlen(line);
+    uint32_t len = 0;
+
+    if (lines * linelen > sizeof(input))
+        lines = sizeof(input) / linelen;
+    for (uint32_t i = 0; i < lines; ++i, len += linelen)
+        memcpy(&input[len], line, linelen);
+
+    uint64_t best = UINT64_MAX, outbytes = 0;
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        InitCli(8, 0);
+        uint64_t startbytes = loopback.bytes;
+        uint64_t start = uecli_port_time_ns();
+        if (chunk)
+        {
+            for (uint32_t i = 0; i < len; i += chunk)
+                uecli_ProcessRecChar(&input[i], (int)(len - i < (uint32_t)chunk ? len - i : (uint32_t)chunk));
+        }
+        else
+            uecli_ProcessRecChar(input, (int)len);
+        uint64_t ns = uecli_port_time_ns() - start;
+        if (ns < best)
+        {
+            best = ns;
+            outbytes = loopback.bytes - startbytes;
+        }
+    }
+
+    char param[32];
+    snprintf(param, sizeof(param), "chunk=%d", chunk ? chunk : (int)len);
+    Report(name, param, lines, best, outbytes, len);
+}
+
+#if UECLI_01_JSON>0
+// 结构化输出模式下的记录吞吐量 整块输入多行命令，每行输出一条记录
+static void BenchRecords(uecli_Format format, const char* line, uint32_t lines)
+{
+    static char input[1 << 20];
+    uint32_t linelen = (uint32_t)strlen(line);
+    uint32_t len = 0;
+
+    if (lines * linelen > sizeof(input))
+        lines = sizeof(input) / linelen;
+    for (uint32_t i = 0; i < lines; ++i, len += linelen)
+        memcpy(&input[len], line, linelen);
+
+    uint64_t best = UINT64_MAX, outbytes = 0;
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        InitCli(8, 0);
+        uecli_SetFormat(format);
+        uint64_t startbytes = loopback.bytes;
+        uint64_t start = uecli_port_time_ns();
+        uecli_ProcessRecChar(input, (int)len);
+        uint64_t ns = uecli_port_time_ns() - start;
+        if (ns < best)
+        {
+            best = ns;
+            outbytes = loopback.bytes - startbytes;
+        }
+    }
+
+    char param[48];
+    snprintf(param, sizeof(param), "format=%s,line=%.*s", UECLI_FORMAT_CBOR == format ? "cbor" : "json",
+        (int)linelen - 1, line);
+    Report("records", param, lines, best, outbytes, len);
+}
+#endif
+
+#if UECLI_01_JSON>0
+// 检查数据是否为有效的UTF-8
+static bool IsUtf8(const uint8_t* str, uint64_t len)
+{
+    for (uint64_t i = 0; i < len; )
+    {
+        uint8_t c = str[i++];
+        uint8_t lo = 0x80, hi = 0xbf;
+        int num;
+
+        if (c < 0x80)
+            continue;
+        if (c < 0xc2 || c > 0xf4)
+            return false;
+        num = c < 0xe0 ? 1 : (c < 0xf0 ? 2 : 3);
+        if (0xe0 == c)
+            lo = 0xa0;
+        else if (0xed == c)
+            hi = 0x9f;
+        else if (0xf0 == c)
+            lo = 0x90;
+        else if (0xf4 == c)
+            hi = 0x8f;
+        for (; num; --num, ++i, lo = 0x80, hi = 0xbf)
+        {
+            if (i >= len || str[i] < lo || str[i] > hi)
+                return false;
+        }
+    }
+    return true;
+}
+
+// 检查一个CBOR数据项中的文本是否为有效的UTF-8 返回数据项之后的位置，无效返回0
+static uint64_t CheckCborItem(const uint8_t* data, uint64_t len, uint64_t pos)
+{
+    if (pos >= len)
+        return 0;
+
+    uint8_t major = data[pos] >> 5;
+    uint8_t info = data[pos++] & 31;
+    uint64_t value = info;
+
+    // 不定长度的文本只能由同类型的定长文本组成，每一段都必须是有效的UTF-8
+    if (31 == info)
+    {
+        if (major < 2 || major > 5)
+            return 0;
+        while (pos < len && 0xff != data[pos])
+        {
+            if ((major <= 3 && data[pos] >> 5 != major) || 0 == (pos = CheckCborItem(data, len, pos)))
+                return 0;
+        }
+        return pos < len ? pos + 1 : 0;
+    }
+    if (info >= 24)
+    {
+        if (info > 27 || pos + (1u << (info - 24)) > len)
+            return 0;
+        for (value = 0; info-- >= 24; )
+            value = (value << 8) | data[pos++];
+    }
+
+    switch (major)
+    {
+    case 2:
+    case 3:
+        if (value > len - pos || (3 == major && !IsUtf8(&data[pos], value)))
+            return 0;
+        return pos + value;
+    case 5:
+        value *= 2;
+        /* fall through */
+    case 4:
+        for (; value && pos; --value)
+            pos = CheckCborItem(data, len, pos);
+        return pos;
+    case 6:
+        return CheckCborItem(data, len, pos);
+    default:
+        return pos;
+    }
+}
+
+// 内存写入器输出
+static void CheckJsonOut(void* ctx, const char* buff, uint32_t num)
+{
+    uecli_port_out(buff, num);
+    (void)ctx;
+}
+
+// 检查结构化输出的文本是否为有效的UTF-8
+//
+// help和无效命令的提示来自以GBK编码保存的核心源文件，另外将一个UTF-8字符逐字节分段写入
+static bool CheckRecords(uecli_Format format)
+{
+    static const char text[] = "\xe4\xb8\xad\xd6\xd0 ok\r\n";
+    bool cbor = UECLI_FORMAT_CBOR == format;
+    uecli_Json js;
+
+    InitCli(8, 0);
+    uecli_SetFormat(format);
+    loopback.bytes = 0;
+    uecli_ProcessRecChar("help\nnosuch\n", 12);
+    uecli_SetFormat(UECLI_FORMAT_TEXT);
+
+    uecli_JsonInit(&js, cbor, CheckJsonOut, NULL);
+    uecli_JsonArrayBegin(&js, NULL);
+    for (uint32_t i = 0; i + 1 < sizeof(text); ++i)
+        uecli_JsonText(&js, &text[i], 1);
+    uecli_JsonArrayEnd(&js);
+    uecli_JsonFlush(&js);
+
+    const uint8_t* data = (const uint8_t*)loopback.buff;
+    uint64_t len = loopback.bytes;
+    bool valid = len < BENCH_OUT_BUFFSIZE;
+    if (cbor)
+    {
+        for (uint64_t pos = 0; valid && pos < len; )
+            valid = 0 != (pos = CheckCborItem(data, len, pos));
+    }
+    else
+        valid = valid && IsUtf8(data, len);
+    if (!valid)
+        fprintf(stderr, "%s output is not valid UTF-8\n", cbor ? "cbor" : "json");
+    return valid;
+}
+#endif
+
+#if UECLI_01_IN_HOOK>0
+// 捕获数据处理 只累加数据长度
+static uint32_t CaptureSink(void* ctx, const char* buff, uint32_t num)
+{
+    sink += num + (uint8_t)buff[num - 1];
+    (void)ctx;
+    return num;
+}
+
+// 输入捕获吞吐量 每次以chunk字节调用uecli_ProcessInput，escape为结束序列
+static void BenchCapture(int chunk, const char* escape)
+{
+    static char input[1 << 20];
+    uint32_t len = sizeof(input);
+
+    for (uint32_t i = 0; i < len; ++i)
+        input[i] = (char)(' ' + i % 64);
+
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        uecli_Capture capture = {CaptureSink, NULL, NULL, escape, 0, 0};
+        InitCli(8, 0);
+        uecli_CaptureStart(&capture);
+        uint64_t start = uecli_port_time_ns();
+        for (uint32_t i = 0; i < len; i += chunk)
+            uecli_ProcessInput(&input[i], chunk);
+        uint64_t ns = uecli_port_time_ns() - start;
+        uecli_CaptureStop();
+        if (ns < best)
+            best = ns;
+    }
+
+    char param[32];
+    snprintf(param, sizeof(param), "chunk=%d,escape=%d", chunk, escape ? (int)strlen(escape) : 0);
+    Report("capture", param, len / chunk, best, 0, len);
+}
+#endif
+
+// 命令分派延迟 执行命令表最后一个命令
+static void BenchDispatch(int num, int depth, uint32_t ops)
+{
+    uint64_t best = UINT64_MAX, outbytes = 0;
+    const char* cmdline = NULL;
+
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        InitCli(num, depth);
+        cmdline = cmdname[num - 1];
+        uint64_t startbytes = loopback.bytes;
+        uint64_t start = uecli_port_time_ns();
+        for (uint32_t i = 0; i < ops; ++i)
+            uecli_ExeCmdine(cmdline);
+        uint64_t ns = uecli_port_time_ns() - start;
+        if (ns < best)
+        {
+            best = ns;
+            outbytes = loopback.bytes - startbytes;
+        }
+    }
+
+    char param[32];
+    snprintf(param, sizeof(param), "commands=%d,depth=%d", num, depth);
+    Report("dispatch", param, ops, best, outbytes, 0);
+}
+
+// 命令补全延迟 一次操作包括输入前缀、TAB和退格清除
+static void BenchComplete(int num, const char* prefix, uint32_t ops)
+{
+    char input[UECLI_CFG_STR_MAXLEN * 2 + 2];
+    uint64_t best = UINT64_MAX, outbytes = 0;
+    int len = (int)strlen(prefix);
+
+    // 补全后的命令行最长为命令名长度
+    int n = 0;
+    for (; n < len; ++n)
+        input[n] = prefix[n];
+    input[n++] = '\t';
+    for (int i = 0; i < BENCH_NAME_LEN && n < (int)sizeof(input); ++i)
+        input[n++] = '\b';
+
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        InitCli(num, 0);
+        uint64_t startbytes = loopback.bytes;
+        uint64_t start = uecli_port_time_ns();
+        for (uint32_t i = 0; i < ops; ++i)
+            uecli_ProcessRecChar(input, n);
+        uint64_t ns = uecli_port_time_ns() - start;
+        if (ns < best)
+        {
+            best = ns;
+            outbytes = loopback.bytes - startbytes;
+        }
+    }
+
+    char param[48];
+    snprintf(param, sizeof(param), "commands=%d,prefix=%s", num, prefix);
+    Report("complete", param, ops, best, outbytes, 0);
+}
+
+// 之前的参数分割函数 只处理以双引号开头的参数，不处理转义，用于对比
+static char* LegacyGetNextDelim(char* instring, char** pstr)
+{
+    for (; ' ' == *instring || '\t' == *instring || '\r' == *instring; ++instring);
+
+    char c = *instring;
+    bool quotemask = false;
+
+    if ('"' == c)
+    {
+        c = *(++instring);
+        quotemask = true;
+    }
+    if ('\0' == c)
+        return NULL;
+
+    for (*pstr = instring; ; ++instring)
+    {
+        if ('\0' == (c = *instring))
+            return instring;
+        else if (quotemask && '"' == c)
+            break;
+        else if (!quotemask && (' ' == c || '\t' == c || '\r' == c))
+            break;
+    }
+
+    *instring = '\0';
+    return instring + 1;
+}
+
+static int LegacySplitString(char* str, char* substr[], int size)
+{
+    int i = 0;
+    for (; i < size; ++substr)
+    {
+        if (NULL == (str = LegacyGetNextDelim(str, substr)))
+            break;
+        ++i;
+    }
+    return i;
+}
+
+typedef int(*SplitFun)(char* str, char* argv[], int size);
+
+// 参数分割吞吐量 每次操作先把命令行拷贝到工作缓存再分割，两种函数的拷贝开销相同
+static void BenchSplit(const char* param, const char* line, SplitFun pfun, const char* name, uint32_t ops)
+{
+    static char work[BENCH_SPLIT_LEN];
+    char* argv[BENCH_SPLIT_ARGS];
+    uint32_t len = (uint32_t)strlen(line) + 1;
+    uint64_t best = UINT64_MAX;
+
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        uint64_t start = uecli_port_time_ns();
+        for (uint32_t i = 0; i < ops; ++i)
+        {
+            memcpy(work, line, len);
+            int argc = pfun(work, argv, BENCH_SPLIT_ARGS);
+            sink += (uint32_t)argc + (uint8_t)argv[argc - 1][0];
+        }
+        uint64_t ns = uecli_port_time_ns() - start;
+        if (ns < best)
+            best = ns;
+    }
+    Report(name, param, ops, best, 0, (uint64_t)ops * (len - 1));
+}
+
+// 生成分割测试命令行 kind为0时全部为普通参数，1时一半参数带引号或转义，2时为一个长十六进制参数
+static const char* BuildSplitLine(int kind, int args)
+{
+    static char line[BENCH_SPLIT_LEN];
+    int len = snprintf(line, sizeof(line), "cmd0007");
+
+    if (2 == kind)
+    {
+        len += snprintf(&line[len], sizeof(line) - len, " 0x1000 ");
+        for (int i = 0; i < args && len < (int)sizeof(line) - 1; ++i)
+            line[len++] = "0123456789abcdef"[i & 15];
+        line[len] = '\0';
+        return line;
+    }
+    for (int i = 0; i < args && len < (int)sizeof(line) - 16; ++i)
+    {
+        if (1 == kind && (i & 1))
+            len += snprintf(&line[len], sizeof(line) - len, (i & 2) ? " \"val %03d\"" : " val\\ %03d", i);
+        else
+            len += snprintf(&line[len], sizeof(line) - len, " arg%03d", i);
+    }
+    return line;
+}
+
+// 格式化测试函数
+typedef void(*FormatFun)(char* buff, uint32_t size, int i);
+
+static void FormatEsnprintfInt(char* buff, uint32_t size, int i)
+{
+    esnprintf(buff, size, "%d", i);
+}
+static void FormatSnprintfInt(char* buff, uint32_t size, int i)
+{
+    snprintf(buff, size, "%d", i);
+}
+static void FormatEsnprintfHelp(char* buff, uint32_t size, int i)
+{
+    esnprintf(buff, size, "%-16s%s", "command", i & 1 ? "description" : "desc");
+}
+static void FormatSnprintfHelp(char* buff, uint32_t size, int i)
+{
+    snprintf(buff, size, "%-16s%s", "command", i & 1 ? "description" : "desc");
+}
+static void FormatEsnprintfMixed(char* buff, uint32_t size, int i)
+{
+    esnprintf(buff, size, "%s = %d (0x%08X)", "value", i, (uint32_t)i);
+}
+static void FormatSnprintfMixed(char* buff, uint32_t size, int i)
+{
+    snprintf(buff, size, "%s = %d (0x%08X)", "value", i, (uint32_t)i);
+}
+
+// 格式化输出对比
+static void BenchFormat(const char* name, const char* param, FormatFun pfun, uint32_t ops)
+{
+    char buff[UECLI_CFG_TEMP_MAXLEN];
+    uint64_t best = UINT64_MAX;
+
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+        uint64_t start = uecli_port_time_ns();
+        for (uint32_t i = 0; i < ops; ++i)
+        {
+            pfun(buff, sizeof(buff), (int)i);
+            sink += (uint8_t)buff[0];
+        }
+        uint64_t ns = uecli_port_time_ns() - start;
+        if (ns < best)
+            best = ns;
+    }
+    Report(name, param, ops, best, 0, 0);
+}
+
+// ********************************************************************************************
+// 主函数
+
+int main(int argc, char* argv[])
+{
+    // 参数为迭代次数缩放倍数 默认为1
+    uint32_t scale = argc > 1 ? (uint32_t)atoi(argv[1]) : 1;
+    if (!scale)
+        scale = 1;
+
+    printf("{\n  \"suite\":\"uecli\",\n");
+    printf("  \"config\":{\"str_maxlen\":%d,\"max_argnum\":%d,\"history\":%d,\"complete\":%d,"
+        "\"submenu\":%d,\"pipe\":%d,\"stats\":%d,\"trace\":%d},\n",
+        UECLI_CFG_STR_MAXLEN, UECLI_CFG_MAX_ARGNUM, UECLI_01_HISTORY, UECLI_01_COMPLETE,
+        UECLI_01_SUBMENU, UECLI_01_PIPE, UECLI_01_STATS, UECLI_01_TRACE);
+
+    // 结构化输出的文本检查
+    bool check = true;
+#if UECLI_01_JSON>0
+    check = CheckRecords(UECLI_FORMAT_JSON) && CheckRecords(UECLI_FORMAT_CBOR);
+#endif
+    printf("  \"check\":%s,\n", check ? "true" : "false");
+    printf("  \"results\":[\n");
+
+    // 输入处理吞吐量
+    BenchProcess("process_typing", 1, 20000 * scale);
+    BenchProcess("process_paste", 0, 20000 * scale);
+
+    // 命令表大小和子菜单深度
+    BenchDispatch(8, 0, 100000 * scale);
+    BenchDispatch(64, 0, 100000 * scale);
+    BenchDispatch(BENCH_MAX_COMMANDS, 0, 20000 * scale);
+    BenchDispatch(64, 1, 100000 * scale);
+    BenchDispatch(64, BENCH_MAX_DEPTH, 100000 * scale);
+
+    // 命令补全 唯一匹配和多项匹配
+    BenchComplete(64, "cmd0063", 20000 * scale);
+    BenchComplete(64, "cmd00", 20000 * scale);
+    BenchComplete(BENCH_MAX_COMMANDS, "cmd0", 5000 * scale);
+
+    // 长参数列表分割 split为当前的分割函数，split_legacy为之前的分割函数
+    BenchSplit("args=64", BuildSplitLine(0, 64), uecli_SplitString, "split", 100000 * scale);
+    BenchSplit("args=64", BuildSplitLine(0, 64), LegacySplitString, "split_legacy", 100000 * scale);
+    BenchSplit("args=200", BuildSplitLine(0, 200), uecli_SplitString, "split", 20000 * scale);
+    BenchSplit("args=200", BuildSplitLine(0, 200), LegacySplitString, "split_legacy", 20000 * scale);
+    BenchSplit("args=64,quoted", BuildSplitLine(1, 64), uecli_SplitString, "split", 100000 * scale);
+    BenchSplit("args=64,quoted", BuildSplitLine(1, 64), LegacySplitString, "split_legacy", 100000 * scale);
+    BenchSplit("hex=4096", BuildSplitLine(2, 4096), uecli_SplitString, "split", 20000 * scale);
+    BenchSplit("hex=4096", BuildSplitLine(2, 4096), LegacySplitString, "split_legacy", 20000 * scale);
+
+#if UECLI_01_IN_HOOK>0
+    // 输入捕获
+    BenchCapture(64, NULL);
+    BenchCapture(4096, NULL);
+    BenchCapture(4096, "\x1d");
+    BenchCapture(4096, "+++");
+#endif
+
+#if UECLI_01_JSON>0
+    // 结构化输出
+    BenchRecords(UECLI_FORMAT_JSON, "cmd0007 arg1\n", 20000 * scale);
+    BenchRecords(UECLI_FORMAT_CBOR, "cmd0007 arg1\n", 20000 * scale);
+    BenchRecords(UECLI_FORMAT_JSON, "help\n", 2000 * scale);
+    BenchRecords(UECLI_FORMAT_CBOR, "help\n", 2000 * scale);
+#endif
+
+    // 格式化输出
+    BenchFormat("esnprintf", "%d", FormatEsnprintfInt, 1000000 * scale);
+    BenchFormat("snprintf", "%d", FormatSnprintfInt, 1000000 * scale);
+    BenchFormat("esnprintf", "%-16s%s", FormatEsnprintfHelp, 1000000 * scale);
+    BenchFormat("snprintf", "%-16s%s", FormatSnprintfHelp, 1000000 * scale);
+    BenchFormat("esnprintf", "%s = %d (0x%08X)", FormatEsnprintfMixed, 1000000 * scale);
+    BenchFormat("snprintf", "%s = %d (0x%08X)", FormatSnprintfMixed, 1000000 * scale);
+
+    printf("\n  ]\n}\n");
+    return check ? 0 : 1;
+}
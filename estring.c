@@ -12,6 +12,7 @@ estring是嵌入式安全字符串操作函数库
 @修订说明:
 
 2016.08.02	初始版本
+2017.07.28	estrlen等核心函数增加按字和SSE2/AVX2实现
 
 ***********************************************************************************************/
 
@@ -21,6 +22,415 @@ estring是嵌入式安全字符串操作函数库
 static const char UCode[] = "0123456789ABCDEFX";
 static const char LCode[] = "0123456789abcdefx";
 
+/*----------------------------------------快速实现----------------------------------------------*/
+
+// estrlen estrnlen estrchr estrcmpNocase estrncpy eStrSplit在编译时选择实现:
+// x86平台启用SSE2时(-mavx2时为AVX2)使用向量实现，其他32/64位平台使用按字(SWAR)实现，
+// 定义ESTR_NO_SIMD时不使用向量实现，同时定义ESTR_NO_SWAR时使用逐字节实现
+// 快速实现按对齐的块读取，或在读取前检查不跨越4K页边界，不会读取字符串所在页之外的内存
+#if !defined(ESTR_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ESTR_VECTOR_ENABLE
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif !defined(ESTR_NO_SWAR) && (UINTPTR_MAX >= 0xFFFFFFFFu)
+#define ESTR_SWAR_ENABLE
+#endif
+
+#if defined(ESTR_VECTOR_ENABLE) || defined(ESTR_SWAR_ENABLE)
+#define ESTR_FAST_ENABLE
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ESTR_INLINE static inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define ESTR_INLINE static __forceinline
+#else
+#define ESTR_INLINE static
+#endif
+
+// 按块读取时会读取同一块中字符串结束符之后的字节，这是安全的，但地址检查工具会报告越界
+#if defined(__SANITIZE_ADDRESS__)
+#define ESTR_NO_ASAN __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ESTR_NO_ASAN __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef ESTR_NO_ASAN
+#define ESTR_NO_ASAN
+#endif
+
+// 转换为小写 与逐字节实现的规则相同 只转换'A'-'Z'
+ESTR_INLINE char CharToLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+}
+// 忽略大小写比较在第一个不同字符或dst结束处的结果
+ESTR_INLINE int NocaseResult(char s, char d)
+{
+    int ret = '\0' == d ? s : CharToLower(s) - CharToLower(d);
+    return ret < 0 ? -1 : ret > 0;
+}
+#endif
+
+#if defined(ESTR_VECTOR_ENABLE)
+#if defined(__AVX2__)
+typedef __m256i EVector;
+#define EVEC_SIZE       32
+#define EVEC_FULL       0xFFFFFFFFu
+#define EVEC_LOAD(p)    _mm256_load_si256((const __m256i*)(p))
+#define EVEC_LOADU(p)   _mm256_loadu_si256((const __m256i*)(p))
+#define EVEC_SET(c)     _mm256_set1_epi8((char)(c))
+#define EVEC_EQ(a, b)   _mm256_cmpeq_epi8(a, b)
+#define EVEC_GT(a, b)   _mm256_cmpgt_epi8(a, b)
+#define EVEC_OR(a, b)   _mm256_or_si256(a, b)
+#define EVEC_AND(a, b)  _mm256_and_si256(a, b)
+#define EVEC_ADD(a, b)  _mm256_add_epi8(a, b)
+#define EVEC_MASK(v)    ((uint32_t)_mm256_movemask_epi8(v))
+#else
+typedef __m128i EVector;
+#define EVEC_SIZE       16
+#define EVEC_FULL       0xFFFFu
+#define EVEC_LOAD(p)    _mm_load_si128((const __m128i*)(p))
+#define EVEC_LOADU(p)   _mm_loadu_si128((const __m128i*)(p))
+#define EVEC_SET(c)     _mm_set1_epi8((char)(c))
+#define EVEC_EQ(a, b)   _mm_cmpeq_epi8(a, b)
+#define EVEC_GT(a, b)   _mm_cmpgt_epi8(a, b)
+#define EVEC_OR(a, b)   _mm_or_si128(a, b)
+#define EVEC_AND(a, b)  _mm_and_si128(a, b)
+#define EVEC_ADD(a, b)  _mm_add_epi8(a, b)
+#define EVEC_MASK(v)    ((uint32_t)_mm_movemask_epi8(v))
+#endif
+
+// 向下对齐到块
+#define EVEC_ALIGN(p)       ((const char*)((uintptr_t)(p) & ~(uintptr_t)(EVEC_SIZE - 1)))
+// 从p开始的非对齐块是否跨越4K页边界
+#define EVEC_CROSS_PAGE(p)  (((uintptr_t)(p) & 4095) > 4096 - EVEC_SIZE)
+
+// 最低的置位序号
+ESTR_INLINE unsigned int EFirstBit(uint32_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    unsigned int index = 0;
+    for (; !(mask & 1); mask >>= 1) ++index;
+    return index;
+#endif
+}
+// 将'A'-'Z'转换为小写 有符号比较 大于0x7F的字符不变
+ESTR_INLINE EVector EVecToLower(EVector v)
+{
+    EVector upper = EVEC_AND(EVEC_GT(v, EVEC_SET('A' - 1)), EVEC_GT(EVEC_SET('Z' + 1), v));
+    return EVEC_ADD(v, EVEC_AND(upper, EVEC_SET(32)));
+}
+
+// 字符串长度 最大为maxlen
+ESTR_NO_ASAN static unsigned int FastStrnlen(const char* str, unsigned int maxlen)
+{
+    const EVector zero = EVEC_SET(0);
+    const char* p = EVEC_ALIGN(str);
+    uint32_t mask = EVEC_MASK(EVEC_EQ(EVEC_LOAD(p), zero)) >> (str - p);
+    unsigned int len;
+
+    if (mask)
+        len = EFirstBit(mask);
+    else
+    {
+        for (;;)
+        {
+            p += EVEC_SIZE;
+            if ((unsigned int)(p - str) >= maxlen)
+                return maxlen;
+            if (0 != (mask = EVEC_MASK(EVEC_EQ(EVEC_LOAD(p), zero))))
+                break;
+        }
+        len = (unsigned int)(p - str) + EFirstBit(mask);
+    }
+    return len < maxlen ? len : maxlen;
+}
+// 搜索字符或结束符
+ESTR_NO_ASAN static char* FastStrchr(const char* str, char chr)
+{
+    const EVector zero = EVEC_SET(0), target = EVEC_SET(chr);
+    const char* p = EVEC_ALIGN(str);
+    EVector v = EVEC_LOAD(p);
+    uint32_t mask = EVEC_MASK(EVEC_OR(EVEC_EQ(v, zero), EVEC_EQ(v, target))) >> (str - p);
+
+    if (mask)
+        p = str + EFirstBit(mask);
+    else
+    {
+        do
+        {
+            p += EVEC_SIZE;
+            v = EVEC_LOAD(p);
+        } while (!(mask = EVEC_MASK(EVEC_OR(EVEC_EQ(v, zero), EVEC_EQ(v, target)))));
+        p += EFirstBit(mask);
+    }
+    //找到的是结束符时返回0 搜索'\0'时同样返回0
+    return '\0' != *p ? (char*)p : 0;
+}
+// 忽略大小写比较 两个字符串的对齐方式不同 使用非对齐读取
+ESTR_NO_ASAN static int FastCmpNocase(const char* src, const char* dst)
+{
+    const EVector zero = EVEC_SET(0);
+    unsigned int i;
+    uint32_t mask;
+
+    for (;;)
+    {
+        //接近页边界时逐字节比较一个块的长度
+        if (EVEC_CROSS_PAGE(src) || EVEC_CROSS_PAGE(dst))
+        {
+            for (i = EVEC_SIZE; i; --i, ++src, ++dst)
+            {
+                if ('\0' == *dst || CharToLower(*src) != CharToLower(*dst))
+                    return NocaseResult(*src, *dst);
+            }
+            continue;
+        }
+
+        EVector a = EVEC_LOADU(src), b = EVEC_LOADU(dst);
+        mask = (EVEC_MASK(EVEC_EQ(EVecToLower(a), EVecToLower(b))) ^ EVEC_FULL) | EVEC_MASK(EVEC_EQ(b, zero));
+        if (mask)
+        {
+            i = EFirstBit(mask);
+            return NocaseResult(src[i], dst[i]);
+        }
+        src += EVEC_SIZE;
+        dst += EVEC_SIZE;
+    }
+}
+// 分割字符串 每次处理一个块，由分隔符掩码得到子字符串的起始位置
+ESTR_NO_ASAN static unsigned int FastSplit(char* str, char separator, char* substr[], unsigned int size)
+{
+    const EVector zero = EVEC_SET(0), space = EVEC_SET(' '), sep = EVEC_SET(separator);
+    char* p = (char*)EVEC_ALIGN(str);
+    uint32_t valid = (EVEC_FULL << (str - p)) & EVEC_FULL;
+    uint32_t ischar = 0;    /* 上一块的最后一个字符为子字符串字符 */
+    unsigned int count = 0;
+
+    for (;; p += EVEC_SIZE, valid = EVEC_FULL)
+    {
+        EVector v = EVEC_LOAD(p);
+        uint32_t end = EVEC_MASK(EVEC_EQ(v, zero)) & valid;
+        uint32_t sepmask, ctrlmask, charmask, starts, mask;
+
+        //只处理结束符之前的字符
+        end &= 0u - end;
+        if (end)
+            valid &= end - 1;
+        sepmask = EVEC_MASK(EVEC_OR(EVEC_EQ(v, space), EVEC_EQ(v, sep))) & valid;
+        //有符号比较小于空白的字符包含控制字符和大于0x7F的字符
+        ctrlmask = EVEC_MASK(EVEC_GT(space, v)) & valid & ~sepmask;
+        charmask = valid & ~sepmask;
+        starts = charmask & ~((charmask << 1) | ischar);
+
+        //记录子字符串 数量达到上限时不再处理之后的字符
+        for (; starts; starts &= starts - 1)
+        {
+            unsigned int i = EFirstBit(starts);
+            substr[count++] = p + i;
+            ESTR_ASSERT(count < size);
+            if (count >= size)
+            {
+                end = 1;
+                valid &= (2u << i) - 1;
+                break;
+            }
+        }
+        //分隔符填充\0 控制字符转换为空白
+        for (mask = sepmask & valid; mask; mask &= mask - 1)
+            p[EFirstBit(mask)] = '\0';
+        for (mask = ctrlmask & valid; mask; mask &= mask - 1)
+            p[EFirstBit(mask)] = ' ';
+        if (end)
+            return count;
+        ischar = (charmask >> (EVEC_SIZE - 1)) & 1;
+    }
+}
+#elif defined(ESTR_SWAR_ENABLE)
+// 按字读取 may_alias避免违反严格别名规则
+#if defined(__GNUC__) || defined(__clang__)
+typedef uintptr_t __attribute__((__may_alias__)) EWord;
+#else
+typedef uintptr_t EWord;
+#endif
+#define EWORD_SIZE          sizeof(EWord)
+#define EWORD_ONES          ((EWord)-1 / 0xFF)
+#define EWORD_HIGHS         (EWORD_ONES << 7)
+#define EWORD_ALIGNED(p)    (!((uintptr_t)(p) & (EWORD_SIZE - 1)))
+// 支持非对齐访问的平台 memcpy编译为一次读取
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64) \
+    || defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_FEATURE_UNALIGNED)
+#define EWORD_UNALIGNED_ENABLE
+#endif
+// 含有0字节时非0
+#define EWORD_HASZERO(w)    (((w) - EWORD_ONES) & ~(w) & EWORD_HIGHS)
+// 含有小于n的字节时非0 n不大于0x80 不检测大于0x7F的字节
+#define EWORD_HASLESS(w, n) (((w) - EWORD_ONES * (n)) & ~(w) & EWORD_HIGHS)
+
+// 将'A'-'Z'转换为小写 各字节分别计算 不产生进位
+ESTR_INLINE EWord EWordToLower(EWord w)
+{
+    EWord low = w & ~EWORD_HIGHS;
+    EWord upper = (low + EWORD_ONES * (0x80 - 'A')) & ~(low + EWORD_ONES * (0x7F - 'Z')) & ~w & EWORD_HIGHS;
+    return w | (upper >> 2);
+}
+
+// 字符串长度 最大为maxlen
+ESTR_NO_ASAN static unsigned int FastStrnlen(const char* str, unsigned int maxlen)
+{
+    unsigned int len = 0;
+
+    //逐字节处理到字对齐
+    for (; !EWORD_ALIGNED(&str[len]); ++len)
+    {
+        if (len >= maxlen || '\0' == str[len])
+            return len;
+    }
+    //按字查找含有结束符的字 在字中逐字节查找
+    for (; len < maxlen && !EWORD_HASZERO(*(const EWord*)&str[len]); len += EWORD_SIZE);
+    for (; len < maxlen && '\0' != str[len]; ++len);
+    return len < maxlen ? len : maxlen;
+}
+// 搜索字符或结束符
+ESTR_NO_ASAN static char* FastStrchr(const char* str, char chr)
+{
+    const EWord target = EWORD_ONES * (uint8_t)chr;
+    EWord w;
+    char c;
+
+    for (; !EWORD_ALIGNED(str); ++str)
+    {
+        if ('\0' == (c = *str))
+            return 0;
+        if (c == chr)
+            return (char*)str;
+    }
+    for (;; str += EWORD_SIZE)
+    {
+        w = *(const EWord*)str;
+        if (EWORD_HASZERO(w) | EWORD_HASZERO(w ^ target))
+            break;
+    }
+    for (; '\0' != (c = *str); ++str)
+    {
+        if (c == chr)
+            return (char*)str;
+    }
+    return 0;
+}
+// 忽略大小写比较 dst按对齐的字读取，src对齐方式不同时在支持非对齐访问的平台上非对齐读取
+ESTR_NO_ASAN static int FastCmpNocase(const char* src, const char* dst)
+{
+    int aligned = !(((uintptr_t)src ^ (uintptr_t)dst) & (EWORD_SIZE - 1));
+    unsigned int i;
+    EWord a, b;
+
+#if !defined(EWORD_UNALIGNED_ENABLE)
+    if (aligned)
+#endif
+    {
+        for (; !EWORD_ALIGNED(dst); ++src, ++dst)
+        {
+            if ('\0' == *dst || CharToLower(*src) != CharToLower(*dst))
+                return NocaseResult(*src, *dst);
+        }
+        for (;;)
+        {
+            //非对齐读取跨越4K页边界时逐字节比较一个字的长度
+            if (!aligned && ((uintptr_t)src & 4095) > 4096 - EWORD_SIZE)
+            {
+                for (i = EWORD_SIZE; i; --i, ++src, ++dst)
+                {
+                    if ('\0' == *dst || CharToLower(*src) != CharToLower(*dst))
+                        return NocaseResult(*src, *dst);
+                }
+                continue;
+            }
+            if (aligned)
+                a = *(const EWord*)src;
+            else
+                memcpy(&a, src, EWORD_SIZE);
+            b = *(const EWord*)dst;
+            if (EWORD_HASZERO(b) || EWordToLower(a) != EWordToLower(b))
+                break;
+            src += EWORD_SIZE;
+            dst += EWORD_SIZE;
+        }
+    }
+    //逐字节比较剩余部分
+    for (; '\0' != *dst && CharToLower(*src) == CharToLower(*dst); ++src, ++dst);
+    return NocaseResult(*src, *dst);
+}
+// 分割字符串时需要逐字节处理的字符 空白、分隔符、结束符和控制字符
+ESTR_INLINE int IsSplitChar(char c, char separator)
+{
+    return ' ' == c || separator == c || c < ' ' || c > '\x7f';
+}
+// 跳过子字符串中的普通字符
+ESTR_NO_ASAN static char* SplitScan(char* str, char separator)
+{
+    const EWord space = EWORD_ONES * ' ', sep = EWORD_ONES * (uint8_t)separator;
+    EWord w;
+
+    for (; !EWORD_ALIGNED(str); ++str)
+    {
+        if (IsSplitChar(*str, separator))
+            return str;
+    }
+    for (;; str += EWORD_SIZE)
+    {
+        w = *(const EWord*)str;
+        if ((w & EWORD_HIGHS) | EWORD_HASZERO(w ^ space) | EWORD_HASZERO(w ^ sep) | EWORD_HASLESS(w, ' '))
+            break;
+    }
+    while (!IsSplitChar(*str, separator))
+        ++str;
+    return str;
+}
+// 分割字符串
+static unsigned int FastSplit(char* str, char separator, char* substr[], unsigned int size)
+{
+    unsigned int count = 0;
+    char ischar = 0;
+    register char c;
+
+    while ('\0' != (c = *str))
+    {
+        //分割字符
+        if (' ' == c || separator == c)
+        {
+            ischar = 0;
+            *str++ = '\0';
+            continue;
+        }
+        //将控制字符转换为空白 仍作为子字符串的一部分
+        if (c < ' ' || c > '\x7f')
+            *str = ' ';
+        //在由空格到字符的变化时记录为子字符串
+        if (!ischar)
+        {
+            ischar = 1;
+            substr[count++] = str;	/* 记录子字符串指针 */
+            ESTR_ASSERT(count < size);
+            if (count >= size) break;
+        }
+        //跳过后续的普通字符
+        str = SplitScan(str + 1, separator);
+    }
+    return count;
+}
+#endif
+
 /*----------------------------------------接口函数----------------------------------------------*/
 
 /******************************************************************************************
@@ -40,10 +450,27 @@ unsigned int estrncpy(char* dest, const char* source, unsigned int size)
 
     if (size)
     {
+#if defined(ESTR_FAST_ENABLE)
+        unsigned int len = 0, maxlen = size - 1;
+        //短字符串逐字节拷贝 避免查找长度和调用memcpy的开销
+        for (; len < 16; ++len)
+        {
+            if (len >= maxlen || '\0' == (dest[len] = source[len]))
+            {
+                dest[len] = '\0';
+                return len;
+            }
+        }
+        len += FastStrnlen(&source[len], maxlen - len);
+        memcpy(&dest[16], &source[16], len - 16);
+        dest[len] = '\0';
+        return len;
+#else
         register unsigned int i = size;
         for (; --i && '\0' != (*dest = *source); ++dest, ++source);
         *dest = '\0';
         return size - i - 1;
+#endif
     }
     return 0;
 }
@@ -58,9 +485,13 @@ unsigned int estrlen(const char* str)
     //参数断言
     ESTR_ASSERT(str);
 
+#if defined(ESTR_FAST_ENABLE)
+    return FastStrnlen(str, 0xFFFFFFFFu);
+#else
     const char* eos = str;
     while (*eos++);
     return (unsigned int)(eos - str - 1);
+#endif
 }
 /******************************************************************************************
 说明:			获取指定的字符串长度
@@ -74,10 +505,14 @@ unsigned int estrnlen(const char* str, unsigned int maxlen)
     //参数断言
     ESTR_ASSERT(str);
 
+#if defined(ESTR_FAST_ENABLE)
+    return FastStrnlen(str, maxlen);
+#else
     register unsigned int i = maxlen;
     for (; *str && i; --i, ++str);
 
     return (unsigned int)(maxlen - i);
+#endif
 }
 /******************************************************************************************
 说明:			将字符串安全的添加在指定字符串结尾
@@ -252,12 +687,15 @@ int estrcmpNocase(const char* src, const char* dst)
     ESTR_ASSERT(src);
     ESTR_ASSERT(dst);
 
-    char temp1, temp2;
-    int ret = 0;
-
     //判断指针是否相等
     if (src == dst) return 0;
 
+#if defined(ESTR_FAST_ENABLE)
+    return FastCmpNocase(src, dst);
+#else
+    char temp1, temp2;
+    int ret = 0;
+
     for (; temp2 = *src, '\0' != (temp1 = *dst); ++src, ++dst)
     {
         if (temp1 >= 'A' && temp1 <= 'Z')
@@ -276,6 +714,7 @@ int estrcmpNocase(const char* src, const char* dst)
     else if (ret > 0)
         ret = 1;
     return(ret);
+#endif
 }
 /******************************************************************************************
 说明:		使用指定的字符分割字符串
@@ -292,6 +731,9 @@ unsigned int eStrSplit(char* str, char separator, char* substr[], unsigned int s
     ESTR_ASSERT(str);
     ESTR_ASSERT(substr);
 
+#if defined(ESTR_FAST_ENABLE)
+    return FastSplit(str, separator, substr, size);
+#else
     unsigned int count = 0;
     register char c;
     char ischar = 0;		/* 字符标记 */
@@ -321,6 +763,7 @@ unsigned int eStrSplit(char* str, char separator, char* substr[], unsigned int s
         }
     }
     return count;
+#endif
 }
 /******************************************************************************************
 说明:			搜索字符第一次出现在字符串中的位置
@@ -333,6 +776,9 @@ char* estrchr(const char* str, char chr)
 {
     ESTR_ASSERT(str);
 
+#if defined(ESTR_FAST_ENABLE)
+    return FastStrchr(str, chr);
+#else
     char c;
     for (; '\0' != (c = *str); ++str)
     {
@@ -340,6 +786,67 @@ char* estrchr(const char* str, char chr)
             return (char *)str;
     }
 
+    return (0);
+#endif
+}
+/******************************************************************************************
+说明:			搜索子字符串第一次出现在字符串中的位置
+参数:
+// @str			待搜索的字符串
+// @substr		待搜索的子字符串
+返回值:	char*		查找到的位置指针 0表示为找到
+******************************************************************************************/
+char* estrstr(const char* str, const char* substr)
+{
+    ESTR_ASSERT(str);
+    ESTR_ASSERT(substr);
+
+    const char *s1, *s2;
+    for (; ; ++str)
+    {
+        //逐个字符比较子字符串
+        for (s1 = str, s2 = substr; '\0' != *s2 && *s1 == *s2; ++s1, ++s2);
+        if ('\0' == *s2)
+            return (char *)str;
+        if ('\0' == *str)
+            break;
+    }
+
+    return (0);
+}
+/******************************************************************************************
+说明:			忽略大小写搜索子字符串第一次出现在字符串中的位置
+参数:
+// @str			待搜索的字符串
+// @substr		待搜索的子字符串
+返回值:	char*		查找到的位置指针 0表示为找到
+******************************************************************************************/
+char* estrstrNocase(const char* str, const char* substr)
+{
+    ESTR_ASSERT(str);
+    ESTR_ASSERT(substr);
+
+    const char *s1, *s2;
+    char c1, c2;
+    for (; ; ++str)
+    {
+        //逐个字符忽略大小写比较子字符串
+        for (s1 = str, s2 = substr; '\0' != (c2 = *s2); ++s1, ++s2)
+        {
+            c1 = *s1;
+            if (c1 >= 'A' && c1 <= 'Z')
+                c1 += 32;
+            if (c2 >= 'A' && c2 <= 'Z')
+                c2 += 32;
+            if (c1 != c2)
+                break;
+        }
+        if ('\0' == c2)
+            return (char *)str;
+        if ('\0' == *str)
+            break;
+    }
+
     return (0);
 }
 /******************************************************************************************
@@ -599,26 +1106,35 @@ void efprintf(void(*pfun)(char), const char*fmt, ...)
 
 /*----------------------------------------标准打印----------------------------------------------*/
 
-static char* _buff_ptr;
-static uint32_t _buff_size = 0;
+//字符串缓冲区打印上下文 保存在调用者栈上，多线程同时调用互不影响
+typedef struct
+{
+    char* ptr;          /* 写入位置 */
+    uint32_t size;      /* 剩余空间 */
+}__e_snprintf_ctx;
+
+static void __e_vprintf(void(*pfun)(void*, char), void* ctx, const char*fmt, va_list arp);
 void eputchar(char chr);
 
 /******************************************************************************************
 说明:	字符串缓冲区字符打印函数
 
 参数:
+// @ctx			字符串缓冲区打印上下文
 // @chr			打印字符
 返回值:	void
 ******************************************************************************************/
-static void __e_snputchar_handle(char chr)
+static void __e_snputchar_handle(void* ctx, char chr)
 {
-    if (_buff_size > 1)
+    __e_snprintf_ctx* psn = (__e_snprintf_ctx*)ctx;
+
+    if (psn->size > 1)
     {
-        --_buff_size;		/* 最大计数 */
-        *_buff_ptr++ = chr;	/* 保存字符 */
+        --psn->size;		/* 最大计数 */
+        *psn->ptr++ = chr;	/* 保存字符 */
     }
     //字符串封尾
-    *_buff_ptr = '\0';
+    *psn->ptr = '\0';
 }
 /******************************************************************************************
 说明:	格式打印到缓冲区
@@ -633,17 +1149,33 @@ static void __e_snputchar_handle(char chr)
 void esnprintf(char* buff, uint32_t count, const char*fmt, ...)
 {
     va_list ap;
-    _buff_ptr = buff;
-    _buff_size = count;
+
+    va_start(ap, fmt);
+    evsnprintf(buff, count, fmt, ap);
+    va_end(ap);
+}
+/******************************************************************************************
+说明:	使用可变参数表格式打印到缓冲区
+参数:
+// @buff		缓冲区
+// @size		缓冲区大小
+// @fmt			格式化字符串
+// @arp			可变参数表
+返回值:	void
+******************************************************************************************/
+void evsnprintf(char* buff, uint32_t count, const char*fmt, va_list arp)
+{
+    __e_snprintf_ctx sn;
+    sn.ptr = buff;
+    sn.size = count;
 
     //参数断言
     ESTR_ASSERT(buff);
     ESTR_ASSERT(fmt);
     ESTR_ASSERT(count);
 
-    va_start(ap, fmt);
-    evprintf(__e_snputchar_handle, fmt, ap);
-    va_end(ap);
+    *buff = '\0';
+    __e_vprintf(__e_snputchar_handle, &sn, fmt, arp);
 }
 /******************************************************************************************
 说明:	标准格式化打印输出函数
@@ -666,16 +1198,17 @@ void eprintf(const char*fmt, ...)
 }
 
 /******************************************************************************************
-说明:	格式打印输出函数
+说明:	格式打印输出内部实现 字符输出函数带上下文参数，可重入
 支持
 %s--打印字符串	%c--打印字符 %x %X %b %B %d %
 参数:
 // @pfun		字符输出函数指针
+// @ctx			字符输出函数上下文
 // @fmt			格式化字符串
 // @arp			可变参数列表
 返回值:	void
 ******************************************************************************************/
-void evprintf(void(*pfun)(char), const char*fmt, va_list arp)
+static void __e_vprintf(void(*pfun)(void*, char), void* ctx, const char*fmt, va_list arp)
 {
     uint32_t nv;
     char s[36], *p;
@@ -701,11 +1234,11 @@ void evprintf(void(*pfun)(char), const char*fmt, va_list arp)
         while ('%' != (c = *fmt++))
         {	/* 非%字符 直接打印 */
             if (!c) return;
-            pfun(c);
+            pfun(ctx, c);
         }
         if ('%' == (c = *fmt++))
         {	/* %%直接打印%字符 */
-            pfun(c);
+            pfun(ctx, c);
             continue;
         }
         // 获取标志符号
@@ -754,57 +1287,87 @@ void evprintf(void(*pfun)(char), const char*fmt, va_list arp)
         //处理标准标记
         hcode = UCode;
         p = &s[35]; s[35] = '\0'; i = 0;
+        if ('s' == c)
+        {	/* %s 打印字符串 指针参数按指针宽度读取 */
+            p = va_arg(arp, char*);
+            ESTR_ASSERT(p);
+            for (; p[i]; ++i);		/* 计算字符串长度 */
+            goto PRINT_STRING;
+        }
         nv = va_arg(arp, uint32_t);
         switch (c)
         {
         case 'c':	/* %c 打印字符 */
-            pfun((char)nv);
+            pfun(ctx, (char)nv);
             continue;
-        case 's':	/* %s 打印字符串 */
-            p = (char*)nv;		    /* 字符串指针参数 */
-            ESTR_ASSERT(p);
-            for (; p[i]; ++i);		/* 计算字符串长度 */
-            goto PRINT_STRING;
         case 'x':	/* %x 16进制显示 */
             hcode = LCode;
         case 'X':	/* %X 16进制大写显示 */
-            if (fg&FL_ALTERNATE) { pfun('0'); pfun(hcode[16]); i += 2; }
+            if (fg&FL_ALTERNATE) { pfun(ctx, '0'); pfun(ctx, hcode[16]); i += 2; }
             if (!nv) { *--p = '0'; ++i; }
             else for (; nv; ++i) { *--p = hcode[nv & 0x0f]; nv >>= 4; }
             goto PRINT_STRING;
         case 'b':	/* %b 2进制 */
             hcode = LCode;
         case 'B':
-            if (fg&FL_ALTERNATE) { pfun('0'); pfun(hcode[0x0b]); i += 2; }
+            if (fg&FL_ALTERNATE) { pfun(ctx, '0'); pfun(ctx, hcode[0x0b]); i += 2; }
             if (!nv) { *--p = '0'; ++i; }
             else for (; nv; ++i) { *--p = hcode[nv & 0x01]; nv >>= 1; }
             goto PRINT_STRING;
         case 'o':	/* %o 8进制显示 */
-            if ((int32_t)nv < 0) {nv = 0 - nv; pfun('-');++i;}
-            else if (fg&FL_SIGN) { pfun('+'); ++i; }
-            if (fg&FL_ALTERNATE) { pfun('0'); ++i; }
+            if ((int32_t)nv < 0) {nv = 0 - nv; pfun(ctx, '-');++i;}
+            else if (fg&FL_SIGN) { pfun(ctx, '+'); ++i; }
+            if (fg&FL_ALTERNATE) { pfun(ctx, '0'); ++i; }
             else if (!nv) { *--p = '0'; ++i; }
             else for (; nv; ++i) { *--p = hcode[nv & 0x07]; nv >>= 3; }
             goto PRINT_STRING;
         case 'd':
-            if ((int32_t)nv < 0) { nv = 0 - nv; pfun('-'); ++i; }
-            else if (fg&FL_SIGN) { pfun('+'); ++i; }
+            if ((int32_t)nv < 0) { nv = 0 - nv; pfun(ctx, '-'); ++i; }
+            else if (fg&FL_SIGN) { pfun(ctx, '+'); ++i; }
             if (!nv) { *--p = '0'; ++i; }
             else for (; nv; ++i) { *--p = hcode[nv % 10]; nv /= 10; }
             goto PRINT_STRING;
         default:
-            pfun(c); continue;
+            pfun(ctx, c); continue;
         }
         //对字符串进行打印操作
     PRINT_STRING:
         c = fg&FL_LEADZERO ? '0' : ' ';     /* 填充字符 */
-        while (!(fg&FL_LEFT) && i++ < width) pfun(c);	/* 非左对齐填充左字符 */
-        while (*p) pfun(*p++);			    /* 打印字符串 */
-        while (i++ < width) pfun(' ');		/* 填充右空格 */
+        while (!(fg&FL_LEFT) && i++ < width) pfun(ctx, c);	/* 非左对齐填充左字符 */
+        while (*p) pfun(ctx, *p++);			    /* 打印字符串 */
+        while (i++ < width) pfun(ctx, ' ');		/* 填充右空格 */
         continue;
     }
 }
 /******************************************************************************************
+说明:	字符输出函数适配 上下文为字符输出函数指针
+参数:
+// @ctx			指向字符输出函数指针
+// @chr			打印字符
+返回值:	void
+******************************************************************************************/
+static void __e_putchar_handle(void* ctx, char chr)
+{
+    (*(void(**)(char))ctx)(chr);
+}
+/******************************************************************************************
+说明:	格式打印输出函数
+支持
+%s--打印字符串	%c--打印字符 %x %X %b %B %d %
+参数:
+// @pfun		字符输出函数指针
+// @fmt			格式化字符串
+// @arp			可变参数列表
+返回值:	void
+******************************************************************************************/
+void evprintf(void(*pfun)(char), const char*fmt, va_list arp)
+{
+    //参数断言
+    ESTR_ASSERT(pfun);
+
+    __e_vprintf(__e_putchar_handle, &pfun, fmt, arp);
+}
+/******************************************************************************************
 说明:	打印内存数据 分别以十六进制和字符模式打印
 00000000: 01 02 03 04 05 06 07 08 01 02 03 04 05 06 07 08 ................
 支持
@@ -26,6 +26,13 @@ estring是嵌入式安全字符串操作函数库
 #define ISDIGIT(c) ( ((c) >= '0') && ((c) <= '9') )
 
 #define ESTR_ASSERT(X) assert(X)
+
+// 批量编解码的实现 用于ecodecSelect，定义ESTR_NO_SIMD时只使用通用实现
+#define ECODEC_AUTO     (-1)    // CPU支持的最快实现
+#define ECODEC_SCALAR   (0)     // 通用实现
+#define ECODEC_SSE2     (1)     // x86 SSE2
+#define ECODEC_AVX2     (2)     // x86 AVX2
+#define ECODEC_NEON     (3)     // AArch64 NEON
 /*----------------------------------------接口函数----------------------------------------------*/
 
 //兼容C C++混合编程
@@ -45,14 +52,24 @@ int estrcmp(const char* src, const char* dst);
 int estrcmpNocase(const char* src, const char* dst);
 unsigned int eStrSplit(char* str, char separator, char* substr[], unsigned int size);
 char* estrchr(const char* str, char chr);
+char* estrstr(const char* str, const char* substr);
+char* estrstrNocase(const char* str, const char* substr);
 void eStrExpand(char* pdes, char chr, int width);
 int estrtoi(const char *str, int32_t * varl);
 int estrtof(const char *str, float * varl);
 void evprintf(void(*pfun)(char), const char*fmt, va_list arp);
 void eprintf(const char*fmt, ...);
 void esnprintf(char* buff, uint32_t size, const char*fmt, ...);
+void evsnprintf(char* buff, uint32_t size, const char*fmt, va_list arp);
 void ePrintMem(uint8_t* pbuff, uint32_t size, uint32_t addr, uint8_t linsize);
 
+// 批量编解码 estring_codec.c
+int ecodecSelect(int level);
+uint32_t ehexencode(char* dest, uint32_t size, const uint8_t* src, uint32_t len, int upper);
+int32_t ehexdecode(uint8_t* dest, uint32_t size, const char* str, uint32_t len, uint32_t* perrpos);
+uint32_t ebase64encode(char* dest, uint32_t size, const uint8_t* src, uint32_t len);
+int32_t ebase64decode(uint8_t* dest, uint32_t size, const char* str, uint32_t len, uint32_t* perrpos);
+
 	//兼容C C++混合编程
 #ifdef __cplusplus 
 }
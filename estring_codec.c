@@ -0,0 +1,771 @@
+﻿/***********************************************************************************************
+_____________________________________杭州大仁科技有限公司_______________________________________
+@文 件 名: estring_codec.c
+@日    期: 2017.07.28
+@作    者: 张诗星
+
+@文件说明:
+
+estring批量编解码函数 十六进制和base64
+用于命令参数中大块数据的转换，如写内存、写Flash的数据参数
+x86平台运行时检测CPU选择SSE2或AVX2实现，AArch64平台使用NEON实现，
+其他平台或定义ESTR_NO_SIMD时使用通用实现，各实现的结果和错误位置完全相同
+
+@修订说明:
+
+2017.07.28	初始版本
+
+***********************************************************************************************/
+
+/*----------------------------------------头文件----------------------------------------------*/
+#include <stddef.h>
+#include "estring.h"
+
+#if !defined(ESTR_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#define ECODEC_NEON_ENABLE
+#include <arm_neon.h>
+#elif !defined(ESTR_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define ECODEC_X86_ENABLE
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// gcc和clang需要为使用指令集的函数单独指定目标
+#if defined(__GNUC__) || defined(__clang__)
+#define ECODEC_TARGET(X) __attribute__((target(X)))
+#else
+#define ECODEC_TARGET(X)
+#endif
+
+/*----------------------------------------类型定义----------------------------------------------*/
+
+// 批量处理函数 处理开头的整块数据，遇到非法字符的块时停止，剩余部分由通用实现处理
+typedef struct
+{
+    // 编码len字节 返回已编码的字节数
+    uint32_t(*hexencode)(char* dest, const uint8_t* src, uint32_t len, int upper);
+    // 解码num字节 返回已解码的字节数
+    uint32_t(*hexdecode)(uint8_t* dest, const char* str, uint32_t num);
+    // 编码len字节 len为3的倍数，src可读取readable字节 返回已编码的字节数
+    uint32_t(*b64encode)(char* dest, const uint8_t* src, uint32_t len, uint32_t readable);
+    // 解码groups组4个字符 dest可写入size字节 返回已解码的组数
+    uint32_t(*b64decode)(uint8_t* dest, uint32_t size, const char* str, uint32_t groups);
+}CodecKernels;
+
+/*----------------------------------------变量定义----------------------------------------------*/
+
+static const char B64Code[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char UHexCode[] = "0123456789ABCDEF";
+static const char LHexCode[] = "0123456789abcdef";
+
+// 十六进制字符的数值 0xFF为非法字符
+static const uint8_t HexValue[256] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// base64字符的数值 0xFF为非法字符
+static const uint8_t B64Value[256] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/*----------------------------------------x86实现----------------------------------------------*/
+#ifdef ECODEC_X86_ENABLE
+
+// 字符转换为十六进制数值 非法字符在pvalid中对应位置为0
+ECODEC_TARGET("sse2")
+static __m128i HexNibbleSSE2(__m128i c, __m128i* pvalid)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isd = _mm_cmpeq_epi8(_mm_subs_epu8(d, _mm_set1_epi8(9)), zero);
+    __m128i isa = _mm_cmpeq_epi8(_mm_subs_epu8(a, _mm_set1_epi8(5)), zero);
+
+    *pvalid = _mm_and_si128(*pvalid, _mm_or_si128(isd, isa));
+    return _mm_or_si128(_mm_and_si128(isd, d), _mm_and_si128(isa, _mm_add_epi8(a, _mm_set1_epi8(10))));
+}
+
+// 相邻的两个数值合并为一个字节 结果在每个16位的低字节中
+ECODEC_TARGET("sse2")
+static __m128i HexMergeSSE2(__m128i v)
+{
+    __m128i hi = _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), 4);
+    return _mm_or_si128(hi, _mm_srli_epi16(v, 8));
+}
+
+// 数值转换为十六进制字符
+ECODEC_TARGET("sse2")
+static __m128i HexCharSSE2(__m128i n, __m128i alpha)
+{
+    __m128i off = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), alpha);
+    return _mm_add_epi8(n, _mm_add_epi8(off, _mm_set1_epi8('0')));
+}
+
+ECODEC_TARGET("sse2")
+static uint32_t HexEncodeSSE2(char* dest, const uint8_t* src, uint32_t len, int upper)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i alpha = _mm_set1_epi8(upper ? 'A' - '9' - 1 : 'a' - '9' - 1);
+    uint32_t i = 0;
+
+    for (; i + 16 <= len; i += 16, dest += 32)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i hi = HexCharSSE2(_mm_and_si128(_mm_srli_epi16(x, 4), mask), alpha);
+        __m128i lo = HexCharSSE2(_mm_and_si128(x, mask), alpha);
+        _mm_storeu_si128((__m128i*)dest, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(dest + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+ECODEC_TARGET("sse2")
+static uint32_t HexDecodeSSE2(uint8_t* dest, const char* str, uint32_t num)
+{
+    uint32_t i = 0;
+
+    for (; i + 16 <= num; i += 16, str += 32)
+    {
+        __m128i valid = _mm_set1_epi8(-1);
+        __m128i v0 = HexNibbleSSE2(_mm_loadu_si128((const __m128i*)str), &valid);
+        __m128i v1 = HexNibbleSSE2(_mm_loadu_si128((const __m128i*)(str + 16)), &valid);
+        if (0xFFFF != _mm_movemask_epi8(valid))
+            break;
+        _mm_storeu_si128((__m128i*)&dest[i], _mm_packus_epi16(HexMergeSSE2(v0), HexMergeSSE2(v1)));
+    }
+    return i;
+}
+
+// 按字符范围转换为base64数值 SSE2没有查表指令
+ECODEC_TARGET("sse2")
+static __m128i B64ValueSSE2(__m128i c, __m128i* pvalid)
+{
+    __m128i isu = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+    __m128i isl = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+    __m128i isd = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i isp = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+    __m128i iss = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+
+    __m128i off = _mm_or_si128(_mm_and_si128(isu, _mm_set1_epi8(-'A')), _mm_and_si128(isl, _mm_set1_epi8(26 - 'a')));
+    off = _mm_or_si128(off, _mm_and_si128(isd, _mm_set1_epi8(52 - '0')));
+    off = _mm_or_si128(off, _mm_and_si128(isp, _mm_set1_epi8(62 - '+')));
+    off = _mm_or_si128(off, _mm_and_si128(iss, _mm_set1_epi8(63 - '/')));
+    *pvalid = _mm_or_si128(_mm_or_si128(isu, isl), _mm_or_si128(_mm_or_si128(isd, isp), iss));
+    return _mm_add_epi8(c, off);
+}
+
+ECODEC_TARGET("sse2")
+static uint32_t B64DecodeSSE2(uint8_t* dest, uint32_t size, const char* str, uint32_t groups)
+{
+    uint32_t i = 0;
+
+    // 每次16个字符输出12字节 写入14字节
+    for (; i + 4 <= groups && i * 3 + 16 <= size; i += 4, str += 16)
+    {
+        __m128i valid;
+        __m128i v = B64ValueSSE2(_mm_loadu_si128((const __m128i*)str), &valid);
+        if (0xFFFF != _mm_movemask_epi8(valid))
+            break;
+
+        // 4个6位数值合并为24位 再调整为大端字节顺序
+        v = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), 6), _mm_srli_epi16(v, 8));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), _mm_set1_epi32(0xFF)),
+            _mm_and_si128(v, _mm_set1_epi32(0xFF00))), _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0xFF)), 16));
+
+        // 每个64位中保留6字节
+        v = _mm_or_si128(_mm_and_si128(v, _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF)),
+            _mm_and_si128(_mm_srli_epi64(v, 8), _mm_set_epi32(0x0000FFFF, (int)0xFF000000, 0x0000FFFF, (int)0xFF000000)));
+        _mm_storel_epi64((__m128i*)&dest[i * 3], v);
+        _mm_storel_epi64((__m128i*)&dest[i * 3 + 6], _mm_unpackhi_epi64(v, v));
+    }
+    return i;
+}
+
+ECODEC_TARGET("avx2")
+static __m256i HexNibbleAVX2(__m256i c, __m256i* pvalid)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i a = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isd = _mm256_cmpeq_epi8(_mm256_subs_epu8(d, _mm256_set1_epi8(9)), zero);
+    __m256i isa = _mm256_cmpeq_epi8(_mm256_subs_epu8(a, _mm256_set1_epi8(5)), zero);
+
+    *pvalid = _mm256_and_si256(*pvalid, _mm256_or_si256(isd, isa));
+    return _mm256_or_si256(_mm256_and_si256(isd, d), _mm256_and_si256(isa, _mm256_add_epi8(a, _mm256_set1_epi8(10))));
+}
+
+ECODEC_TARGET("avx2")
+static __m256i HexMergeAVX2(__m256i v)
+{
+    __m256i hi = _mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x00FF)), 4);
+    return _mm256_or_si256(hi, _mm256_srli_epi16(v, 8));
+}
+
+ECODEC_TARGET("avx2")
+static __m256i HexCharAVX2(__m256i n, __m256i alpha)
+{
+    __m256i off = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)), alpha);
+    return _mm256_add_epi8(n, _mm256_add_epi8(off, _mm256_set1_epi8('0')));
+}
+
+ECODEC_TARGET("avx2")
+static uint32_t HexEncodeAVX2(char* dest, const uint8_t* src, uint32_t len, int upper)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    const __m256i alpha = _mm256_set1_epi8(upper ? 'A' - '9' - 1 : 'a' - '9' - 1);
+    uint32_t i = 0;
+
+    for (; i + 32 <= len; i += 32, dest += 64)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)&src[i]);
+        __m256i hi = HexCharAVX2(_mm256_and_si256(_mm256_srli_epi16(x, 4), mask), alpha);
+        __m256i lo = HexCharAVX2(_mm256_and_si256(x, mask), alpha);
+
+        // 交错指令在128位内进行 需要重新组合两个128位
+        __m256i l = _mm256_unpacklo_epi8(hi, lo);
+        __m256i h = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)dest, _mm256_permute2x128_si256(l, h, 0x20));
+        _mm256_storeu_si256((__m256i*)(dest + 32), _mm256_permute2x128_si256(l, h, 0x31));
+    }
+    // 执行SSE指令前清除256位寄存器的高半部分 避免状态切换的开销
+    _mm256_zeroupper();
+    return i + HexEncodeSSE2(dest, &src[i], len - i, upper);
+}
+
+ECODEC_TARGET("avx2")
+static uint32_t HexDecodeAVX2(uint8_t* dest, const char* str, uint32_t num)
+{
+    uint32_t i = 0;
+
+    for (; i + 32 <= num; i += 32, str += 64)
+    {
+        __m256i valid = _mm256_set1_epi8(-1);
+        __m256i v0 = HexNibbleAVX2(_mm256_loadu_si256((const __m256i*)str), &valid);
+        __m256i v1 = HexNibbleAVX2(_mm256_loadu_si256((const __m256i*)(str + 32)), &valid);
+        if (-1 != _mm256_movemask_epi8(valid))
+            return i;
+        __m256i v = _mm256_packus_epi16(HexMergeAVX2(v0), HexMergeAVX2(v1));
+        _mm256_storeu_si256((__m256i*)&dest[i], _mm256_permute4x64_epi64(v, 0xD8));
+    }
+    _mm256_zeroupper();
+    return i + HexDecodeSSE2(&dest[i], str, num - i);
+}
+
+// 每组3字节扩展为4个6位数值 W. Mula的方法
+ECODEC_TARGET("avx2")
+static uint32_t B64EncodeAVX2(char* dest, const uint8_t* src, uint32_t len, uint32_t readable)
+{
+    const __m256i shuf = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i lut = _mm256_setr_epi8('A', 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 0, 0,
+        'A', 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 0, 0);
+    uint32_t i = 0;
+
+    // 每次读取28字节 编码24字节
+    for (; i + 24 <= len && i + 28 <= readable; i += 24, dest += 32)
+    {
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)&src[i])),
+            _mm_loadu_si128((const __m128i*)&src[i + 12]), 1);
+        in = _mm256_shuffle_epi8(in, shuf);
+        __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+        __m256i idx = _mm256_or_si256(t0, t1);
+
+        // 0~25为0 26~51为1 52~61为2~11 62为12 63为13
+        __m256i sel = _mm256_sub_epi8(_mm256_subs_epu8(idx, _mm256_set1_epi8(51)), _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(25)));
+        _mm256_storeu_si256((__m256i*)dest, _mm256_add_epi8(idx, _mm256_shuffle_epi8(lut, sel)));
+    }
+    _mm256_zeroupper();
+    return i;
+}
+
+// 查表检查和转换base64字符 W. Mula和D. Lemire的方法
+ECODEC_TARGET("avx2")
+static uint32_t B64DecodeAVX2(uint8_t* dest, uint32_t size, const char* str, uint32_t groups)
+{
+    // 低4位对应的非法高4位 高4位对应的类别
+    const __m256i lutlo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i luthi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutroll = _mm256_setr_epi8(0, 63 - '/', 62 - '+', 52 - '0', -'A', -'A', 26 - 'a', 26 - 'a',
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 63 - '/', 62 - '+', 52 - '0', -'A', -'A', 26 - 'a', 26 - 'a',
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    uint32_t i = 0;
+
+    // 每次32个字符输出24字节 写入32字节
+    for (; i + 8 <= groups && i * 3 + 32 <= size; i += 8, str += 32)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i*)str);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi32(c, 4), mask);
+        __m256i lo = _mm256_and_si256(c, mask);
+        if (!_mm256_testz_si256(_mm256_shuffle_epi8(lutlo, lo), _mm256_shuffle_epi8(luthi, hi)))
+            break;
+
+        // '/'和'+'的高4位相同 使用前一项
+        __m256i slash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'));
+        __m256i v = _mm256_add_epi8(c, _mm256_shuffle_epi8(lutroll, _mm256_add_epi8(slash, hi)));
+
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, pack);
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256((__m256i*)&dest[i * 3], v);
+    }
+    _mm256_zeroupper();
+    return i + B64DecodeSSE2(&dest[i * 3], size - i * 3, str, groups - i);
+}
+
+static const CodecKernels SSE2Kernels = {HexEncodeSSE2, HexDecodeSSE2, NULL, B64DecodeSSE2};
+static const CodecKernels AVX2Kernels = {HexEncodeAVX2, HexDecodeAVX2, B64EncodeAVX2, B64DecodeAVX2};
+#endif
+
+/*----------------------------------------NEON实现----------------------------------------------*/
+#ifdef ECODEC_NEON_ENABLE
+
+static inline uint8x16_t HexNibbleNEON(uint8x16_t c, uint8x16_t* pvalid)
+{
+    uint8x16_t d = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t a = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isd = vcleq_u8(d, vdupq_n_u8(9));
+    uint8x16_t isa = vcleq_u8(a, vdupq_n_u8(5));
+
+    *pvalid = vandq_u8(*pvalid, vorrq_u8(isd, isa));
+    return vbslq_u8(isd, d, vaddq_u8(a, vdupq_n_u8(10)));
+}
+
+static inline uint8x16_t HexCharNEON(uint8x16_t n, uint8x16_t alpha)
+{
+    return vaddq_u8(n, vbslq_u8(vcgtq_u8(n, vdupq_n_u8(9)), alpha, vdupq_n_u8('0')));
+}
+
+static uint32_t HexEncodeNEON(char* dest, const uint8_t* src, uint32_t len, int upper)
+{
+    const uint8x16_t alpha = vdupq_n_u8(upper ? 'A' - 10 : 'a' - 10);
+    uint32_t i = 0;
+
+    for (; i + 16 <= len; i += 16, dest += 32)
+    {
+        uint8x16_t x = vld1q_u8(&src[i]);
+        uint8x16x2_t out;
+        out.val[0] = HexCharNEON(vshrq_n_u8(x, 4), alpha);
+        out.val[1] = HexCharNEON(vandq_u8(x, vdupq_n_u8(0x0F)), alpha);
+        vst2q_u8((uint8_t*)dest, out);
+    }
+    return i;
+}
+
+static uint32_t HexDecodeNEON(uint8_t* dest, const char* str, uint32_t num)
+{
+    uint32_t i = 0;
+
+    for (; i + 16 <= num; i += 16, str += 32)
+    {
+        // 加载时分开高4位和低4位字符
+        uint8x16x2_t c = vld2q_u8((const uint8_t*)str);
+        uint8x16_t valid = vdupq_n_u8(0xFF);
+        uint8x16_t hi = HexNibbleNEON(c.val[0], &valid);
+        uint8x16_t lo = HexNibbleNEON(c.val[1], &valid);
+        if (0xFF != vminvq_u8(valid))
+            break;
+        vst1q_u8(&dest[i], vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    return i;
+}
+
+static uint32_t B64EncodeNEON(char* dest, const uint8_t* src, uint32_t len, uint32_t readable)
+{
+    uint8x16x4_t lut;
+    uint32_t i = 0;
+
+    lut.val[0] = vld1q_u8((const uint8_t*)&B64Code[0]);
+    lut.val[1] = vld1q_u8((const uint8_t*)&B64Code[16]);
+    lut.val[2] = vld1q_u8((const uint8_t*)&B64Code[32]);
+    lut.val[3] = vld1q_u8((const uint8_t*)&B64Code[48]);
+    for (; i + 48 <= len; i += 48, dest += 64)
+    {
+        // 加载时分开每组的3个字节
+        uint8x16x3_t in = vld3q_u8(&src[i]);
+        uint8x16x4_t out;
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], vdupq_n_u8(0x03)), 4), vshrq_n_u8(in.val[1], 4));
+        out.val[2] = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[1], vdupq_n_u8(0x0F)), 2), vshrq_n_u8(in.val[2], 6));
+        out.val[3] = vandq_u8(in.val[2], vdupq_n_u8(0x3F));
+        out.val[0] = vqtbl4q_u8(lut, out.val[0]);
+        out.val[1] = vqtbl4q_u8(lut, out.val[1]);
+        out.val[2] = vqtbl4q_u8(lut, out.val[2]);
+        out.val[3] = vqtbl4q_u8(lut, out.val[3]);
+        vst4q_u8((uint8_t*)dest, out);
+    }
+    (void)readable;
+    return i;
+}
+
+static inline uint8x16_t B64ValueNEON(uint8x16_t c, uint8x16_t* pvalid)
+{
+    uint8x16_t u = vsubq_u8(c, vdupq_n_u8('A'));
+    uint8x16_t l = vsubq_u8(c, vdupq_n_u8('a'));
+    uint8x16_t d = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t isu = vcltq_u8(u, vdupq_n_u8(26));
+    uint8x16_t isl = vcltq_u8(l, vdupq_n_u8(26));
+    uint8x16_t isd = vcltq_u8(d, vdupq_n_u8(10));
+    uint8x16_t isp = vceqq_u8(c, vdupq_n_u8('+'));
+    uint8x16_t iss = vceqq_u8(c, vdupq_n_u8('/'));
+
+    *pvalid = vandq_u8(*pvalid, vorrq_u8(vorrq_u8(isu, isl), vorrq_u8(vorrq_u8(isd, isp), iss)));
+    return vbslq_u8(isu, u, vbslq_u8(isl, vaddq_u8(l, vdupq_n_u8(26)),
+        vbslq_u8(isd, vaddq_u8(d, vdupq_n_u8(52)), vbslq_u8(isp, vdupq_n_u8(62), vdupq_n_u8(63)))));
+}
+
+static uint32_t B64DecodeNEON(uint8_t* dest, uint32_t size, const char* str, uint32_t groups)
+{
+    uint32_t i = 0;
+
+    for (; i + 16 <= groups; i += 16, str += 64)
+    {
+        // 加载时分开每组的4个字符
+        uint8x16x4_t c = vld4q_u8((const uint8_t*)str);
+        uint8x16_t valid = vdupq_n_u8(0xFF);
+        uint8x16_t a = B64ValueNEON(c.val[0], &valid);
+        uint8x16_t b = B64ValueNEON(c.val[1], &valid);
+        uint8x16_t d = B64ValueNEON(c.val[2], &valid);
+        uint8x16_t e = B64ValueNEON(c.val[3], &valid);
+        if (0xFF != vminvq_u8(valid))
+            break;
+
+        uint8x16x3_t out;
+        out.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(d, 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(d, 6), e);
+        vst3q_u8(&dest[i * 3], out);
+    }
+    (void)size;
+    return i;
+}
+
+static const CodecKernels NEONKernels = {HexEncodeNEON, HexDecodeNEON, B64EncodeNEON, B64DecodeNEON};
+#endif
+
+/*----------------------------------------实现选择----------------------------------------------*/
+
+static const CodecKernels ScalarKernels = {NULL, NULL, NULL, NULL};
+static const CodecKernels* _kernels = NULL;
+static int _level = ECODEC_SCALAR;
+
+// 检测CPU支持的最快实现
+static int DetectLevel(void)
+{
+#if defined(ECODEC_NEON_ENABLE)
+    return ECODEC_NEON;
+#elif defined(ECODEC_X86_ENABLE) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxid = info[0];
+    __cpuid(info, 1);
+    int sse2 = info[3] & (1 << 26);
+    int osxsave = info[2] & (1 << 27);
+    if (maxid >= 7 && osxsave && 6 == (_xgetbv(0) & 6))
+    {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return ECODEC_AVX2;
+    }
+    return sse2 ? ECODEC_SSE2 : ECODEC_SCALAR;
+#elif defined(ECODEC_X86_ENABLE)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return ECODEC_AVX2;
+    return __builtin_cpu_supports("sse2") ? ECODEC_SSE2 : ECODEC_SCALAR;
+#else
+    return ECODEC_SCALAR;
+#endif
+}
+
+static inline const CodecKernels* GetKernels(void)
+{
+    if (NULL == _kernels)
+        ecodecSelect(ECODEC_AUTO);
+    return _kernels;
+}
+
+/******************************************************************************************
+说明:			选择批量编解码的实现
+--默认在第一次调用时选择CPU支持的最快实现，用于测试和性能对比
+参数:
+// @level		ECODEC_AUTO或ECODEC_SCALAR等
+返回值:	int		当前使用的实现 CPU不支持指定的实现时返回-1且不改变
+******************************************************************************************/
+int ecodecSelect(int level)
+{
+    int maxlevel = DetectLevel();
+
+    if (ECODEC_AUTO == level)
+        level = maxlevel;
+    else if (level != ECODEC_SCALAR && (level > maxlevel || (ECODEC_NEON == maxlevel) != (ECODEC_NEON == level)))
+        return -1;
+
+    switch (level)
+    {
+#if defined(ECODEC_X86_ENABLE)
+    case ECODEC_SSE2: _kernels = &SSE2Kernels; break;
+    case ECODEC_AVX2: _kernels = &AVX2Kernels; break;
+#elif defined(ECODEC_NEON_ENABLE)
+    case ECODEC_NEON: _kernels = &NEONKernels; break;
+#endif
+    default: _kernels = &ScalarKernels; level = ECODEC_SCALAR; break;
+    }
+    _level = level;
+    return _level;
+}
+
+/*----------------------------------------接口函数----------------------------------------------*/
+
+/******************************************************************************************
+说明:			数据转换为十六进制字符串
+--dest空间不足时只转换能容纳的部分
+参数:
+// @dest		目的字符串
+// @size		目的缓冲区大小 包括结尾的'\0'
+// @src			数据
+// @len			数据长度
+// @upper		非0时使用大写字母
+返回值:	uint32_t 字符串长度
+******************************************************************************************/
+uint32_t ehexencode(char* dest, uint32_t size, const uint8_t* src, uint32_t len, int upper)
+{
+    //参数断言
+    ESTR_ASSERT(dest);
+    ESTR_ASSERT(src || !len);
+
+    const CodecKernels* kernels = GetKernels();
+    const char* code = upper ? UHexCode : LHexCode;
+    uint32_t i = 0;
+
+    if (0 == size)
+        return 0;
+    if (len > (size - 1) / 2)
+        len = (size - 1) / 2;
+    if (kernels->hexencode)
+        i = kernels->hexencode(dest, src, len, upper);
+    for (; i < len; ++i)
+    {
+        dest[i * 2] = code[src[i] >> 4];
+        dest[i * 2 + 1] = code[src[i] & 0x0F];
+    }
+    dest[len * 2] = '\0';
+    return len * 2;
+}
+
+/******************************************************************************************
+说明:			十六进制字符串转换为数据
+--字符串长度必须为偶数，大小写字母均可，不允许空白和0x前缀
+参数:
+// @dest		目的数据
+// @size		目的缓冲区大小
+// @str			十六进制字符串
+// @len			字符串长度
+// @perrpos		失败时保存错误位置，可为NULL
+--非法字符时为该字符的位置，长度为奇数或目的缓冲区不足时为len
+返回值:	int32_t	转换的字节数 失败返回-1
+******************************************************************************************/
+int32_t ehexdecode(uint8_t* dest, uint32_t size, const char* str, uint32_t len, uint32_t* perrpos)
+{
+    //参数断言
+    ESTR_ASSERT(dest || !size);
+    ESTR_ASSERT(str || !len);
+
+    const CodecKernels* kernels = GetKernels();
+    uint32_t num = len / 2;
+    uint32_t i = 0, errpos = len;
+
+    if ((len & 1) || num > size || num > INT32_MAX)
+        goto ERROR;
+    if (kernels->hexdecode)
+        i = kernels->hexdecode(dest, str, num);
+    for (; i < num; ++i)
+    {
+        uint8_t hi = HexValue[(uint8_t)str[i * 2]];
+        uint8_t lo = HexValue[(uint8_t)str[i * 2 + 1]];
+        if ((hi | lo) & 0xF0)
+        {
+            errpos = i * 2 + (0xFF == hi ? 0 : 1);
+            goto ERROR;
+        }
+        dest[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return (int32_t)num;
+
+ERROR:
+    if (perrpos)
+        *perrpos = errpos;
+    return -1;
+}
+
+/******************************************************************************************
+说明:			数据转换为base64字符串 使用标准字母表和'='填充
+--dest空间不足时只转换能容纳的整组
+参数:
+// @dest		目的字符串
+// @size		目的缓冲区大小 包括结尾的'\0'
+// @src			数据
+// @len			数据长度
+返回值:	uint32_t 字符串长度
+******************************************************************************************/
+uint32_t ebase64encode(char* dest, uint32_t size, const uint8_t* src, uint32_t len)
+{
+    //参数断言
+    ESTR_ASSERT(dest);
+    ESTR_ASSERT(src || !len);
+
+    const CodecKernels* kernels = GetKernels();
+    uint32_t groups = len / 3, rem = len % 3;
+    uint32_t i = 0, n;
+
+    if (0 == size)
+        return 0;
+    if (groups + (rem ? 1 : 0) > (size - 1) / 4)
+    {
+        groups = (size - 1) / 4;
+        rem = 0;
+    }
+    if (kernels->b64encode)
+        i = kernels->b64encode(dest, src, groups * 3, len) / 3;
+    for (; i < groups; ++i)
+    {
+        uint32_t w = (uint32_t)src[i * 3] << 16 | (uint32_t)src[i * 3 + 1] << 8 | src[i * 3 + 2];
+        dest[i * 4] = B64Code[w >> 18];
+        dest[i * 4 + 1] = B64Code[(w >> 12) & 0x3F];
+        dest[i * 4 + 2] = B64Code[(w >> 6) & 0x3F];
+        dest[i * 4 + 3] = B64Code[w & 0x3F];
+    }
+
+    // 最后不足3字节的部分
+    n = groups * 4;
+    if (rem)
+    {
+        uint32_t w = (uint32_t)src[groups * 3] << 16 | (2 == rem ? (uint32_t)src[groups * 3 + 1] << 8 : 0);
+        dest[n] = B64Code[w >> 18];
+        dest[n + 1] = B64Code[(w >> 12) & 0x3F];
+        dest[n + 2] = 2 == rem ? B64Code[(w >> 6) & 0x3F] : '=';
+        dest[n + 3] = '=';
+        n += 4;
+    }
+    dest[n] = '\0';
+    return n;
+}
+
+/******************************************************************************************
+说明:			base64字符串转换为数据 使用标准字母表
+--结尾的'='填充可以省略，不允许空白和其他位置的'='
+参数:
+// @dest		目的数据
+// @size		目的缓冲区大小
+// @str			base64字符串
+// @len			字符串长度
+// @perrpos		失败时保存错误位置，可为NULL
+--非法字符时为该字符的位置，长度错误或目的缓冲区不足时为len
+返回值:	int32_t	转换的字节数 失败返回-1
+******************************************************************************************/
+int32_t ebase64decode(uint8_t* dest, uint32_t size, const char* str, uint32_t len, uint32_t* perrpos)
+{
+    //参数断言
+    ESTR_ASSERT(dest || !size);
+    ESTR_ASSERT(str || !len);
+
+    const CodecKernels* kernels = GetKernels();
+    uint32_t body = len, errpos = len;
+    uint32_t i = 0, num, groups;
+
+    // 去除结尾的填充 填充后的长度必须为4的倍数
+    if (0 == (len & 3) && len && '=' == str[len - 1])
+        body -= '=' == str[len - 2] ? 2 : 1;
+    if (1 == (body & 3))
+        goto ERROR;
+    num = body / 4 * 3 + ((body & 3) ? (body & 3) - 1 : 0);
+    if (num > size || num > INT32_MAX)
+        goto ERROR;
+
+    groups = body / 4;
+    if (kernels->b64decode)
+        i = kernels->b64decode(dest, size, str, groups);
+    for (; i < groups; ++i)
+    {
+        const uint8_t* p = (const uint8_t*)&str[i * 4];
+        uint8_t a = B64Value[p[0]], b = B64Value[p[1]], c = B64Value[p[2]], d = B64Value[p[3]];
+        if ((a | b | c | d) & 0xC0)
+        {
+            errpos = i * 4 + (0xFF == a ? 0 : 0xFF == b ? 1 : 0xFF == c ? 2 : 3);
+            goto ERROR;
+        }
+        uint32_t w = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | d;
+        dest[i * 3] = (uint8_t)(w >> 16);
+        dest[i * 3 + 1] = (uint8_t)(w >> 8);
+        dest[i * 3 + 2] = (uint8_t)w;
+    }
+
+    // 最后不足4个字符的一组
+    if (body & 3)
+    {
+        uint32_t w = 0;
+        for (uint32_t k = 0; k < (body & 3); ++k)
+        {
+            uint8_t v = B64Value[(uint8_t)str[groups * 4 + k]];
+            if (0xFF == v)
+            {
+                errpos = groups * 4 + k;
+                goto ERROR;
+            }
+            w |= (uint32_t)v << (18 - 6 * k);
+        }
+        for (uint32_t k = 0; k + 1 < (body & 3); ++k)
+            dest[groups * 3 + k] = (uint8_t)(w >> (16 - 8 * k));
+    }
+    return (int32_t)num;
+
+ERROR:
+    if (perrpos)
+        *perrpos = errpos;
+    return -1;
+}
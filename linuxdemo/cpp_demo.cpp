@@ -0,0 +1,102 @@
+﻿/**
+ * @file     cpp_demo.cpp
+ * @brief    C++命令表演示程序
+ * @details
+ * 用法：cpp_demo [设备 [波特率]]，需要C++17
+ * 命令表由uecli.hpp在编译时生成，命令函数直接使用带类型的参数
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include "uecli.hpp"
+#include "posix_port.h"
+
+static bool _quit = false;
+static bool _leds[4];
+static float _gain = 1.0f;
+
+// 设置LED 序号超出范围时返回错误
+static bool ledfun(uint8_t index, bool on)
+{
+    if (index >= 4)
+        return false;
+    _leds[index] = on;
+    return true;
+}
+
+// 加法 第三个参数可以省略
+static void addfun(int32_t a, int32_t b, std::optional<int32_t> c)
+{
+    char buff[48];
+    esnprintf(buff, sizeof(buff), "%d" UECLI_NEWLINE, a + b + c.value_or(0));
+    uecli_PrintString(buff);
+}
+
+static void gainfun(float gain)
+{
+    _gain = gain;
+}
+
+static void echofun(const char* text)
+{
+    uecli_PrintString(text);
+    uecli_PrintString(UECLI_NEWLINE);
+}
+
+static void statusfun()
+{
+    char buff[64];
+    esnprintf(buff, sizeof(buff), "led: %d%d%d%d gain: %d/1000" UECLI_NEWLINE,
+        _leds[0], _leds[1], _leds[2], _leds[3], (int)(_gain * 1000));
+    uecli_PrintString(buff);
+}
+
+// 原始命令函数
+static void quitfun(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+    _quit = true;
+}
+
+// 子菜单
+UECLI_TABLE(cfgtable,
+    uecli::Command<&gainfun>("gain", "设置增益", "gain <增益>"),
+    uecli::Command<&statusfun>("status", "显示状态"));
+
+// 主菜单 顺序不限，编译时排序
+UECLI_TABLE(maintable,
+    uecli::Command<&quitfun>("quit", "退出程序"),
+    uecli::Command<&ledfun>("led", "设置LED", "led <0-3> <on|off>"),
+    uecli::Command<&addfun>("add", "整数加法", "add <a> <b> [c]"),
+    uecli::Command<&echofun>("echo", "输出文本"),
+    uecli::Menu("cfg", "配置菜单", cfgtable));
+
+int main(int argc, char* argv[])
+{
+    uecli_port_config(argc > 1 ? argv[1] : NULL, argc > 2 ? (uint32_t)atoi(argv[2]) : 0);
+    uecli_Initialize(maintable);
+
+    char buff[1024];
+    int len, pending = 0;
+
+    while (!_quit)
+    {
+        len = uecli_port_in(&buff[pending], (uint16_t)(sizeof(buff) - pending));
+        if (len < 0)
+            break;
+
+        len += pending;
+        int done = uecli_ProcessInput(buff, len);
+        pending = len - done;
+        memmove(buff, &buff[done], (size_t)pending);
+    }
+    uecli_port_close();
+    return 0;
+}
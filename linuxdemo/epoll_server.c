@@ -0,0 +1,658 @@
+﻿/**
+ * @file     epoll_server.c
+ * @brief    基于epoll的多连接控制台服务
+ * @details
+ * 在TCP或Unix socket上提供uecli控制台，每个连接拥有独立的会话：
+ * - 每个事件循环线程使用独立的epoll，监听描述符以EPOLLEXCLUSIVE加入所有事件循环，
+ *   连接由接受它的线程负责处理，之后不再跨线程
+ * - 连接以边沿触发方式注册，可读时读取全部数据交给会话处理
+ * - 命令输出写入连接的发送队列，超过高水位时暂停读取该连接，
+ *   由TCP窗口把压力传递给客户端，低于低水位后恢复
+ * - TCP连接可选telnet协商，使客户端进入字符模式
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "uecli.h"
+#include "epoll_server.h"
+
+#if UECLI_01_SESSION==0
+#error "epoll_server.c需要打开UECLI_01_SESSION"
+#endif
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define SERVER_MAX_REACTORS     (64)            // 最大事件循环线程数量
+#define SERVER_MAX_EVENTS       (256)           // 每次epoll_wait最多处理的事件数量
+#define SERVER_READ_SIZE        (16384)         // 每次读取的最大数据量
+#define SERVER_OUT_INITSIZE     (1024)          // 发送队列初始大小
+#define SERVER_HIGHWATER        (64 * 1024)     // 默认高水位
+#define SERVER_LOWWATER         (16 * 1024)     // 默认低水位
+#define SERVER_MAXQUEUE         (4 * 1024 * 1024)   // 默认发送队列上限
+
+// telnet协议字符
+#define TELNET_SE       (240)
+#define TELNET_SB       (250)
+#define TELNET_WILL     (251)
+#define TELNET_DONT     (254)
+#define TELNET_IAC      (255)
+#define TELNET_ECHO     (1)
+#define TELNET_SGA      (3)
+#define TELNET_LINEMODE (34)
+
+// ********************************************************************************************
+// 内部类型定义
+
+// 事件源类型
+typedef enum
+{
+    SOURCE_LISTEN = 0,      // 监听描述符
+    SOURCE_STOP,            // 停止通知
+    SOURCE_CONN             // 客户端连接
+}SourceType;
+
+// 事件源 作为epoll的用户数据
+typedef struct
+{
+    SourceType type;
+    int fd;
+}EventSource;
+
+// 监听描述符
+typedef struct
+{
+    EventSource source;
+    bool telnet;            // 接受的连接使用telnet协商
+}Listener;
+
+// telnet输入解析状态
+typedef enum
+{
+    TELNET_STATE_DATA = 0,  // 普通数据
+    TELNET_STATE_CR,        // 收到回车 忽略随后的换行或空字符
+    TELNET_STATE_IAC,       // 收到IAC
+    TELNET_STATE_OPT,       // 收到WILL/WONT/DO/DONT 等待选项
+    TELNET_STATE_SB,        // 子协商数据
+    TELNET_STATE_SBIAC      // 子协商中收到IAC
+}TelnetState;
+
+struct Reactor;
+
+// 客户端连接
+typedef struct Connection
+{
+    EventSource source;
+    struct Reactor* reactor;    // 所属事件循环
+    struct Connection* prev;    // 事件循环的连接链表
+    struct Connection* next;
+    uecli_Session* session;     // 会话 与连接一起分配
+
+    char* outbuff;              // 发送队列
+    uint32_t outpos;            // 已发送位置
+    uint32_t outlen;            // 队列数据长度
+    uint32_t outsize;           // 队列缓存大小
+    uint32_t dropped;           // 超过队列上限丢弃的字节数
+
+    bool telnet;                // 处理telnet协议
+    TelnetState telstate;       // telnet输入解析状态
+    bool paused;                // 发送队列超过高水位 暂停读取
+    bool readable;              // 暂停期间仍有未读取的数据
+    bool closing;               // 对端已关闭或出错
+}Connection;
+
+// 事件循环
+typedef struct Reactor
+{
+    int epfd;                   // epoll描述符
+    EventSource stop;           // 停止通知 eventfd
+    pthread_t thread;           // 事件循环线程
+    Connection* conns;          // 连接链表
+}Reactor;
+
+// ********************************************************************************************
+// 内部变量
+
+static struct
+{
+    uecli_ServerConfig cfg;
+    const uecli_MenuItem* cmdlist;
+    Listener listeners[2];
+    int listennum;
+    Reactor reactors[SERVER_MAX_REACTORS];
+    int reactornum;
+    volatile uint32_t stop;     // 停止标记
+    volatile uint32_t conns;    // 当前连接数量
+}server;
+
+// ********************************************************************************************
+// 内部函数
+
+// 设置非阻塞方式
+static void SetNonBlock(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// 发送队列中待发送的数据长度
+static inline uint32_t PendingBytes(const Connection* conn)
+{
+    return conn->outlen - conn->outpos;
+}
+
+// 尽可能发送队列中的数据 不会阻塞
+static void FlushConnection(Connection* conn)
+{
+    while (PendingBytes(conn))
+    {
+        ssize_t len = write(conn->source.fd, conn->outbuff + conn->outpos, PendingBytes(conn));
+        if (len > 0)
+            conn->outpos += (uint32_t)len;
+        else if (len < 0 && EINTR == errno)
+            continue;
+        else
+        {
+            if (len < 0 && EAGAIN != errno && EWOULDBLOCK != errno)
+                conn->closing = true;
+            return;
+        }
+    }
+
+    // 全部发送完成
+    conn->outpos = conn->outlen = 0;
+    if (conn->outsize > SERVER_OUT_INITSIZE * 64)
+    {
+        free(conn->outbuff);
+        conn->outbuff = NULL;
+        conn->outsize = 0;
+    }
+}
+
+// 会话输出函数 写入发送队列
+static void ConnectionOut(void* ctx, const void* buff, uint32_t num)
+{
+    Connection* conn = (Connection*)ctx;
+
+    if (conn->closing)
+        return;
+    if (PendingBytes(conn) + num > server.cfg.maxqueue)
+    {
+        conn->dropped += num;
+        return;
+    }
+
+    // 移除已发送的数据 空间不足时扩大缓存
+    if (conn->outlen + num > conn->outsize && conn->outpos)
+    {
+        memmove(conn->outbuff, conn->outbuff + conn->outpos, PendingBytes(conn));
+        conn->outlen -= conn->outpos;
+        conn->outpos = 0;
+    }
+    if (conn->outlen + num > conn->outsize)
+    {
+        uint32_t size = conn->outsize ? conn->outsize : SERVER_OUT_INITSIZE;
+        while (size < conn->outlen + num)
+            size *= 2;
+        char* pbuff = (char*)realloc(conn->outbuff, size);
+        if (NULL == pbuff)
+        {
+            conn->dropped += num;
+            return;
+        }
+        conn->outbuff = pbuff;
+        conn->outsize = size;
+    }
+    memcpy(conn->outbuff + conn->outlen, buff, num);
+    conn->outlen += num;
+
+    // 大量输出时边执行边发送
+    if (PendingBytes(conn) > server.cfg.highwater)
+        FlushConnection(conn);
+}
+
+// 处理telnet协议和回车换行 返回过滤后的数据长度
+static int FilterInput(Connection* conn, char* buff, int len)
+{
+    TelnetState state = conn->telstate;
+    int num = 0;
+
+    for (int i = 0; i < len; ++i)
+    {
+        uint8_t c = (uint8_t)buff[i];
+        switch (state)
+        {
+        case TELNET_STATE_CR:
+            // 回车后的换行或空字符不重复执行命令
+            state = TELNET_STATE_DATA;
+            if ('\n' == c || '\0' == c)
+                break;
+            /* fall through */
+        case TELNET_STATE_DATA:
+            if (TELNET_IAC == c && conn->telnet)
+                state = TELNET_STATE_IAC;
+            else
+            {
+                if ('\r' == c)
+                    state = TELNET_STATE_CR;
+                buff[num++] = (char)c;
+            }
+            break;
+        case TELNET_STATE_IAC:
+            if (TELNET_IAC == c)
+            {
+                buff[num++] = (char)c;
+                state = TELNET_STATE_DATA;
+            }
+            else if (c >= TELNET_WILL && c <= TELNET_DONT)
+                state = TELNET_STATE_OPT;
+            else if (TELNET_SB == c)
+                state = TELNET_STATE_SB;
+            else
+                state = TELNET_STATE_DATA;
+            break;
+        case TELNET_STATE_OPT:
+            state = TELNET_STATE_DATA;
+            break;
+        case TELNET_STATE_SB:
+            if (TELNET_IAC == c)
+                state = TELNET_STATE_SBIAC;
+            break;
+        case TELNET_STATE_SBIAC:
+            state = TELNET_SE == c ? TELNET_STATE_DATA : TELNET_STATE_SB;
+            break;
+        }
+    }
+    conn->telstate = state;
+    return num;
+}
+
+// 关闭连接并释放资源
+static void CloseConnection(Connection* conn)
+{
+    Reactor* reactor = conn->reactor;
+
+    if (conn->prev)
+        conn->prev->next = conn->next;
+    else
+        reactor->conns = conn->next;
+    if (conn->next)
+        conn->next->prev = conn->prev;
+
+    close(conn->source.fd);
+    uecli_SessionDeinit(conn->session);
+    free(conn->outbuff);
+    free(conn);
+    uecli_atomic_fetch_add(&server.conns, (uint32_t)-1);
+}
+
+// 读取连接上的全部数据并交给会话处理
+static void ReadConnection(Connection* conn)
+{
+    char buff[SERVER_READ_SIZE];
+
+    while (!conn->closing)
+    {
+        // 发送队列过长时暂停读取 数据留在内核缓存中
+        if (PendingBytes(conn) > server.cfg.highwater)
+        {
+            conn->paused = true;
+            conn->readable = true;
+            return;
+        }
+
+        ssize_t len = read(conn->source.fd, buff, sizeof(buff));
+        if (len > 0)
+        {
+            int num = FilterInput(conn, buff, (int)len);
+            uecli_Session* prev = uecli_SessionSelect(conn->session);
+            uecli_ProcessRecChar(buff, num);
+            uecli_SessionSelect(prev);
+            FlushConnection(conn);
+        }
+        else if (0 == len)
+            conn->closing = true;
+        else if (EINTR == errno)
+            continue;
+        else
+        {
+            if (EAGAIN != errno && EWOULDBLOCK != errno)
+                conn->closing = true;
+            break;
+        }
+    }
+    conn->readable = false;
+}
+
+// 接受所有等待的连接
+static void AcceptConnections(Reactor* reactor, Listener* listener)
+{
+    static const uint8_t negotiate[] =
+    {
+        TELNET_IAC, TELNET_WILL, TELNET_ECHO,
+        TELNET_IAC, TELNET_WILL, TELNET_SGA,
+        TELNET_IAC, TELNET_DONT, TELNET_LINEMODE
+    };
+
+    for (;;)
+    {
+        int fd = accept4(listener->source.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (EINTR == errno || ECONNABORTED == errno)
+                continue;
+            if (EAGAIN != errno && EWOULDBLOCK != errno)
+                UECLI_LOG("接受连接出错,错误码%d.", errno);
+            return;
+        }
+
+        // 连接和会话一起分配
+        uint32_t offset = (sizeof(Connection) + 15) & ~15u;
+        Connection* conn = (Connection*)calloc(1, offset + uecli_SessionSize());
+        if (NULL == conn)
+        {
+            close(fd);
+            continue;
+        }
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        conn->source.type = SOURCE_CONN;
+        conn->source.fd = fd;
+        conn->reactor = reactor;
+        conn->session = (uecli_Session*)((char*)conn + offset);
+        conn->telnet = listener->telnet;
+        conn->next = reactor->conns;
+        if (reactor->conns)
+            reactor->conns->prev = conn;
+        reactor->conns = conn;
+        uecli_atomic_fetch_add(&server.conns, 1);
+
+        if (conn->telnet)
+            ConnectionOut(conn, negotiate, sizeof(negotiate));
+        uecli_SessionInit(conn->session, server.cmdlist, ConnectionOut, conn);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &ev))
+        {
+            CloseConnection(conn);
+            continue;
+        }
+        FlushConnection(conn);
+    }
+}
+
+// 处理连接上的事件
+static void ProcessConnection(Connection* conn, uint32_t events)
+{
+    if (events & EPOLLERR)
+        conn->closing = true;
+
+    // 可写 发送队列降到低水位以下时恢复读取
+    if (events & EPOLLOUT)
+    {
+        FlushConnection(conn);
+        if (conn->paused && PendingBytes(conn) <= server.cfg.lowwater)
+        {
+            conn->paused = false;
+            if (conn->readable)
+                ReadConnection(conn);
+        }
+    }
+
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+    {
+        if (conn->paused)
+            conn->readable = true;
+        else
+            ReadConnection(conn);
+    }
+
+    if (conn->closing)
+        CloseConnection(conn);
+}
+
+// 事件循环
+static void* ReactorLoop(void* arg)
+{
+    Reactor* reactor = (Reactor*)arg;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+
+    while (!server.stop)
+    {
+        int num = epoll_wait(reactor->epfd, events, SERVER_MAX_EVENTS, -1);
+        for (int i = 0; i < num; ++i)
+        {
+            EventSource* source = (EventSource*)events[i].data.ptr;
+            switch (source->type)
+            {
+            case SOURCE_LISTEN:
+                AcceptConnections(reactor, (Listener*)source);
+                break;
+            case SOURCE_STOP:
+                break;
+            case SOURCE_CONN:
+                ProcessConnection((Connection*)source, events[i].events);
+                break;
+            }
+        }
+    }
+
+    // 关闭所有连接
+    while (reactor->conns)
+        CloseConnection(reactor->conns);
+    return NULL;
+}
+
+// 创建TCP监听描述符
+static int ListenTcp(const char* host, uint16_t port)
+{
+    struct addrinfo hints, *res;
+    char portstr[8];
+    int fd = -1, on = 1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    snprintf(portstr, sizeof(portstr), "%u", port);
+    if (getaddrinfo(host, portstr, &hints, &res))
+        return -1;
+
+    fd = socket(res->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, res->ai_addr, res->ai_addrlen) || listen(fd, SOMAXCONN))
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// 创建Unix socket监听描述符
+static int ListenUnix(const char* path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, SOMAXCONN)))
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// 添加监听描述符
+static bool AddListener(int fd, bool telnet)
+{
+    if (fd < 0)
+        return false;
+    SetNonBlock(fd);
+
+    Listener* listener = &server.listeners[server.listennum++];
+    listener->source.type = SOURCE_LISTEN;
+    listener->source.fd = fd;
+    listener->telnet = telnet;
+    return true;
+}
+
+// 初始化事件循环
+static bool InitReactor(Reactor* reactor)
+{
+    struct epoll_event ev;
+
+    reactor->conns = NULL;
+    reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+    reactor->stop.type = SOURCE_STOP;
+    reactor->stop.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor->epfd < 0 || reactor->stop.fd < 0)
+        return false;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = &reactor->stop;
+    if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, reactor->stop.fd, &ev))
+        return false;
+
+    // 监听描述符加入所有事件循环 每个连接只唤醒一个线程
+    for (int i = 0; i < server.listennum; ++i)
+    {
+        ev.events = EPOLLIN | (server.reactornum > 1 ? EPOLLEXCLUSIVE : 0);
+        ev.data.ptr = &server.listeners[i];
+        if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, server.listeners[i].source.fd, &ev))
+            return false;
+    }
+    return true;
+}
+
+// 释放监听和事件循环资源
+static void Cleanup(void)
+{
+    for (int i = 0; i < server.reactornum; ++i)
+    {
+        close(server.reactors[i].epfd);
+        close(server.reactors[i].stop.fd);
+    }
+    for (int i = 0; i < server.listennum; ++i)
+        close(server.listeners[i].source.fd);
+    if (server.cfg.unixpath)
+        unlink(server.cfg.unixpath);
+    server.reactornum = 0;
+    server.listennum = 0;
+}
+
+// ********************************************************************************************
+// 接口函数
+
+/**
+ * \brief      启动服务并运行事件循环 直到调用uecli_ServerStop
+ * \details    reactors大于1时另外创建reactors-1个线程，调用线程也运行一个事件循环
+ * \param[in] cfg     服务配置
+ * \param[in] cmdlist 所有会话共用的命令表
+ * \return     启动失败返回false
+ */
+bool uecli_ServerRun(const uecli_ServerConfig* cfg, const uecli_MenuItem* cmdlist)
+{
+    bool result = true;
+
+    server.cfg = *cfg;
+    server.cmdlist = cmdlist;
+    server.stop = 0;
+    if (!server.cfg.highwater)
+        server.cfg.highwater = SERVER_HIGHWATER;
+    if (!server.cfg.lowwater || server.cfg.lowwater > server.cfg.highwater)
+        server.cfg.lowwater = server.cfg.highwater / 4;
+    if (!server.cfg.maxqueue)
+        server.cfg.maxqueue = SERVER_MAXQUEUE;
+
+    server.reactornum = cfg->reactors > 1 ? cfg->reactors : 1;
+    if (server.reactornum > SERVER_MAX_REACTORS)
+        server.reactornum = SERVER_MAX_REACTORS;
+
+    // 创建监听描述符
+    if (cfg->host && !AddListener(ListenTcp(cfg->host, cfg->port), cfg->telnet))
+        result = false;
+    if (cfg->unixpath && !AddListener(ListenUnix(cfg->unixpath), false))
+        result = false;
+    for (int i = 0; result && i < server.reactornum; ++i)
+        result = InitReactor(&server.reactors[i]);
+    if (!result || !server.listennum)
+    {
+        UECLI_LOG("启动服务出错,错误码%d.", errno);
+        Cleanup();
+        return false;
+    }
+
+    // 启动其他事件循环线程
+    int started = 1;
+    for (; started < server.reactornum; ++started)
+    {
+        Reactor* reactor = &server.reactors[started];
+        if (pthread_create(&reactor->thread, NULL, ReactorLoop, reactor))
+            break;
+    }
+    ReactorLoop(&server.reactors[0]);
+
+    for (int i = 1; i < started; ++i)
+        pthread_join(server.reactors[i].thread, NULL);
+    Cleanup();
+    return true;
+}
+
+/**
+ * \brief      停止服务 可在信号处理函数或命令函数中调用
+ */
+void uecli_ServerStop(void)
+{
+    uint64_t value = 1;
+
+    server.stop = 1;
+    for (int i = 0; i < server.reactornum; ++i)
+    {
+        if (write(server.reactors[i].stop.fd, &value, sizeof(value)) < 0)
+            continue;
+    }
+}
+
+/**
+ * \brief      获取当前连接数量
+ * \return     连接数量
+ */
+uint32_t uecli_ServerConnections(void)
+{
+    return uecli_atomic_load(&server.conns);
+}
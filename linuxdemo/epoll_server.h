@@ -0,0 +1,48 @@
+﻿/**
+ * @file     epoll_server.h
+ * @brief    基于epoll的多连接控制台服务
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#ifndef _EPOLL_SERVER_H_
+#define _EPOLL_SERVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "uecli.h"
+
+/// \brief 服务配置
+///
+/// 水位和队列上限为0时使用默认值
+typedef struct
+{
+    const char* host;       ///< TCP监听地址 NULL表示不监听TCP
+    uint16_t port;          ///< TCP监听端口
+    const char* unixpath;   ///< Unix socket路径 NULL表示不监听
+    int reactors;           ///< 事件循环线程数量 小于等于1时只使用调用线程
+    bool telnet;            ///< TCP连接使用telnet协商字符模式
+    uint32_t highwater;     ///< 发送队列高水位 超过后暂停读取该连接的输入
+    uint32_t lowwater;      ///< 发送队列低水位 低于后恢复读取
+    uint32_t maxqueue;      ///< 发送队列上限 超过后丢弃命令输出
+}uecli_ServerConfig;
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool uecli_ServerRun(const uecli_ServerConfig* cfg, const uecli_MenuItem* cmdlist);
+void uecli_ServerStop(void);
+uint32_t uecli_ServerConnections(void);
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,251 @@
+﻿/**
+ * @file     loadgen.c
+ * @brief    控制台服务负载测试
+ * @details
+ * 用法：loadgen [-h 地址] [-p 端口] [-u unix路径] [-i 空闲连接数] [-a 活动连接数] [-d 秒] [-c 命令]
+ * 建立指定数量的空闲连接和活动连接，活动连接收到提示符后立即发送下一条命令，
+ * 从发送命令到收到下一个提示符的时间为一次命令延迟，结果以JSON格式输出
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// 活动连接
+typedef struct
+{
+    int fd;
+    bool sent;          // 已发送命令 等待提示符
+    bool gt;            // 上一个字符为'>'
+    uint64_t start;     // 发送命令的时间
+}Client;
+
+static const char* _host = "127.0.0.1";
+static const char* _port = "2323";
+static const char* _unixpath = NULL;
+static const char* _command = "ping";
+
+// 命令延迟记录
+static uint64_t* _latency = NULL;
+static uint32_t _count = 0;
+static uint32_t _size = 0;
+
+static uint64_t GetTimeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 建立连接 阻塞方式
+static int Connect(void)
+{
+    int fd = -1;
+
+    if (_unixpath)
+    {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, _unixpath, sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)))
+        {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(_host, _port, &hints, &res))
+        return -1;
+    fd = socket(res->ai_family, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen))
+    {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// 记录一次命令延迟
+static void Record(uint64_t ns)
+{
+    if (_count == _size)
+    {
+        _size = _size ? _size * 2 : 65536;
+        _latency = (uint64_t*)realloc(_latency, _size * sizeof(uint64_t));
+    }
+    _latency[_count++] = ns;
+}
+
+static int CompareU64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static double Percentile(uint32_t permille)
+{
+    if (!_count)
+        return 0;
+    uint32_t index = (uint32_t)((uint64_t)_count * permille / 1000);
+    if (index >= _count)
+        index = _count - 1;
+    return _latency[index] / 1000.0;
+}
+
+// 发送命令
+static bool SendCommand(Client* client)
+{
+    char line[256];
+    int len = snprintf(line, sizeof(line), "%s\r", _command);
+
+    client->start = GetTimeNs();
+    client->sent = true;
+    return write(client->fd, line, len) == len;
+}
+
+// 读取数据 每收到一个提示符完成一次命令
+static bool ReadClient(Client* client)
+{
+    char buff[16384];
+
+    for (;;)
+    {
+        ssize_t len = read(client->fd, buff, sizeof(buff));
+        if (0 == len)
+            return false;
+        if (len < 0)
+            return EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno;
+
+        for (ssize_t i = 0; i < len; ++i)
+        {
+            bool prompt = client->gt && '>' == buff[i];
+            client->gt = '>' == buff[i] && !prompt;
+            if (!prompt)
+                continue;
+
+            if (client->sent)
+                Record(GetTimeNs() - client->start);
+            if (!SendCommand(client))
+                return false;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int idle = 0, active = 1, seconds = 5, opt;
+
+    while ((opt = getopt(argc, argv, "h:p:u:i:a:d:c:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'h': _host = optarg; break;
+        case 'p': _port = optarg; break;
+        case 'u': _unixpath = optarg; break;
+        case 'i': idle = atoi(optarg); break;
+        case 'a': active = atoi(optarg); break;
+        case 'd': seconds = atoi(optarg); break;
+        case 'c': _command = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-h host] [-p port] [-u unixpath] [-i idle] [-a active] "
+                "[-d seconds] [-c command]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    struct rlimit rl;
+    if (!getrlimit(RLIMIT_NOFILE, &rl))
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    // 建立空闲连接 只保持连接不收发数据
+    int* idlefd = (int*)calloc(idle ? idle : 1, sizeof(int));
+    int idlenum = 0;
+    for (; idlenum < idle; ++idlenum)
+    {
+        if ((idlefd[idlenum] = Connect()) < 0)
+        {
+            fprintf(stderr, "idle connection %d failed: %s\n", idlenum, strerror(errno));
+            break;
+        }
+    }
+
+    // 建立活动连接
+    int epfd = epoll_create1(0);
+    Client* clients = (Client*)calloc(active ? active : 1, sizeof(Client));
+    int activenum = 0;
+    for (; activenum < active; ++activenum)
+    {
+        Client* client = &clients[activenum];
+        if ((client->fd = Connect()) < 0)
+        {
+            fprintf(stderr, "active connection %d failed: %s\n", activenum, strerror(errno));
+            break;
+        }
+        fcntl(client->fd, F_SETFL, fcntl(client->fd, F_GETFL) | O_NONBLOCK);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = client;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, client->fd, &ev);
+    }
+
+    // 运行指定时间
+    struct epoll_event events[256];
+    uint64_t start = GetTimeNs();
+    uint64_t end = start + (uint64_t)seconds * 1000000000ull;
+    int errors = 0;
+    while (GetTimeNs() < end)
+    {
+        int num = epoll_wait(epfd, events, 256, 100);
+        for (int i = 0; i < num; ++i)
+        {
+            Client* client = (Client*)events[i].data.ptr;
+            if (!ReadClient(client))
+            {
+                ++errors;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, client->fd, NULL);
+            }
+        }
+    }
+    double elapsed = (GetTimeNs() - start) / 1e9;
+
+    qsort(_latency, _count, sizeof(uint64_t), CompareU64);
+    printf("{\"idle\":%d,\"active\":%d,\"seconds\":%.1f,\"requests\":%u,\"errors\":%d,"
+        "\"rps\":%.0f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}\n",
+        idlenum, activenum, elapsed, _count, errors, _count / elapsed,
+        Percentile(500), Percentile(990), Percentile(999), _count ? _latency[_count - 1] / 1000.0 : 0);
+
+    for (int i = 0; i < activenum; ++i)
+        close(clients[i].fd);
+    for (int i = 0; i < idlenum; ++i)
+        close(idlefd[i]);
+    return 0;
+}
@@ -0,0 +1,274 @@
+﻿/**
+ * @file     main.c
+ * @brief    linux平台演示程序
+ * @details
+ * 用法：uecli_demo [设备 [波特率]]
+ * 不指定设备时使用当前终端的标准输入输出
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "uecli.h"
+#include "posix_port.h"
+
+static bool _quit = false;
+
+int estrtoitest(int argc, char** argv)
+{
+    if (argc < 2)
+        return UECLI_STATUS_SYNTAX;
+
+    int32_t temp;
+    int res = estrtoi(argv[1], &temp);
+
+    char tcharbuff[128];
+    esnprintf(tcharbuff, 128, "执行结果：%d %o %x, 返回值：%d\r\n", temp, temp, temp, res);
+    uecli_PrintString(tcharbuff);
+    return res ? UECLI_STATUS_OK : UECLI_STATUS_ERROR;
+}
+
+void testprintf(int argc, char** argv)
+{
+    char tstr[128];
+    tstr[0] = '\0';
+
+    if (argc > 2)
+    {
+        int32_t valu = 0;
+        if (estrtoi(argv[2], &valu))
+            esnprintf(tstr, 128, argv[1], valu);
+        else
+            esnprintf(tstr, 128, "%s", "请输入正确的参数\r\n");
+    }
+    else if (argc > 1)
+        esnprintf(tstr, 128, argv[1]);
+    else
+        esnprintf(tstr, 128, "%s", "请输入正确的参数\r\n");
+
+    uecli_PrintString(tstr);
+}
+
+int decodefun(int argc, char** argv)
+{
+    static uint8_t data[4096];
+    char buff[80];
+    uint32_t errpos = 0;
+    int32_t num;
+
+    if (argc < 3)
+        return UECLI_STATUS_SYNTAX;
+    if (0 == estrcmp(argv[1], "hex"))
+        num = ehexdecode(data, sizeof(data), argv[2], estrlen(argv[2]), &errpos);
+    else if (0 == estrcmp(argv[1], "base64"))
+        num = ebase64decode(data, sizeof(data), argv[2], estrlen(argv[2]), &errpos);
+    else
+        return UECLI_STATUS_SYNTAX;
+
+    if (num < 0)
+    {
+        esnprintf(buff, sizeof(buff), "数据格式错误，位置：%d\r\n", errpos);
+        uecli_PrintString(buff);
+        return UECLI_STATUS_ERROR;
+    }
+
+    // 显示字节数和开头的数据
+    esnprintf(buff, sizeof(buff), "%d字节：", num);
+    uecli_PrintString(buff);
+    ehexencode(buff, sizeof(buff) - 2, data, (uint32_t)num, 1);
+    uecli_PrintString(buff);
+    uecli_PrintString(num > 38 ? "...\r\n" : "\r\n");
+    return UECLI_STATUS_OK;
+}
+
+void menufun(int argc, char** argv)
+{
+    uecli_PrintString("testmenu\r\n");
+    (void)argc;
+    (void)argv;
+}
+
+void quitfun(int argc, char** argv)
+{
+    _quit = true;
+    (void)argc;
+    (void)argv;
+}
+
+#if UECLI_01_ASYNC_LOG>0
+// 后台线程日志参数
+static int32_t _lognum = 100;
+static int32_t _logms = 10;
+
+static void* LogThread(void* arg)
+{
+    for (int32_t i = 0; i < _lognum; ++i)
+    {
+        uecli_Logf("[log] 后台线程日志 %d/%d", i + 1, _lognum);
+        if (_logms > 0)
+            usleep((useconds_t)_logms * 1000);
+    }
+    (void)arg;
+    return NULL;
+}
+
+void logstormfun(int argc, char** argv)
+{
+    pthread_t thread;
+
+    _lognum = 100;
+    _logms = 10;
+    if (argc > 1)
+        estrtoi(argv[1], &_lognum);
+    if (argc > 2)
+        estrtoi(argv[2], &_logms);
+    if (0 == pthread_create(&thread, NULL, LogThread, NULL))
+        pthread_detach(thread);
+}
+#endif
+
+#if UECLI_01_IN_HOOK>0
+// 接收数据统计
+static struct
+{
+    uint64_t bytes;
+    uint32_t sum;       // FNV-1a校验
+    uint64_t start;
+}_recv;
+
+static uint32_t RecvData(void* ctx, const char* buff, uint32_t num)
+{
+    if (0 == _recv.bytes)
+        _recv.start = uecli_gettime_ns();
+    for (uint32_t i = 0; i < num; ++i)
+        _recv.sum = (_recv.sum ^ (uint8_t)buff[i]) * 16777619u;
+    _recv.bytes += num;
+    (void)ctx;
+    return num;
+}
+
+static void RecvEnd(void* ctx, uecli_CaptureEnd reason)
+{
+    static const char* reasonstr[] = {"结束序列", "字节数", "超时", "停止"};
+    uint64_t us = _recv.bytes ? (uecli_gettime_ns() - _recv.start) / 1000 : 0;
+    char buff[128];
+
+    esnprintf(buff, sizeof(buff), "\r\n接收结束(%s)：%d字节 校验%X 用时%dms 速率%dKB/s\r\n",
+        reasonstr[reason], (int32_t)_recv.bytes, _recv.sum, (int32_t)(us / 1000),
+        (int32_t)(us ? _recv.bytes * 1000000 / us / 1024 : 0));
+    uecli_PrintString(buff);
+    (void)ctx;
+}
+
+int recvfun(int argc, char** argv)
+{
+    int32_t bytes = 0;
+    uecli_Capture capture = {RecvData, RecvEnd, NULL, "\x1d", 0, 5000};
+
+    if (argc > 1 && !estrtoi(argv[1], &bytes))
+        return UECLI_STATUS_SYNTAX;
+    capture.bytes = (uint64_t)bytes;
+    _recv.bytes = 0;
+    _recv.sum = 2166136261u;
+    uecli_PrintString("开始接收 Ctrl+]或空闲5秒结束\r\n");
+    return uecli_CaptureStart(&capture) ? UECLI_STATUS_OK : UECLI_STATUS_ERROR;
+}
+#endif
+
+// 逐行生成的大量输出 只有显示到的行才会生成
+static bool DumpNext(uecli_Pager* pager)
+{
+    char buff[96];
+
+    if (pager->index >= pager->cursor)
+        return false;
+    esnprintf(buff, sizeof(buff), "%08X: %08X %08X %08X %08X\r\n", pager->index * 16,
+        pager->index * 2654435761u, pager->index ^ 0x5A5A5A5A, ~pager->index, pager->index << 4);
+    uecli_PrintString(buff);
+    return true;
+}
+
+static void DumpEnd(uecli_Pager* pager)
+{
+    char buff[64];
+
+    esnprintf(buff, sizeof(buff), "[共生成%d行]\r\n", pager->index);
+    uecli_PrintString(buff);
+}
+
+int dumpfun(int argc, char** argv)
+{
+    int32_t lines = 10000;
+    uecli_Pager pager = {DumpNext, DumpEnd, NULL, 0, 0};
+
+    if (argc > 1 && (!estrtoi(argv[1], &lines) || lines < 0))
+        return UECLI_STATUS_SYNTAX;
+    pager.cursor = (uintptr_t)lines;
+    return uecli_PageOutput(&pager);
+}
+
+const uecli_MenuItem submenu[] =
+{
+    UECLI_DECLARE_COMMAND(menufun,"testmenu", "子菜单函数",""),
+    UECLI_DECLARE_END()
+};
+
+const uecli_MenuItem handtalbe[]=
+{
+    UECLI_DECLARE_COMMAND_EX(estrtoitest,"estrtoi", "测试estrtoi"),
+    UECLI_DECLARE_COMMAND(testprintf,"eprintf", "测试eprintf"),
+    UECLI_DECLARE_COMMAND_EX(decodefun,"decode", "解码hex或base64数据 参数为格式和数据"),
+    UECLI_DECLARE_SUBMENU(submenu,"menu1", "子菜单测试"),
+    UECLI_DECLARE_COMMAND_EX(dumpfun,"dump", "分页输出大量数据 参数为行数，默认10000"),
+#if UECLI_01_IN_HOOK>0
+    UECLI_DECLARE_COMMAND_EX(recvfun,"recv", "接收原始数据并统计 参数为字节数"),
+#endif
+#if UECLI_01_ASYNC_LOG>0
+    UECLI_DECLARE_COMMAND(logstormfun,"logstorm", "后台线程输出日志 参数为条数和间隔ms"),
+#endif
+    UECLI_DECLARE_COMMAND(quitfun,"quit", "退出演示程序"),
+    UECLI_DECLARE_END()
+};
+
+int main(int argc, char* argv[])
+{
+    uecli_port_config(argc > 1 ? argv[1] : NULL, argc > 2 ? (uint32_t)atoi(argv[2]) : 0);
+    uecli_Initialize(handtalbe);
+
+    char buff[4096];
+    int len, pending = 0;
+
+    while (!_quit)
+    {
+        /* 等待输入直到下次定时工作 后台日志和暂时不能处理的数据需要定期检查 */
+        int timeout = uecli_NextTimeout();
+#if UECLI_01_ASYNC_LOG>0
+        if (timeout < 0 || timeout > 50)
+            timeout = 50;
+#endif
+        if (pending && (timeout < 0 || timeout > 50))
+            timeout = 50;
+        len = uecli_port_in_timeout(&buff[pending], (uint16_t)(sizeof(buff) - pending), timeout);
+#if UECLI_01_ASYNC_LOG>0
+        uecli_DrainLog();
+#endif
+        if (len < 0)
+            break;
+
+        /* 捕获命令暂时不能接收的数据保留到下次处理 */
+        len += pending;
+        int done = uecli_ProcessInput(buff, len);
+        pending = len - done;
+        memmove(buff, &buff[done], (size_t)pending);
+    }
+    uecli_port_close();
+    return 0;
+}
@@ -0,0 +1,411 @@
+﻿/**
+ * @file     posix_port.c
+ * @brief    POSIX平台底层驱动 支持串口、标准输入输出和伪终端
+ * @details
+ * 终端设备使用termios设置为原始模式，读写均为非阻塞方式：
+ * - 输入通过poll等待，数据到达后一次读取所有可用数据，粘贴的内容可以整块交给uecli处理
+ * - 输出先合并到缓存中，在等待输入前或缓存满时用writev一次发送
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "uecli_cfg.h"
+#include "posix_port.h"
+
+// ********************************************************************************************
+// 内部宏定义
+
+#define POSIX_OUT_BUFFSIZE  (4096)  // 输出合并缓存大小
+
+// ********************************************************************************************
+// 内部变量
+
+// 设备配置
+static const char* _device = NULL;  // 设备路径 NULL表示使用标准输入输出
+static uint32_t _baud = 0;          // 串口波特率 0表示不修改
+
+// 文件描述符
+static int _infd = -1;
+static int _outfd = -1;
+static bool _ownfd = false;         // 设备由本驱动打开，关闭时需要close
+static bool _atexit = false;        // 已注册退出时恢复终端
+
+// 终端原始配置 关闭时恢复
+static struct termios _oldtio;
+static bool _rawmode = false;
+static int _oldflags[2];            // 输入输出描述符原来的文件状态标记
+
+// 输出合并缓存
+static char _outbuff[POSIX_OUT_BUFFSIZE];
+static uint32_t _outlen = 0;
+
+// ********************************************************************************************
+// 内部函数
+
+// 转换波特率
+static speed_t GetSpeed(uint32_t baud)
+{
+    switch (baud)
+    {
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 115200:    return B115200;
+    case 230400:    return B230400;
+#ifdef B460800
+    case 460800:    return B460800;
+#endif
+#ifdef B921600
+    case 921600:    return B921600;
+#endif
+    default:        return B0;
+    }
+}
+
+// 设置终端为原始模式
+static bool SetRawMode(int fd)
+{
+    struct termios tio;
+
+    if (!isatty(fd))
+        return true;
+    if (tcgetattr(fd, &_oldtio))
+        return false;
+
+    tio = _oldtio;
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (_baud && B0 != GetSpeed(_baud))
+    {
+        cfsetispeed(&tio, GetSpeed(_baud));
+        cfsetospeed(&tio, GetSpeed(_baud));
+    }
+    if (tcsetattr(fd, TCSANOW, &tio))
+        return false;
+
+    _rawmode = true;
+    return true;
+}
+
+// 设置非阻塞方式 保存原来的标记
+static void SetNonBlock(int fd, int* oldflags)
+{
+    *oldflags = fcntl(fd, F_GETFL);
+    if (*oldflags >= 0)
+        fcntl(fd, F_SETFL, *oldflags | O_NONBLOCK);
+}
+
+// 等待描述符就绪 timeout为毫秒，负数表示一直等待
+static int WaitFd(int fd, short events, int timeout)
+{
+    struct pollfd pfd;
+    int res;
+
+    pfd.fd = fd;
+    pfd.events = events;
+    do
+    {
+        res = poll(&pfd, 1, timeout);
+    } while (res < 0 && EINTR == errno);
+    return res;
+}
+
+// 发送全部数据 非阻塞写入返回EAGAIN时等待可写
+static void WriteAll(struct iovec* iov, int iovcnt)
+{
+    while (iovcnt)
+    {
+        ssize_t len = writev(_outfd, iov, iovcnt);
+        if (len < 0)
+        {
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+                WaitFd(_outfd, POLLOUT, -1);
+            else if (EINTR != errno)
+            {
+                UECLI_LOG("发送数据出错,错误码%d.", errno);
+                return;
+            }
+            continue;
+        }
+
+        // 跳过已发送的部分
+        for (; iovcnt && (size_t)len >= iov->iov_len; ++iov, --iovcnt)
+            len -= iov->iov_len;
+        if (iovcnt)
+        {
+            iov->iov_base = (char*)iov->iov_base + len;
+            iov->iov_len -= len;
+        }
+    }
+}
+
+// ********************************************************************************************
+// 接口函数
+
+/**
+ * \brief      配置底层设备 需要在uecli_Initialize之前调用
+ * \param[in] device 设备路径，如/dev/ttyUSB0、/dev/pts/3，NULL表示使用标准输入输出
+ * \param[in] baud   串口波特率，0表示不修改
+ */
+void uecli_port_config(const char* device, uint32_t baud)
+{
+    _device = device;
+    _baud = baud;
+}
+
+/**
+ * \brief      底层初始化函数
+ * \details    上层应用调用改函数来完成底层接口的初始化
+ * \return     操作完成返回true，否则返回false
+ */
+bool uecli_port_init(void)
+{
+    if (_device)
+    {
+        _infd = open(_device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (_infd < 0)
+        {
+            UECLI_LOG("打开设备%s出错,错误码%d.", _device, errno);
+            return false;
+        }
+        _outfd = _infd;
+        _ownfd = true;
+    }
+    else
+    {
+        _infd = STDIN_FILENO;
+        _outfd = STDOUT_FILENO;
+        _ownfd = false;
+    }
+
+    if (!SetRawMode(_infd))
+    {
+        UECLI_LOG("设置终端原始模式出错,错误码%d.", errno);
+        uecli_port_close();
+        return false;
+    }
+    SetNonBlock(_infd, &_oldflags[0]);
+    if (_outfd != _infd)
+        SetNonBlock(_outfd, &_oldflags[1]);
+    if (!_atexit)
+        _atexit = (0 == atexit(uecli_port_close));
+    return true;
+}
+
+/**
+ * \brief      调用该函数以发送数据
+ * \details    小块数据先合并到缓存中，在等待输入前统一发送
+ * \param[in] buff   待发送内存区
+ * \param[in] num    发送数据数量
+ */
+void uecli_port_out(const void* buff, uint32_t num)
+{
+    if (_outfd < 0)
+        return;
+
+    if (_outlen + num <= POSIX_OUT_BUFFSIZE)
+    {
+        memcpy(&_outbuff[_outlen], buff, num);
+        _outlen += num;
+        return;
+    }
+
+    // 缓存不足 缓存数据和新数据一起发送
+    struct iovec iov[2];
+    iov[0].iov_base = _outbuff;
+    iov[0].iov_len = _outlen;
+    iov[1].iov_base = (void*)buff;
+    iov[1].iov_len = num;
+    WriteAll(_outlen ? iov : &iov[1], _outlen ? 2 : 1);
+    _outlen = 0;
+}
+
+/**
+ * \brief      发送缓存中的全部数据
+ */
+void uecli_port_flush(void)
+{
+    if (_outlen && _outfd >= 0)
+    {
+        struct iovec iov;
+        iov.iov_base = _outbuff;
+        iov.iov_len = _outlen;
+        WriteAll(&iov, 1);
+    }
+    _outlen = 0;
+}
+
+/**
+* \brief      读取数据 等待前先发送缓存的输出数据
+* \param[in] buff 保存接收数据内存区
+* \param[in] maxnum 最大接收数据数量
+* \param[in] timeout 超时时间ms，负数表示一直等待，0表示不等待
+* \return     返回实际读取数据数量，超时返回0，设备关闭或出错返回-1
+*/
+int uecli_port_in_timeout(void* buff, uint16_t maxnum, int timeout)
+{
+    char* pbuff = (char*)buff;
+    int len = 0;
+
+    uecli_port_flush();
+    if (_infd < 0)
+        return -1;
+
+    int res = WaitFd(_infd, POLLIN, timeout);
+    if (res <= 0)
+        return res;
+
+    // 读取所有可用数据
+    while (len < maxnum)
+    {
+        ssize_t num = read(_infd, pbuff + len, maxnum - len);
+        if (num > 0)
+            len += (int)num;
+        else if (0 == num)
+            return len ? len : -1;
+        else if (EINTR == errno)
+            continue;
+        else if (EAGAIN == errno || EWOULDBLOCK == errno)
+            break;
+        else
+            return len ? len : -1;
+    }
+    return len;
+}
+
+/**
+* \brief      读取数据 没有数据时一直等待
+* \param[in] buff 保存接收数据内存区
+* \param[in] maxnum 最大接收数据数量
+* \return     返回实际读取数据数量，设备关闭或出错返回-1
+*/
+int uecli_port_in(void* buff, uint16_t maxnum)
+{
+    int len;
+
+    do
+    {
+        len = uecli_port_in_timeout(buff, maxnum, -1);
+    } while (0 == len);
+    return len;
+}
+
+/**
+* \brief      获取输入文件描述符 用于加入外部事件循环
+* \return     文件描述符，未初始化返回-1
+*/
+int uecli_port_fd(void)
+{
+    return _infd;
+}
+
+/**
+* \brief      非阻塞读取 供uecli_OnReadable使用
+* \param[in] buff 保存接收数据内存区
+* \param[in] num 最大接收数据数量
+* \return     返回实际读取数据数量，暂无数据返回0，设备关闭或出错返回-1
+*/
+int uecli_port_read(void* buff, uint32_t num)
+{
+    for (;;)
+    {
+        ssize_t len = _infd < 0 ? -1 : read(_infd, buff, num);
+        if (len > 0)
+            return (int)len;
+        if (len < 0 && EINTR == errno)
+            continue;
+        return (len < 0 && (EAGAIN == errno || EWOULDBLOCK == errno)) ? 0 : -1;
+    }
+}
+
+/**
+* \brief      非阻塞发送 供uecli非阻塞接口使用，不经过合并缓存
+* \param[in] buff 待发送内存区
+* \param[in] num 发送数据数量
+* \return     返回实际发送数量，可能小于num，设备出错返回-1
+*/
+int uecli_port_write(const void* buff, uint32_t num)
+{
+    for (;;)
+    {
+        ssize_t len = _outfd < 0 ? -1 : write(_outfd, buff, num);
+        if (len >= 0)
+            return (int)len;
+        if (EINTR == errno)
+            continue;
+        return (EAGAIN == errno || EWOULDBLOCK == errno) ? 0 : -1;
+    }
+}
+
+/**
+* \brief      获取等待指定事件的文件描述符
+* \param[in] event POLLIN或POLLOUT
+* \return     文件描述符，未初始化返回-1
+*/
+int uecli_port_pollfd(uint32_t event)
+{
+    return (event & POLLOUT) ? _outfd : _infd;
+}
+
+/**
+* \brief      关闭设备 恢复终端配置
+*/
+void uecli_port_close(void)
+{
+    uecli_port_flush();
+    if (_infd < 0)
+        return;
+
+    if (_rawmode)
+        tcsetattr(_infd, TCSANOW, &_oldtio);
+    _rawmode = false;
+
+    if (_ownfd)
+        close(_infd);
+    else
+    {
+        fcntl(_infd, F_SETFL, _oldflags[0]);
+        if (_outfd != _infd)
+            fcntl(_outfd, F_SETFL, _oldflags[1]);
+    }
+    _infd = _outfd = -1;
+}
+
+/**
+* \brief      获取单调时钟计数
+* \return     返回纳秒计数
+*/
+uint64_t uecli_port_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+* \brief      estring中eprintf的字符输出接口
+*/
+void eputchar(char chr)
+{
+    uecli_port_out(&chr, 1);
+}
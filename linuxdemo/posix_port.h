@@ -0,0 +1,36 @@
+﻿/**
+ * @file     posix_port.h
+ * @brief    POSIX平台底层驱动 支持串口、标准输入输出和伪终端
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#ifndef _POSIX_PORT_H_
+#define _POSIX_PORT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void uecli_port_config(const char* device, uint32_t baud);
+int uecli_port_in(void* buff, uint16_t maxnum);
+int uecli_port_in_timeout(void* buff, uint16_t maxnum, int timeout);
+void uecli_port_flush(void);
+int uecli_port_fd(void);
+void uecli_port_close(void);
+uint64_t uecli_port_time_ns(void);
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+﻿/**
+ * @file     pty_demo.c
+ * @brief    通过伪终端对驱动进行自检
+ * @details
+ * 在进程内创建一对伪终端，uecli使用从设备，程序从主设备模拟用户输入并检查回显，
+ * 无需真实串口硬件即可验证原始模式、整块读取和合并输出。全部检查通过返回0
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "uecli.h"
+#include "posix_port.h"
+
+static int _lines = 0;
+
+void linefun(int argc, char** argv)
+{
+    ++_lines;
+    uecli_PrintString(argc > 1 ? argv[1] : "line");
+    uecli_PrintString("\r\n");
+}
+
+const uecli_MenuItem handtalbe[]=
+{
+    UECLI_DECLARE_COMMAND(linefun,"line", "打印参数"),
+    UECLI_DECLARE_END()
+};
+
+// 读取主设备上的全部输出
+static int ReadMaster(int fd, char* buff, int size)
+{
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int len = 0;
+
+    while (len < size - 1 && poll(&pfd, 1, 100) > 0)
+    {
+        ssize_t num = read(fd, buff + len, size - 1 - len);
+        if (num <= 0)
+            break;
+        len += (int)num;
+    }
+    buff[len] = '\0';
+    return len;
+}
+
+// 模拟用户输入并处理
+static int Exchange(int master, const char* input, char* output, int size)
+{
+    char buff[4096];
+    int len;
+
+    if (write(master, input, strlen(input)) < 0)
+        return -1;
+    len = uecli_port_in_timeout(buff, sizeof(buff), 1000);
+    if (len > 0)
+        uecli_ProcessRecChar(buff, len);
+    uecli_port_flush();
+    ReadMaster(master, output, size);
+    return len;
+}
+
+static int _failed = 0;
+
+static void Check(bool cond, const char* name)
+{
+    printf("%s: %s\n", cond ? "PASS" : "FAIL", name);
+    if (!cond)
+        ++_failed;
+}
+
+int main(void)
+{
+    static char output[65536];
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master))
+    {
+        perror("posix_openpt");
+        return 2;
+    }
+
+    uecli_port_config(ptsname(master), 115200);
+    uecli_Initialize(handtalbe);
+    uecli_port_flush();
+    ReadMaster(master, output, sizeof(output));
+    Check(NULL != strstr(output, ">>"), "初始化后输出提示符");
+
+    // 原始模式下回车不会被转换，输入立即到达
+    Exchange(master, "line hello\r", output, sizeof(output));
+    Check(1 == _lines && NULL != strstr(output, "line hello\r\nhello"), "单行命令回显和输出");
+
+    // 整块粘贴的多行命令一次读取并逐行执行
+    char paste[2048] = "";
+    for (int i = 0; i < 50; ++i)
+        strcat(paste, "line paste\r");
+    int len = Exchange(master, paste, output, sizeof(output));
+    Check((int)strlen(paste) == len, "粘贴内容一次读取");
+    Check(51 == _lines, "粘贴的多行命令全部执行");
+
+    // 退格键发送的DEL删除字符
+    Exchange(master, "linx\x7f" "e del\r", output, sizeof(output));
+    Check(52 == _lines && NULL != strstr(output, "del"), "DEL作为退格处理");
+
+    // 主设备关闭后读取返回错误
+    close(master);
+    char buff[16];
+    Check(uecli_port_in_timeout(buff, sizeof(buff), 1000) < 0, "对端关闭后返回-1");
+
+    uecli_port_close();
+    return _failed ? 1 : 0;
+}
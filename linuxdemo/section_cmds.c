@@ -0,0 +1,51 @@
+﻿/**
+ * @file     section_cmds.c
+ * @brief    链接段命令注册演示 其他模块中定义的命令
+ * @details
+ * 模块只需定义命令，不需要修改主程序的命令表
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include "uecli.h"
+
+static uint32_t _counter = 0;
+
+static void countfun(int argc, char** argv)
+{
+    char buff[32];
+    esnprintf(buff, sizeof(buff), "%d" UECLI_NEWLINE, ++_counter);
+    uecli_PrintString(buff);
+    (void)argc;
+    (void)argv;
+}
+
+static int resetfun(int argc, char** argv)
+{
+    int32_t value = 0;
+    if (argc > 1 && !estrtoi(argv[1], &value))
+        return UECLI_STATUS_SYNTAX;
+    _counter = (uint32_t)value;
+    return UECLI_STATUS_OK;
+}
+
+static void hellofun(int argc, char** argv)
+{
+    uecli_PrintString("hello" UECLI_NEWLINE);
+    (void)argc;
+    (void)argv;
+}
+
+static const uecli_MenuItem _greetmenu[] =
+{
+    UECLI_DECLARE_COMMAND(hellofun, "hello", "打招呼"),
+    UECLI_DECLARE_END()
+};
+
+UECLI_COMMAND(count, countfun, "计数加1并显示");
+UECLI_COMMAND_EX(reset, resetfun, "设置计数", "reset [初始值]");
+UECLI_COMMAND_MENU(greet, _greetmenu, "问候菜单");
@@ -0,0 +1,54 @@
+﻿/**
+ * @file     section_demo.c
+ * @brief    链接段命令注册演示程序
+ * @details
+ * 用法：section_demo [设备 [波特率]]，需要开启UECLI_01_SECTION
+ * 命令分散在section_demo.c和section_cmds.c中以UECLI_COMMAND定义，没有集中的命令表，
+ * 不生成索引时逐项查找，以tools/uecli_index生成索引后按哈希查找
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uecli.h"
+#include "posix_port.h"
+
+static bool _quit = false;
+
+void quitfun(int argc, char** argv)
+{
+    _quit = true;
+    (void)argc;
+    (void)argv;
+}
+
+UECLI_COMMAND(quit, quitfun, "退出程序");
+
+int main(int argc, char* argv[])
+{
+    uecli_port_config(argc > 1 ? argv[1] : NULL, argc > 2 ? (uint32_t)atoi(argv[2]) : 0);
+    uecli_Initialize(NULL);     /* 所有命令都在链接段中 */
+
+    char buff[1024];
+    int len, pending = 0;
+
+    while (!_quit)
+    {
+        len = uecli_port_in(&buff[pending], (uint16_t)(sizeof(buff) - pending));
+        if (len < 0)
+            break;
+
+        len += pending;
+        int done = uecli_ProcessInput(buff, len);
+        pending = len - done;
+        memmove(buff, &buff[done], (size_t)pending);
+    }
+    uecli_port_close();
+    return 0;
+}
@@ -0,0 +1,138 @@
+﻿/**
+ * @file     server_demo.c
+ * @brief    多连接控制台服务演示程序
+ * @details
+ * 用法：server_demo [-p 端口] [-u unix路径] [-t 线程数] [-n]
+ * 默认在127.0.0.1:2323上以telnet方式提供控制台，-n关闭telnet协商
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "uecli.h"
+#include "epoll_server.h"
+
+// 服务模式下没有本地端口 以下接口只用于默认会话
+bool uecli_port_init(void)
+{
+    return true;
+}
+
+void uecli_port_out(const void* buff, uint32_t num)
+{
+    (void)buff;
+    (void)num;
+}
+
+uint64_t uecli_port_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void eputchar(char chr)
+{
+    putchar(chr);
+}
+
+void pingfun(int argc, char** argv)
+{
+    uecli_PrintString("pong\r\n");
+    (void)argc;
+    (void)argv;
+}
+
+void whofun(int argc, char** argv)
+{
+    char buff[64];
+    esnprintf(buff, sizeof(buff), "%d connections, this is %X\r\n",
+        uecli_ServerConnections(), (uint32_t)(uintptr_t)uecli_SessionContext());
+    uecli_PrintString(buff);
+    (void)argc;
+    (void)argv;
+}
+
+void dumpfun(int argc, char** argv)
+{
+    int32_t lines = 1000;
+    char buff[64];
+
+    if (argc > 1)
+        estrtoi(argv[1], &lines);
+    for (int32_t i = 0; i < lines && !uecli_IsCancelled(); ++i)
+    {
+        esnprintf(buff, sizeof(buff), "line %d 0123456789abcdef\r\n", i);
+        uecli_PrintString(buff);
+    }
+}
+
+void shutdownfun(int argc, char** argv)
+{
+    uecli_ServerStop();
+    (void)argc;
+    (void)argv;
+}
+
+const uecli_MenuItem handtalbe[]=
+{
+    UECLI_DECLARE_COMMAND(pingfun,"ping", "返回pong"),
+    UECLI_DECLARE_COMMAND(whofun,"who", "显示连接数量"),
+    UECLI_DECLARE_COMMAND(dumpfun,"dump", "输出指定行数的数据"),
+    UECLI_DECLARE_COMMAND(shutdownfun,"shutdown", "停止服务"),
+    UECLI_DECLARE_END()
+};
+
+static void OnSignal(int sig)
+{
+    uecli_ServerStop();
+    (void)sig;
+}
+
+int main(int argc, char* argv[])
+{
+    uecli_ServerConfig cfg;
+    int opt;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.host = "127.0.0.1";
+    cfg.port = 2323;
+    cfg.telnet = true;
+    cfg.reactors = 1;
+    while ((opt = getopt(argc, argv, "p:u:t:n")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': cfg.port = (uint16_t)atoi(optarg); break;
+        case 'u': cfg.unixpath = optarg; break;
+        case 't': cfg.reactors = atoi(optarg); break;
+        case 'n': cfg.telnet = false; break;
+        default:
+            fprintf(stderr, "usage: %s [-p port] [-u unixpath] [-t threads] [-n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // 大量连接时需要提高描述符数量上限
+    struct rlimit rl;
+    if (!getrlimit(RLIMIT_NOFILE, &rl))
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    return uecli_ServerRun(&cfg, handtalbe) ? 0 : 1;
+}
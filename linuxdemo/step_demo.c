@@ -0,0 +1,121 @@
+﻿/**
+ * @file     step_demo.c
+ * @brief    在外部事件循环中使用非阻塞单步接口
+ * @details
+ * 用法：step_demo [设备路径] [波特率]，需要开启UECLI_01_STEP
+ * 事件循环同时等待控制台和一个100ms的定时器，控制台的读写都不会阻塞循环，
+ * 输出过多端口暂时不能写入时数据进入发送队列，端口可写后再继续发送
+ * @author   张诗星
+ * @par
+ * (C) Copyright 杭州大仁科技有限公司
+ * @version
+ * 2017/07/28 张诗星 修订说明\n
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "uecli.h"
+#include "posix_port.h"
+
+static bool _quit = false;
+static uint32_t _ticks = 0;
+
+void ticksfun(int argc, char** argv)
+{
+    char buff[48];
+    esnprintf(buff, sizeof(buff), "%d ticks\r\n", _ticks);
+    uecli_PrintString(buff);
+    (void)argc;
+    (void)argv;
+}
+
+void dumpfun(int argc, char** argv)
+{
+    int32_t lines = 100;
+    char buff[64];
+
+    if (argc > 1)
+        estrtoi(argv[1], &lines);
+    for (int32_t i = 0; i < lines; ++i)
+    {
+        esnprintf(buff, sizeof(buff), "line %d 0123456789abcdef\r\n", i);
+        uecli_PrintString(buff);
+    }
+}
+
+void quitfun(int argc, char** argv)
+{
+    _quit = true;
+    (void)argc;
+    (void)argv;
+}
+
+const uecli_MenuItem handtalbe[]=
+{
+    UECLI_DECLARE_COMMAND(ticksfun,"ticks", "显示定时器计数"),
+    UECLI_DECLARE_COMMAND(dumpfun,"dump", "输出指定行数的数据"),
+    UECLI_DECLARE_COMMAND(quitfun,"quit", "退出程序"),
+    UECLI_DECLARE_END()
+};
+
+int main(int argc, char* argv[])
+{
+    uecli_port_config(argc > 1 ? argv[1] : NULL, argc > 2 ? (uint32_t)atoi(argv[2]) : 0);
+    uecli_Initialize(handtalbe);
+
+    // 其他事件源 这里用定时器代替
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    struct itimerspec its = { { 0, 100000000 }, { 0, 100000000 } };
+    timerfd_settime(timer, 0, &its, NULL);
+
+    while (!_quit)
+    {
+        // 每次循环重新获取需要等待的事件 输入输出可能是不同的描述符
+        struct pollfd fds[3];
+        int num = 0;
+        uint32_t events = uecli_PollEvents();
+
+        fds[num].fd = timer;
+        fds[num++].events = POLLIN;
+        fds[num].fd = uecli_PollFd(UECLI_POLLIN);
+        fds[num++].events = POLLIN;
+        if (events & UECLI_POLLOUT)
+        {
+            fds[num].fd = uecli_PollFd(UECLI_POLLOUT);
+            fds[num++].events = POLLOUT;
+        }
+
+        if (poll(fds, num, -1) < 0)
+            continue;
+
+        if (fds[0].revents & POLLIN)
+        {
+            uint64_t expired;
+            if (read(timer, &expired, sizeof(expired)) == sizeof(expired))
+                _ticks += (uint32_t)expired;
+        }
+        for (int i = 1; i < num; ++i)
+        {
+            if ((fds[i].revents & POLLOUT) || ((fds[i].revents & POLLERR) && (fds[i].events & POLLOUT)))
+                uecli_OnWritable();
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && (fds[i].events & POLLIN) && !uecli_OnReadable())
+                _quit = true;
+        }
+    }
+
+    // 退出前发送剩余的数据
+    while (uecli_PollEvents() & UECLI_POLLOUT)
+    {
+        struct pollfd pfd = { uecli_PollFd(UECLI_POLLOUT), POLLOUT, 0 };
+        if (poll(&pfd, 1, 1000) <= 0)
+            break;
+        uecli_OnWritable();
+    }
+    close(timer);
+    uecli_port_close();
+    return 0;
+}
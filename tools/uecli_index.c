@@ -0,0 +1,192 @@
+﻿/// \file uecli_index.c
+/// \brief 链接段命令索引生成工具
+///
+/// \details
+/// 用法：nm 目标文件或库... | uecli_index > uecli_index.c
+/// 从nm的输出中收集UECLI_COMMAND定义的uecli_cmd_*符号，生成按名称排序的命令列表和哈希索引，
+/// 寻找使所有命令都不冲突的哈希种子。生成的文件与其他目标文件一起链接，索引放在uecli_index段中。
+/// 名称只有大小写不同时报告错误并返回1，与系统命令同名时给出警告
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/28 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ********************************************************************************************
+// 宏定义
+
+#define SYMBOL_PREFIX   "uecli_cmd_"    // UECLI_COMMAND定义的符号前缀
+#define MAX_COMMANDS    (4096)          // 最大命令数量
+#define MAX_SEED        (256)           // 寻找无冲突种子的次数
+
+// ********************************************************************************************
+// 内部变量
+
+static char* _names[MAX_COMMANDS];
+static int _count = 0;
+static int _slots[MAX_COMMANDS * 2];    // 命令序号加1 0为空槽
+
+// ********************************************************************************************
+// 内部函数
+
+static char ToLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+// 不区分大小写比较 与estrcmpNocase的顺序相同
+static int CompareNocase(const char* a, const char* b)
+{
+    for (; ToLower(*a) == ToLower(*b); ++a, ++b)
+    {
+        if ('\0' == *a)
+            return 0;
+    }
+    return (unsigned char)ToLower(*a) < (unsigned char)ToLower(*b) ? -1 : 1;
+}
+
+static int CompareName(const void* a, const void* b)
+{
+    return CompareNocase(*(char* const*)a, *(char* const*)b);
+}
+
+// 与uecli_HashName相同
+static uint32_t HashName(const char* name, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (; '\0' != *name; ++name)
+        hash = (hash ^ (uint8_t)ToLower(*name)) * 16777619u;
+    return hash;
+}
+
+// 以指定种子放入索引 probe为0时遇到冲突返回0
+static int PlaceSlots(uint32_t seed, uint32_t mask, int probe)
+{
+    memset(_slots, 0, sizeof(_slots));
+    for (int i = 0; i < _count; ++i)
+    {
+        uint32_t pos = HashName(_names[i], seed);
+        for (; _slots[pos & mask]; ++pos)
+        {
+            if (!probe)
+                return 0;
+        }
+        _slots[pos & mask] = i + 1;
+    }
+    return 1;
+}
+
+// 加入一个命令 已存在时忽略
+static void AddName(const char* name)
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        if (!strcmp(_names[i], name))
+            return;
+    }
+    if (_count >= MAX_COMMANDS)
+    {
+        fprintf(stderr, "uecli_index: 命令数量超过%d\n", MAX_COMMANDS);
+        exit(1);
+    }
+    _names[_count] = malloc(strlen(name) + 1);
+    strcpy(_names[_count++], name);
+}
+
+// 解析nm输出的一行 格式为"[地址] 类型 符号"
+static void ParseLine(char* line)
+{
+    char* tokens[3];
+    int num = 0;
+
+    for (char* p = strtok(line, " \t\r\n"); p; p = strtok(NULL, " \t\r\n"))
+    {
+        if (num == 3)
+            return;
+        tokens[num++] = p;
+    }
+    if (num < 2 || strlen(tokens[num - 2]) != 1)
+        return;
+
+    // 只收集已定义的全局符号
+    char type = tokens[num - 2][0];
+    const char* symbol = tokens[num - 1];
+    if (type < 'A' || type > 'Z' || 'U' == type || 'W' == type || 'V' == type)
+        return;
+    if (strncmp(symbol, SYMBOL_PREFIX, sizeof(SYMBOL_PREFIX) - 1) || !symbol[sizeof(SYMBOL_PREFIX) - 1])
+        return;
+    AddName(&symbol[sizeof(SYMBOL_PREFIX) - 1]);
+}
+
+// ********************************************************************************************
+// 主函数
+
+int main(void)
+{
+    static const char* const reserved[] = {"help", "ver", "cls", "stats", "trace", "format", "watch",
+        "every", "at", "sched", "more"};
+    char line[1024];
+    int error = 0;
+
+    while (fgets(line, sizeof(line), stdin))
+        ParseLine(line);
+
+    // 排序并检查名称
+    qsort(_names, (size_t)_count, sizeof(_names[0]), CompareName);
+    for (int i = 0; i < _count; ++i)
+    {
+        if (i && !CompareNocase(_names[i], _names[i - 1]))
+        {
+            fprintf(stderr, "uecli_index: 错误: 命令%s和%s只有大小写不同\n", _names[i - 1], _names[i]);
+            error = 1;
+        }
+        for (size_t j = 0; j < sizeof(reserved) / sizeof(reserved[0]); ++j)
+        {
+            if (!CompareNocase(_names[i], reserved[j]))
+                fprintf(stderr, "uecli_index: 警告: 命令%s与系统命令同名，系统命令优先\n", _names[i]);
+        }
+    }
+    if (error)
+        return 1;
+
+    printf("/* 由uecli_index生成 不要修改 */\n");
+    printf("#include \"uecli.h\"\n");
+    if (!_count)
+        return 0;
+
+    // 寻找没有冲突的种子 找不到时使用种子0线性探测
+    uint32_t slotcount = 2, seed = 0;
+    while (slotcount < (uint32_t)_count * 2)
+        slotcount *= 2;
+    for (; seed < MAX_SEED && !PlaceSlots(seed, slotcount - 1, 0); ++seed);
+    if (seed == MAX_SEED)
+        PlaceSlots(seed = 0, slotcount - 1, 1);
+
+    printf("\n");
+    for (int i = 0; i < _count; ++i)
+        printf("extern const uecli_MenuItem " SYMBOL_PREFIX "%s;\n", _names[i]);
+
+    printf("\nstatic const uecli_MenuItem* const slots[%u] =\n{\n", slotcount);
+    for (uint32_t i = 0; i < slotcount; ++i)
+    {
+        if (_slots[i])
+            printf("    &" SYMBOL_PREFIX "%s,\n", _names[_slots[i] - 1]);
+        else
+            printf("    0,\n");
+    }
+    printf("};\n\nstatic const uecli_MenuItem* const order[%d] =\n{\n", _count);
+    for (int i = 0; i < _count; ++i)
+        printf("    &" SYMBOL_PREFIX "%s,\n", _names[i]);
+    printf("};\n\nUECLI_SECTION_INDEX(%uu, %uu, %du, slots, order);\n", seed, slotcount - 1, _count);
+    return 0;
+}
@@ -1,212 +1,695 @@
 /// \file uecli.c
-/// \brief ļ
+/// \brief 核心文件
 ///
 /// \details
-/// uecli Ƕʽнӿ֧ģ
-/// ֧ȫʷ¼Ӳ˵Ϣ
+/// uecli 是嵌入式精简的命令行接口支持模块
+/// 其支持命令补全、历史记录、子菜单、长帮助信息等特性
 ///
-/// \author ʫ
+/// \author 张诗星
 /// \par
-/// (C) Copyright ݴʿƼ޹˾
+/// (C) Copyright 杭州大仁科技有限公司
 ///
 /// \version
-/// 2017/07/24 ʫ ʼ汾\n
+/// 2017/07/24 张诗星 初始版本\n
 
 // ********************************************************************************************
-// ͷļ
+// 头文件
 
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 
 #include "uecli.h"
+#include "uecli_trace.h"
 
 // ********************************************************************************************
-// ڲ궨
+// 内部宏定义
 
-// ѭݼ
+// 循环递减
 #define CYCLE_DECREMENT(X,MAXVALU) ((X)>0 ? ((X)-1) : (MAXVALU))
 
-// ѭ
+// 循环递增
 #define CYCLE_INCREMENT(X,MAXVALU) ((X)<(MAXVALU) ? ((X)+1) : 0)
 
-// Чʷ¼
+// 无效的历史记录索引
 #define INVALID_HISTORY_INDEX   (-1)
 
 // ********************************************************************************************
-// ڲͶ
+// 内部类型定义
 
 
-// ַ.
+// 基于索引的字符串类型.
 //
-// ɿٻȡȣٸӡɾַ
+// 可快速获取长度，快速附加、删减字符
 typedef struct
 {
-    char str[UECLI_CFG_STR_MAXLEN];    // ַ
-    int length;     // ַ
+#if UECLI_01_LONG_LINE>0
+    char* str;      // 动态分配的缓存 NULL表示使用内置缓存
+    int size;       // 动态缓存大小
+    char buff[UECLI_CFG_STR_MAXLEN];   // 内置缓存 短命令行不分配内存
+#else
+    char str[UECLI_CFG_STR_MAXLEN];    // 命令行输入字符串缓存
+#endif
+    int length;     // 字符串长度
 }IdxString;
 
-// cliнӿڶ
-static struct uecli_Type
+#if UECLI_01_PIPE>0
+// 管道过滤器类型
+typedef enum
+{
+    PIPE_FILTER_GREP = 0,   // 按行匹配字符串
+    PIPE_FILTER_HEAD,       // 只输出前N行
+    PIPE_FILTER_COUNT,      // 统计行数
+    PIPE_FILTER_NUM
+}PipeFilterType;
+
+// 管道过滤级.
+//
+// 上一级的输出按行缓存在行缓存中，整行到达后再过滤并传递给下一级
+typedef struct
+{
+    PipeFilterType type;    // 过滤器类型
+    const char* pattern;    // grep匹配字符串
+    bool invert;            // grep -v 输出不匹配的行
+    bool nocase;            // grep -i 忽略大小写
+    int32_t limit;          // head 最大输出行数
+    int32_t count;          // 已处理行数
+    char line[UECLI_CFG_PIPE_LINELEN];  // 行缓存 超长行将被截断
+    int length;             // 行缓存长度
+}PipeStage;
+#endif
+
+#if UECLI_01_SEQUENCE>0
+// 命令序列连接符
+typedef enum
+{
+    SEQUENCE_ALWAYS = 0,    // ;或行首 总是执行
+    SEQUENCE_AND,           // && 上一条命令成功时执行
+    SEQUENCE_OR             // || 上一条命令失败时执行
+}SequenceType;
+#endif
+
+#if UECLI_01_STATS>0
+// 延迟直方图 每个2的幂区间线性细分为STATS_SUBCOUNT个桶
+#define STATS_SUBCOUNT  (1 << UECLI_CFG_STATS_SUBBITS)
+#define STATS_BUCKETS   ((UECLI_CFG_STATS_MAXBITS - UECLI_CFG_STATS_SUBBITS + 1) << UECLI_CFG_STATS_SUBBITS)
+
+// 命令执行统计
+typedef struct
+{
+    const uecli_MenuItem* item;     // 统计的命令 NULL表示空闲
+    uint32_t calls;                 // 调用次数
+    uint64_t maxns;                 // 最大耗时
+    uint64_t bytes;                 // 输出字节数
+    uint32_t hist[STATS_BUCKETS];   // 耗时直方图 单位ns
+}CmdStats;
+#endif
+
+#if UECLI_01_SCHED>0
+// 分层时间轮 每级SCHED_SLOTS个槽，共覆盖2^(SCHED_BITS*SCHED_LEVELS)个节拍
+#define SCHED_BITS      (5)
+#define SCHED_SLOTS     (1 << SCHED_BITS)
+#define SCHED_LEVELS    (5)
+#define SCHED_RANGE     (1u << (SCHED_BITS * SCHED_LEVELS))
+#define SCHED_TICKNS    ((uint64_t)UECLI_CFG_SCHED_TICK * 1000000u)
+
+// 定时命令所在的链表 时间轮的槽为1到SCHED_LEVELS*SCHED_SLOTS
+#define SCHED_FREE      (0)                             // 空闲
+#define SCHED_RUN       (SCHED_LEVELS * SCHED_SLOTS + 1)// 已到期等待执行
+#define SCHED_EXEC      (SCHED_RUN + 1)                 // 正在执行 不在任何链表中
+
+// 定时命令 以编号组成双向链表，编号从1开始，0表示没有
+typedef struct
+{
+    uint16_t next;              // 链表中的下一项
+    uint16_t prev;              // 链表中的上一项
+    uint16_t list;              // 所在链表
+    uint32_t expire;            // 到期节拍
+    uint32_t period;            // 周期节拍数 0表示只执行一次
+    char line[UECLI_CFG_STR_MAXLEN];    // 执行的命令行
+}SchedTimer;
+#endif
+
+#if UECLI_01_HELP_CACHE>0
+// 渲染好的一级菜单的帮助 命令表、格式或命令表版本改变后重新渲染
+typedef struct
+{
+    const uecli_MenuItem* list;     // 该级菜单的命令表
+    char* text;                     // 帮助文本 按需分配
+    uint32_t len;                   // 文本长度
+    uint32_t size;                  // 分配的大小
+    uint32_t lines;                 // 行数
+    uint32_t gen;                   // 渲染时的命令表版本
+    uint8_t width;                  // 渲染时的名称列宽
+    bool valid;                     // 缓存有效
+    bool overflow;                  // 超过上限 不能缓存
+}HelpCache;
+#endif
+
+#if UECLI_01_REDIRECT>0
+// 重定向状态 嵌套执行的命令重定向时保存外层命令的状态
+typedef struct
+{
+    void* file;                 // 重定向文件句柄
+    uint32_t bytes;             // 已写入的字节数
+    uint64_t start;             // 开始时间
+}RedirectState;
+#endif
+
+// cli命令行接口对象
+struct uecli_Type
 {
-    
-    IdxString instring;                     // ûַ
-    char tmpString[UECLI_CFG_TEMP_MAXLEN];   // ڲʱַ
-    char prompt[UECLI_CFG_MAX_POMPTLINE];   // ʾַ
-    const uecli_MenuItem* cmdlist;            // бָ
 
-    // 빳֧
+    IdxString instring;                     // 用户输入字符串缓存
+    char tmpString[UECLI_CFG_TEMP_MAXLEN];   // 内部临时字符串缓存
+    char prompt[UECLI_CFG_MAX_POMPTLINE];   // 提示符字符串缓存
+    const uecli_MenuItem* cmdlist;            // 命令列表入口指针
+    int status;                     // 上一条命令的执行状态 UECLI_STATUS_*
+    bool running;                   // 正在执行命令行 命令函数中嵌套执行时为true
+
+    // 输入钩子和输入捕获支持
 #if UECLI_01_IN_HOOK>0
-    void(*hookfun)(int,const char**) ;  // Ӿ 
+    uecli_Capture capture;      // 捕获参数
+    bool capturing;             // 正在捕获输入
+    uint8_t escmatch;           // 已匹配但还没有确定的结束序列字节数
+    uint8_t escoff;             // 匹配失败后已补交给命令的结束序列字节数
+    uint8_t escowed;            // 匹配失败后需要补交给命令的结束序列字节数
+    uint64_t capbytes;          // 已交给命令的字节数
+    uint64_t caplast;           // 最后收到数据的时间
+#endif
+
+    // watch命令支持
+#if UECLI_01_WATCH>0
+    char watchline[UECLI_CFG_STR_MAXLEN];   // 重复执行的命令行
+    uint32_t watchms;           // 执行间隔毫秒数
+    uint64_t watchnext;         // 下次执行的时间
+    bool watching;              // 正在监视 输入被捕获，任意键退出
+    bool watchrun;              // 正在执行命令 输出写入画面而不是端口
+    uint8_t watchesc;           // 输出中的ESC序列状态 1:收到ESC 2:收到ESC[
+    uint8_t watchrow;           // 画面写入位置
+    uint8_t watchcol;
+    uint8_t watchrows;          // 上一帧的行数
+    uint8_t framecur;           // 当前帧序号
+    char frame[2][UECLI_CFG_WATCH_ROWS][UECLI_CFG_WATCH_COLS];  // 当前帧和上一帧
+#endif
+
+    // 定时命令支持
+#if UECLI_01_SCHED>0
+    SchedTimer sched[UECLI_CFG_SCHED_NUM];  // 定时命令
+    uint16_t schedhead[SCHED_RUN + 1];      // 各链表的第一项
+    uint32_t schedmap[SCHED_LEVELS];        // 每级时间轮中非空的槽
+    uint16_t schedused;         // 用过的定时命令数量 之后的编号还没有使用
+    uint16_t schedcount;        // 有效的定时命令数量
+    uint32_t schedtick;         // 下一个待处理的节拍
+    bool schedrun;              // 正在执行定时命令
+#endif
+
+    // 分页输出支持
+#if UECLI_01_PAGER>0
+    uecli_Pager pager;          // 正在分页输出的内容来源
+    bool paging;                // 正在分页 输入被捕获
+    bool pagerun;               // 正在调用生成函数 输出经过分页器
+    bool pageoff;               // 关闭分页
+    bool searching;             // 正在查找 匹配之前的行不显示
+    uint8_t pagerows;           // 每页行数 0表示UECLI_CFG_PAGER_ROWS
+    uint8_t pageshown;          // 本次已显示的行数
+    uint8_t pagekey;            // 按键状态 PAGEKEY_*
+    uint16_t pagelen;           // 行缓存或输入的查找字符串长度
+    char pattern[UECLI_CFG_PAGER_LINELEN];  // 查找的字符串
+    char pageline[UECLI_CFG_PAGER_LINELEN]; // 查找时的行缓存
+    bool peeking;               // 正在预取下一行 输出先保存
+    uint16_t peeklen;           // 预取的输出长度
+    char peekline[UECLI_CFG_PAGER_LINELEN]; // 预取的输出 下次翻页时先显示
+#endif
+
+    // 帮助信息
+    uint8_t helpwidth;          // help -l的名称列宽 0表示固定宽度
+#if UECLI_01_HELP_CACHE>0
+    HelpCache* helprender;      // 正在渲染的帮助缓存 帮助输出写入缓存
+    HelpCache helpcache[UECLI_CFG_STACK_COUNT + 1];     // 每级菜单的帮助缓存
 #endif
 
-    // Ӳ˵֧
+    // 子菜单支持
 #if UECLI_01_SUBMENU>0
-    const uecli_MenuItem* stack[UECLI_CFG_STACK_COUNT];   // Ӳ˵ջ
-    int stackpos;    // ջ ָеԪ
+    const uecli_MenuItem* stack[UECLI_CFG_STACK_COUNT];   // 子菜单堆栈
+    int stackpos;    // 堆栈索引 指向最后空闲单元
 #endif
 
-    // ʷ¼֧
+    // 命令行历史纪录支持
 #if UECLI_01_HISTORY>0
-    char history[UECLI_CFG_HISTORY_COUNT][UECLI_CFG_STR_MAXLEN];   // ʷ¼ַ
-    int historyEnd;             // ʷ¼β
-    int historyindex;           // ʷ¼ѯ
-    char extSequenceState;      // չ״̬֧
+    char history[UECLI_CFG_HISTORY_COUNT][UECLI_CFG_STR_MAXLEN];   // 历史记录字符串缓存
+    int historyEnd;             // 历史记录保存尾部索引
+    int historyindex;           // 历史记录查询索引
+    char extSequenceState;      // 扩展命令状态支持
+#endif
+
+    // 命令序列支持
+#if UECLI_01_SEQUENCE>0
+    char statusstr[12];         // $?展开后的字符串
+#endif
+
+    // 命令原始参数支持 watch和定时命令保存的命令行保留引号和转义
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+    const char* cmdraw;         // 正在执行命令的原始命令行 超过命令行长度时为NULL
+    int cmdrawlen;              // 原始命令行长度 不含管道和重定向
+#endif
+
+    // 输出管道过滤支持
+#if UECLI_01_PIPE>0
+    PipeStage pipe[UECLI_CFG_PIPE_STAGES];  // 管道过滤级
+    int pipenum;                // 当前生效的过滤级数量
+    bool cancel;                // 输出已被取消 命令应尽快退出
+#endif
+
+    // 输出重定向支持
+#if UECLI_01_REDIRECT>0
+    void* outfile;              // 重定向文件句柄 NULL表示输出到端口
+    uint32_t outbytes;          // 已写入重定向文件的字节数
+    uint64_t outstart;          // 命令开始执行的时间
+#endif
+
+    // 命令执行统计支持
+#if UECLI_01_STATS>0
+    CmdStats* statcur;          // 正在执行命令的统计 用于累计输出字节数
+#endif
+
+    // 结构化输出支持
+#if UECLI_01_JSON>0
+    uint8_t format;             // 输出格式 uecli_Format
+    bool record;                // 正在输出命令记录
+    uecli_Json json;            // 命令记录写入器
+#endif
+
+    // 多会话支持
+#if UECLI_01_SESSION>0
+    uecli_OutFun outfun;        // 会话输出函数 NULL表示输出到端口
+    void* outctx;               // 会话输出函数上下文
+#endif
+
+};
+
+#if UECLI_01_SESSION>0
+// 默认会话 由uecli_Initialize初始化
+static struct uecli_Type uecli_default;
+// 当前线程正在处理的会话
+static UECLI_THREAD_LOCAL struct uecli_Type* uecli_cur = &uecli_default;
+#define uecli (*uecli_cur)
+#else
+static struct uecli_Type uecli;
+#endif
+
+#if UECLI_01_WATCH>0
+#if UECLI_01_IN_HOOK==0
+#error "UECLI_01_WATCH需要UECLI_01_IN_HOOK"
+#endif
+#if UECLI_CFG_WATCH_ROWS > 250 || UECLI_CFG_WATCH_COLS > 250
+#error "UECLI_CFG_WATCH_ROWS和UECLI_CFG_WATCH_COLS不能大于250"
+#endif
+#endif
+
+#if UECLI_01_PAGER>0 && UECLI_01_IN_HOOK==0
+#error "UECLI_01_PAGER需要UECLI_01_IN_HOOK"
+#endif
+#if UECLI_01_PAGER>0 && (UECLI_CFG_PAGER_ROWS < 2 || UECLI_CFG_PAGER_ROWS > 255)
+#error "UECLI_CFG_PAGER_ROWS应在2到255之间"
+#endif
+
+#if UECLI_01_SCHED>0 && (UECLI_CFG_SCHED_NUM > 65535 || UECLI_CFG_SCHED_TICK < 1)
+#error "UECLI_CFG_SCHED_NUM不能大于65535，UECLI_CFG_SCHED_TICK不能小于1"
+#endif
+
+#if UECLI_01_STATS>0
+// 命令执行统计表 按命令指针散列
+static CmdStats uecli_stats[UECLI_CFG_STATS_NUM];
+#endif
+
+#if UECLI_01_STEP>0
+#if (UECLI_CFG_STEP_OUTSIZE & (UECLI_CFG_STEP_OUTSIZE - 1))
+#error "UECLI_CFG_STEP_OUTSIZE必须为2的幂"
+#endif
+
+// 非阻塞接口发送队列 端口暂时不能写入的数据保存在这里
+static struct
+{
+    char buff[UECLI_CFG_STEP_OUTSIZE];  // 环形缓存
+    uint32_t head;              // 写入位置 自由增长
+    uint32_t tail;              // 发送位置 自由增长
+    uint32_t dropped;           // 队列满时丢弃的字节数
+}uecli_tx;
+
+// 非阻塞接口输入缓存 捕获命令暂时不能接收的数据保留在这里
+static struct
+{
+    char buff[256];
+    uint16_t pos;               // 下一个待处理的位置
+    uint16_t len;               // 数据长度
+}uecli_rx;
+#endif
+
+#if UECLI_01_TX_RING>0
+#if UECLI_01_STEP>0
+#error "UECLI_01_TX_RING和UECLI_01_STEP不能同时打开"
+#endif
+#if (UECLI_CFG_TX_RINGSIZE & (UECLI_CFG_TX_RINGSIZE - 1))
+#error "UECLI_CFG_TX_RINGSIZE必须为2的幂"
+#endif
+#if UECLI_CFG_TX_LOWWATER >= UECLI_CFG_TX_HIGHWATER || UECLI_CFG_TX_HIGHWATER > UECLI_CFG_TX_RINGSIZE
+#error "发送队列水位配置错误"
 #endif
 
-}uecli;
+// 发送队列 命令输出写入队列后立即返回，由端口异步发送
+static struct
+{
+    uint32_t head;              // 写入位置 自由增长 只由命令行线程修改
+    char pad0[UECLI_CFG_CACHELINE - sizeof(uint32_t)];
+    uint32_t tail;              // 发送位置 自由增长 只由端口修改
+    char pad1[UECLI_CFG_CACHELINE - sizeof(uint32_t)];
+    char buff[UECLI_CFG_TX_RINGSIZE];   // 环形缓存
+}uecli_txring;
+#endif
+
+#if UECLI_01_INPUT_RING>0
+#if (UECLI_CFG_INPUT_RINGSIZE & (UECLI_CFG_INPUT_RINGSIZE - 1))
+#error "UECLI_CFG_INPUT_RINGSIZE必须为2的幂"
+#endif
+
+// 单生产者单消费者输入队列 读写索引位于不同缓存行，避免生产者和消费者互相干扰
+static struct
+{
+    uint32_t head;              // 写入位置 自由增长 只由生产者修改
+    uint32_t overflow;          // 队列满时丢弃的字节数 只由生产者修改
+    char pad0[UECLI_CFG_CACHELINE - 2 * sizeof(uint32_t)];
+    uint32_t tail;              // 读取位置 自由增长 只由消费者修改
+    char pad1[UECLI_CFG_CACHELINE - sizeof(uint32_t)];
+    char buff[UECLI_CFG_INPUT_RINGSIZE];    // 环形缓存
+}uecli_inring;
+#endif
+
+#if UECLI_01_ASYNC_LOG>0
+#if (UECLI_CFG_LOG_SLOTS & (UECLI_CFG_LOG_SLOTS - 1))
+#error "UECLI_CFG_LOG_SLOTS必须为2的幂"
+#endif
+
+// 日志队列槽
+// seq等于所在圈的起始位置时为空闲，加1表示已写入，消费后设置为下一圈的起始位置
+typedef struct
+{
+    uint32_t seq;
+    char text[UECLI_CFG_LOG_LINELEN];
+}LogSlot;
+
+// 多生产者单消费者日志队列
+static struct
+{
+    uint32_t enqueue;           // 写入位置 生产者竞争修改
+    uint32_t dropped;           // 队列满时丢弃的日志数量 生产者修改
+    char pad0[UECLI_CFG_CACHELINE - 2 * sizeof(uint32_t)];
+    uint32_t dequeue;           // 读取位置 只由消费者修改
+    uint32_t reported;          // 已计入抑制数量的丢弃数量
+    uint32_t suppressed;        // 尚未提示的抑制数量
+    uint32_t tokens;            // 剩余可显示的日志条数
+    uint64_t filltime;          // 上次补充显示条数的时间
+    uint64_t noticetime;        // 上次提示抑制数量的时间
+    char pad1[UECLI_CFG_CACHELINE];
+    LogSlot slot[UECLI_CFG_LOG_SLOTS];
+}uecli_log;
+#endif
 
 // ********************************************************************************************
-// ڲ
+// 内部变量
 
 #include "uecli_cmd.h"
 
 void uecli_port_out(const void* buff, uint32_t num);
 bool uecli_port_init(void);
+uint64_t uecli_port_time_ns(void);
+
+#if UECLI_01_STEP>0
+int uecli_port_read(void* buff, uint32_t num);
+int uecli_port_write(const void* buff, uint32_t num);
+int uecli_port_pollfd(uint32_t event);
+#endif
+
+#if UECLI_01_TX_RING>0
+void uecli_port_tx_kick(void);
+void uecli_port_tx_wait(void);
+#endif
+
+#if UECLI_01_REDIRECT>0
+void* uecli_port_fopen(const char* name, bool append);
+void uecli_port_fwrite(void* file, const void* buff, uint32_t num);
+bool uecli_port_fclose(void* file);
+#endif
 
 // ********************************************************************************************
-// ڲ
+// 内部函数
 
-// ȡַ
-static inline const char* GetCmdlineString(IdxString* pistr)
+// 获取命令行输入缓存
+static inline char* GetCmdlineBuff(IdxString* pistr)
 {
+#if UECLI_01_LONG_LINE>0
+    return pistr->str ? pistr->str : pistr->buff;
+#else
     return pistr->str;
+#endif
+}
+
+// 获取命令行输入缓存大小
+static inline int GetCmdlineSize(IdxString* pistr)
+{
+#if UECLI_01_LONG_LINE>0
+    return pistr->str ? pistr->size : UECLI_CFG_STR_MAXLEN;
+#else
+    (void)pistr;
+    return UECLI_CFG_STR_MAXLEN;
+#endif
+}
+
+// 获取命令行输入字符串
+static inline const char* GetCmdlineString(IdxString* pistr)
+{
+    return GetCmdlineBuff(pistr);
 }
 
-// ȡַ
+// 获取命令行字符串长度
 static inline int GetCmdlineLength(IdxString* pistr)
 {
     return pistr->length;
 }
 
-// ַ
+// 清空输入命令行字符串 长命令行的动态缓存同时释放
 static inline void ClearCmdlineString(IdxString* pistr)
 {
+#if UECLI_01_LONG_LINE>0
+    if (pistr->str)
+    {
+        uecli_free(pistr->str);
+        pistr->str = NULL;
+        pistr->size = 0;
+    }
+#endif
     pistr->length = 0;
-    pistr->str[0] = '\0';
+    GetCmdlineBuff(pistr)[0] = '\0';
 }
 
-// ʾ
+// 清空输入命令行显示
 static inline void ClearCmdlineInput(IdxString* pistr)
 {
     if (pistr->length)
     {
-        uecli_snprintf(pistr->str, UECLI_CFG_STR_MAXLEN, "\033[%dD\033[J",
-            (uint8_t)pistr->length);
-        uecli_PrintString(pistr->str);
+        uecli_snprintf(GetCmdlineBuff(pistr), UECLI_CFG_STR_MAXLEN, "\033[%dD\033[J",
+            pistr->length);
+        uecli_PrintString(GetCmdlineBuff(pistr));
     }
     ClearCmdlineString(pistr);
 }
 
-// ַʾ
+// 拷贝字符串到命令行显示
 static inline void CopyStringToCmdline(IdxString* pistr, const char* str1)
 {
-    // ֮ǰ
+    // 清空之前的输入
     ClearCmdlineInput(pistr);
 
-    // ַָ
+    // 设置指定的字符串
     if (str1 && '\0' != *str1)
     {
-        uecli_strncpy(pistr->str, str1, UECLI_CFG_STR_MAXLEN);
-        pistr->length = uecli_strlen(pistr->str);
-        uecli_PrintString(pistr->str);
+        char* str = GetCmdlineBuff(pistr);
+        uecli_strncpy(str, str1, UECLI_CFG_STR_MAXLEN);
+        pistr->length = uecli_strlen(str);
+        uecli_PrintString(str);
     }
 }
 
-// ַ
+#if UECLI_01_LONG_LINE>0
+// 命令行缓存按块增长 超过上限或分配失败返回false
+static bool GrowCmdline(IdxString* pistr)
+{
+    int size = GetCmdlineSize(pistr) + UECLI_CFG_LINE_CHUNK;
+    if (size > UECLI_CFG_LINE_MAXSIZE)
+        size = UECLI_CFG_LINE_MAXSIZE;
+    if (size <= GetCmdlineSize(pistr))
+        return false;
+
+    char* str = (char*)uecli_realloc(pistr->str, size);
+    if (NULL == str)
+        return false;
+    if (NULL == pistr->str)
+        memcpy(str, pistr->buff, pistr->length + 1);
+    pistr->str = str;
+    pistr->size = size;
+    return true;
+}
+#endif
+
+// 附加字符
 static inline char AppendCmdlinechar(IdxString* pistr, char c)
 {
-    if (pistr->length < UECLI_CFG_STR_MAXLEN - 1)
-    {
-        pistr->str[pistr->length++] = c;
-        pistr->str[pistr->length] = '\0';
-        return c;
-    }
-    return '\0';
+#if UECLI_01_LONG_LINE>0
+    if (pistr->length >= GetCmdlineSize(pistr) - 1 && !GrowCmdline(pistr))
+        return '\0';
+#else
+    if (pistr->length >= UECLI_CFG_STR_MAXLEN - 1)
+        return '\0';
+#endif
+
+    char* str = GetCmdlineBuff(pistr);
+    str[pistr->length++] = c;
+    str[pistr->length] = '\0';
+    return c;
 }
 
-// ɾһַ
+// 删除最后一个字符
 static inline char DeleteCmdlineChar(IdxString* pistr)
 {
     char c = '\0';
     if (pistr->length)
     {
-        c = pistr->str[--pistr->length];
-        pistr->str[pistr->length] = '\0';
+        char* str = GetCmdlineBuff(pistr);
+        c = str[--pistr->length];
+        str[pistr->length] = '\0';
     }
     return c;
 }
 
-// ַǷհ
+// 检查字符串是否空白
 static inline bool IsBlankString(const char* str)
 {
     return (NULL == str || '\0' == *str);
 }
 
-// ǷΪհַ
+// 是否为空白字符
 static inline bool IsBlankChar(char c)
 {
     return (' ' == c || '\t' == c || '\r' == c);
 }
 
-// ȡһָ
-static char* GetNextDelim(char* instring, char** pstr)
+// 是否为引号或转义字符
+static inline bool IsQuoteChar(char c)
 {
-    uecli_assert(instring);
+    return ('"' == c || '\'' == c || '\\' == c);
+}
 
-    // пհַ
-    for (; IsBlankChar(*instring); ++instring);
+// 跳过引号或转义的部分 str指向引号或反斜杠
+//
+// 返回引用部分的最后一个字符，引号没有结束时返回字符串结尾之前的字符
+static char* SkipQuote(char* str)
+{
+    char quote = *str;
+
+    if ('\\' == quote)
+        return '\0' == str[1] ? str : str + 1;
+    for (++str; '\0' != *str && quote != *str; ++str)
+    {
+        if ('"' == quote && '\\' == *str && '\0' != str[1])
+            ++str;
+    }
+    return '\0' == *str ? str - 1 : str;
+}
 
-    register char c = *instring;
-    bool quotemask = false;     // ˫ű
+// 在原位置去除参数中的引号和转义 结果不会比原参数长
+static void Unquote(char* str)
+{
+    char* dst = str;
+    char quote = '\0';     // 当前所在的引号
 
-    if ('"' == c)
+    for (; '\0' != *str; ++str)
     {
-        c = *(++instring);
-        quotemask = true;
+        register char c = *str;
+
+        if ('\'' == quote)
+        {
+            // 单引号内的字符原样保留
+            if ('\'' == c)
+                quote = '\0';
+            else
+                *dst++ = c;
+        }
+        else if ('"' == quote)
+        {
+            // 双引号内只转义\"、\\、\$、\`
+            if ('"' == c)
+                quote = '\0';
+            else if ('\\' == c && ('"' == str[1] || '\\' == str[1] || '$' == str[1] || '`' == str[1]))
+                *dst++ = *++str;
+            else
+                *dst++ = c;
+        }
+        else if ('"' == c || '\'' == c)
+            quote = c;
+        else if ('\\' == c && '\0' != str[1])
+            *dst++ = *++str;
+        else
+            *dst++ = c;
     }
-    if ('\0' == c)
+    *dst = '\0';
+}
+
+// 获取下一个参数 返回参数之后的位置，没有参数时返回NULL
+//
+// 引号和转义与shell的规则相同，相连的引用部分组成一个参数，""为空参数。
+// 参数直接指向命令行，不含引号和转义的参数只写入结尾的'\0'，其他参数在原位置去除引号和转义
+static char* GetNextDelim(char* instring, char** pstr)
+{
+    uecli_assert(instring);
+
+    // 跳过所有空白字符
+    for (; IsBlankChar(*instring); ++instring);
+    if ('\0' == *instring)
         return NULL;
-            
-    // հַ
-    for (*pstr = instring; ; ++instring)
+
+    // 查找参数结尾 同时检查是否需要去除引号
+    register char* str = instring;
+    bool quoted = false;
+    for (; '\0' != *str && !IsBlankChar(*str); ++str)
     {
-        if ('\0' == (c=*instring))
-            return instring;
-        else if (quotemask && '"' == c)
-            break;
-        else if (!quotemask && IsBlankChar(c))
-            break;
+        if (IsQuoteChar(*str))
+        {
+            str = SkipQuote(str);
+            quoted = true;
+        }
     }
 
-    *instring = '\0';
-    return instring + 1;
+    char* next = '\0' == *str ? str : str + 1;
+    *str = '\0';
+    *pstr = instring;
+
+    // 去除引号和转义，没有引号的$?展开为上一条命令的执行状态
+    if (quoted)
+        Unquote(instring);
+#if UECLI_01_SEQUENCE>0
+    else if ('$' == instring[0] && '?' == instring[1] && '\0' == instring[2])
+    {
+        uecli_snprintf(uecli.statusstr, sizeof(uecli.statusstr), "%d", uecli.status);
+        *pstr = uecli.statusstr;
+    }
+#endif
+    return next;
 }
 
-// ַָ
+// 分割字符串
 static int SplitString(char* str, char* substr[], int size)
 {
-    // 
+    // 参数断言
     uecli_assert(str);
     uecli_assert(substr);
 
@@ -223,25 +706,118 @@ static int SplitString(char* str, char* substr[], int size)
     return i;
 }
 
-// ӡʾ
+// 分割命令参数 *pargv最初指向大小为UECLI_CFG_MAX_ARGNUM的参数表
+//
+// 长命令行支持时参数表满后在堆上加倍增长，*pargv改变时由调用者释放
+static int SplitArgs(char* str, char*** pargv)
+{
+#if UECLI_01_LONG_LINE>0
+    char** argv = *pargv;
+    int size = UECLI_CFG_MAX_ARGNUM;
+    int i = 0;
+
+    for (; NULL != (str = GetNextDelim(str, &argv[i])); )
+    {
+        if (++i < size)
+            continue;
+
+        char** newargv = (char**)uecli_realloc(argv == *pargv ? NULL : argv, size * 2 * sizeof(char*));
+        if (NULL == newargv)
+            break;
+        if (argv == *pargv)
+            memcpy(newargv, argv, size * sizeof(char*));
+        argv = newargv;
+        size *= 2;
+    }
+    *pargv = argv;
+    return i;
+#else
+    return SplitString(str, *pargv, UECLI_CFG_MAX_ARGNUM);
+#endif
+}
+
+// 检查命令是否只有空白字符
+static inline bool IsBlankCommand(const char* str)
+{
+    for (; IsBlankChar(*str); ++str);
+    return '\0' == *str;
+}
+
+#if UECLI_01_SEQUENCE>0
+// 在引号外的;、&&、||处截断命令行 返回命令数量，-1表示格式错误
+//
+// types[i]为第i条命令之前的连接符，连接符之前必须有命令，行尾只允许;
+static int SplitSequence(char* str, char* cmds[], uint8_t types[], int size)
+{
+    int num = 1;
+
+    cmds[0] = str;
+    types[0] = SEQUENCE_ALWAYS;
+    for (; '\0' != *str; ++str)
+    {
+        uint8_t type;
+
+        if (IsQuoteChar(*str))
+        {
+            str = SkipQuote(str);
+            continue;
+        }
+
+        if (';' == *str)
+            type = SEQUENCE_ALWAYS;
+        else if ('&' == str[0] && '&' == str[1])
+            type = SEQUENCE_AND;
+        else if ('|' == str[0] && '|' == str[1])
+            type = SEQUENCE_OR;
+        else
+            continue;
+
+        *str = '\0';
+        if (num >= size || IsBlankCommand(cmds[num - 1]))
+            return -1;
+        if (SEQUENCE_ALWAYS != type)
+            *++str = '\0';
+        cmds[num] = str + 1;
+        types[num++] = type;
+    }
+
+    if (num > 1 && IsBlankCommand(cmds[num - 1]))
+    {
+        if (SEQUENCE_ALWAYS != types[num - 1])
+            return -1;
+        --num;
+    }
+    return num;
+}
+#endif
+
+// 打印提示符
 static inline void PrintCLIPrompt(void)
 {
+#if UECLI_01_IN_HOOK>0
+    if (uecli.capturing)
+        return;
+#endif
+#if UECLI_01_JSON>0
+    if (UECLI_FORMAT_TEXT != uecli.format)
+        return;
+#endif
     uecli_PrintString(uecli.prompt);
 }
 
 // ********************************************************************************************
-// Ӳ˵֧
+// 子菜单支持
 
 #if UECLI_01_SUBMENU>0
 
-// cliʾַ
+// 更新cli提示符字符串
 static void UpdateCLIPrompt(void)
 {
     char* pstr = uecli.prompt;
 
     uecli_strncpy(pstr, UECLI_NEWLINE, UECLI_CFG_MAX_POMPTLINE);
     
-    // Ӳ˵·
+    // 添加子菜单路径
     for (int i = 0; i < uecli.stackpos; ++i)
     {
         uecli_strncat(pstr, "\\", UECLI_CFG_MAX_POMPTLINE);
@@ -250,7 +826,7 @@ static void UpdateCLIPrompt(void)
     uecli_strncat(pstr, STRING_PROMPT, UECLI_CFG_MAX_POMPTLINE);
 }
 
-// ջ
+// 栈顶
 static inline const uecli_MenuItem* GetMenuStackHandle(void)
 {
     if (uecli.stackpos)
@@ -258,10 +834,10 @@ static inline const uecli_MenuItem* GetMenuStackHandle(void)
     return NULL;
 }
 
-// ˵ջջ
+// 菜单堆栈入栈
 static inline void PushMenuStack(const uecli_MenuItem* ptr)
 {
-    // 򸲸
+    // 超过最大数量则覆盖
     if (uecli.stackpos >= UECLI_CFG_STACK_COUNT)
         uecli.stackpos = UECLI_CFG_STACK_COUNT - 1;
     uecli.stack[uecli.stackpos++] = ptr;
@@ -269,7 +845,7 @@ static inline void PushMenuStack(const uecli_MenuItem* ptr)
     UpdateCLIPrompt();
 }
 
-// ˵ջջ
+// 菜单堆栈出栈
 static inline const uecli_MenuItem* PopMenuStack(void)
 {
     const uecli_MenuItem* ptr = NULL;
@@ -282,7 +858,7 @@ static inline const uecli_MenuItem* PopMenuStack(void)
 }
 
 #else
-//cliʾַ
+//更新cli提示符字符串
 static void UpdateCLIPrompt(void)
 {
     char* pstr = uecli.prompt;
@@ -296,7 +872,7 @@ static inline const uecli_MenuItem* PopMenuStack(void)
 }
 #endif
 
-// ȡû
+// 获取用户命令
 static inline const uecli_MenuItem* GetUserCmdHandle(void)
 {
 #if UECLI_01_SUBMENU>0
@@ -308,17 +884,83 @@ static inline const uecli_MenuItem* GetUserCmdHandle(void)
 }
 
 // ********************************************************************************************
-// ʷ¼֧
+// 链接段命令支持
+
+#if UECLI_01_SECTION>0
+// 段的起止符号由链接器生成 没有命令时为NULL
+extern const uecli_MenuItem __start_uecli_cmds[] __attribute__((weak));
+extern const uecli_MenuItem __stop_uecli_cmds[] __attribute__((weak));
+extern const uecli_SectionIndex __start_uecli_index[] __attribute__((weak));
+extern const uecli_SectionIndex __stop_uecli_index[] __attribute__((weak));
+
+// 当前可见的链接段命令数量 链接段命令属于根命令表，子菜单中不可见
+static inline uint32_t GetSectionCount(void)
+{
+#if UECLI_01_SUBMENU>0
+    if (NULL != GetMenuStackHandle())
+        return 0;
+#endif
+    return (uint32_t)(__stop_uecli_cmds - __start_uecli_cmds);
+}
+
+// 获取命令索引 没有索引或索引生成后命令有增减时返回NULL
+static inline const uecli_SectionIndex* GetSectionIndex(uint32_t count)
+{
+    if (1 != __stop_uecli_index - __start_uecli_index || count != __start_uecli_index->count)
+        return NULL;
+    return __start_uecli_index;
+}
+
+// 获取第i个链接段命令 有索引时按名称顺序，超出数量返回NULL
+static const uecli_MenuItem* GetSectionCmd(uint32_t i)
+{
+    uint32_t count = GetSectionCount();
+    if (i >= count)
+        return NULL;
+
+    const uecli_SectionIndex* index = GetSectionIndex(count);
+    return index ? index->order[i] : &__start_uecli_cmds[i];
+}
+
+// 搜索链接段命令 有索引时使用索引查找
+static const uecli_MenuItem* SearchSectionCmd(const char* cmdstring)
+{
+    uint32_t count = GetSectionCount();
+    const uecli_SectionIndex* index = GetSectionIndex(count);
+    uint32_t i;
+
+    if (index)
+    {
+        const uecli_MenuItem* item;
+        for (i = uecli_HashName(cmdstring, index->seed); NULL != (item = index->slots[i & index->mask]); ++i)
+        {
+            if (!uecli_strcasecmp(cmdstring, item->exename))
+                return item;
+        }
+        return NULL;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!uecli_strcasecmp(cmdstring, __start_uecli_cmds[i].exename))
+            return &__start_uecli_cmds[i];
+    }
+    return NULL;
+}
+#endif
+
+// ********************************************************************************************
+// 历史记录支持
 
 #if UECLI_01_HISTORY>0
-// ʷ
+// 保存命令历史
 static void SaveHistory(const char* cmdline)
 {
-    // հֱַ˳
+    // 空白字符串直接退出
     if (IsBlankString(cmdline))
         return;
 
-    // вظ¼
+    // 输入的命令行不重复则记录
     int i = uecli.historyEnd;
     if (uecli_strcasecmp(uecli.history[i], cmdline))
     {
@@ -329,20 +971,20 @@ static void SaveHistory(const char* cmdline)
     uecli.historyindex = INVALID_HISTORY_INDEX;
 }
 
-// ȡʷ¼бʼλ
+// 获取历史记录环形列表起始位置
 static inline int GetStartHistoryPostion(void)
 {
     return **uecli.history == '\0' ? 1 :
         CYCLE_INCREMENT(uecli.historyEnd, UECLI_CFG_HISTORY_COUNT-1);
 }
 
-// ȡһʷ¼
+// 获取下一个历史记录
 static const char* GetNextHistory(void)
 {
     int i = uecli.historyindex;
     int starti = GetStartHistoryPostion();
 
-    // жǷΪ
+    // 判断是否为空
     if ('\0' == uecli.history[uecli.historyEnd][0])
         return NULL;
     else if (INVALID_HISTORY_INDEX == i)
@@ -357,13 +999,13 @@ static const char* GetNextHistory(void)
     return uecli.history[uecli.historyindex];
 }
 
-// ȡһʷ¼
+// 获取上一个历史记录
 static const char* GetPriveHistory(void)
 {
     int i = uecli.historyindex;
     int starti = GetStartHistoryPostion();
 
-    // жǷΪ
+    // 判断是否为空
     if ('\0' == uecli.history[uecli.historyEnd][0])
         return NULL;
     else if (INVALID_HISTORY_INDEX == i)
@@ -378,13 +1020,13 @@ static const char* GetPriveHistory(void)
     return uecli.history[uecli.historyindex];
 }
 
-// չַ ֵʾǷ
+// 处理扩展字符序列 返回值表示是否回显
 static char ProcessESCSequence(char c)
 {
     const char* tstr;
     switch (c)
     {
-    case '\x1b':    // ʼ
+    case '\x1b':    // 起始命令
         uecli.extSequenceState = 1;
         return 0;
         break;
@@ -395,7 +1037,7 @@ static char ProcessESCSequence(char c)
             return 0;
         }
         break;
-    case 'A':       // ϼͷ
+    case 'A':       // 上箭头
         if (2 == uecli.extSequenceState)
         {
             uecli.extSequenceState = 0;
@@ -404,7 +1046,7 @@ static char ProcessESCSequence(char c)
             return 0;
         }
         break;
-    case 'B':       // ¼ͷ
+    case 'B':       // 下箭头
         if (2 == uecli.extSequenceState)
         {
             uecli.extSequenceState = 0;
@@ -421,21 +1063,21 @@ static char ProcessESCSequence(char c)
 #endif
 
 // ********************************************************************************************
-// ȫ֧
+// 命令补全支持
 
 #if UECLI_01_COMPLETE>0
 
-// ָȱȽַ
+// 按指定长度比较字符串
 static int strncmpNocase(const char* src, const char* dst, unsigned int len)
 {
-    // 
+    // 参数断言
     uecli_assert(src);
     uecli_assert(dst);
 
     char c1, c2;
     int ret = 0;
 
-    // жָǷ
+    // 判断指针是否相等
     if (src == dst) return 0;
 
     for (; c2 = *src, '\0' != (c1 = *dst); ++src, ++dst)
@@ -451,7 +1093,7 @@ static int strncmpNocase(const char* src, const char* dst, unsigned int len)
             return 0;
     }
 
-    // ʽֵ
+    // 格式化结果数值
     ret = c2 - c1;
     if (ret < 0)
         ret = -1;
@@ -460,13 +1102,13 @@ static int strncmpNocase(const char* src, const char* dst, unsigned int len)
     return(ret);
 }
 
-// ӡƥַ
+// 打印匹配命令字符串表
 static void PrintMatchCmdTable(const char** matchtable, int len)
 {
     uecli_PrintString(UECLI_NEWLINE);
     const char* formatstr = NULL;
     
-    // ӡб
+    // 打印列表
     for (int i = 0; i < len; ++i)
     {
         if ((i + 1) % 4 == 0)
@@ -478,37 +1120,44 @@ static void PrintMatchCmdTable(const char** matchtable, int len)
         uecli_PrintString(uecli.tmpString);
     }
     
-    // ӡʾ
+    // 打印提示符
     uecli_PrintString(UECLI_NEWLINE);
     PrintCLIPrompt();
     uecli_PrintString(GetCmdlineString(&uecli.instring));
 }
 
-// ƥ
-static int SearchCompleteCmd(const char** strtable, int startindex, const uecli_MenuItem* list)
+// 命令项与输入匹配时加入列表 返回列表数量
+static int MatchCompleteCmd(const char** strtable, int startindex, const uecli_MenuItem* item)
 {
     int strlength = GetCmdlineLength(&uecli.instring);
-    for (; list->pdata; ++list)
+    if (startindex < UECLI_CFG_AUTOCOMP_NUM
+        && !strncmpNocase(GetCmdlineString(&uecli.instring), item->exename, strlength))
     {
-        if (!strncmpNocase(GetCmdlineString(&uecli.instring), list->exename, strlength))
+        if (startindex >= UECLI_CFG_AUTOCOMP_NUM - 1)
         {
-            if (startindex >= UECLI_CFG_AUTOCOMP_NUM - 1)
-            {
-                strtable[UECLI_CFG_AUTOCOMP_NUM - 1] = "...";
-                startindex = UECLI_CFG_AUTOCOMP_NUM;
-                break;
-            }
-            strtable[startindex] = list->exename;
-            ++startindex;
+            strtable[UECLI_CFG_AUTOCOMP_NUM - 1] = "...";
+            return UECLI_CFG_AUTOCOMP_NUM;
         }
+        strtable[startindex++] = item->exename;
+    }
+    return startindex;
+}
+
+// 搜索匹配命令
+static int SearchCompleteCmd(const char** strtable, int startindex, const uecli_MenuItem* list)
+{
+    if (list)
+    {
+        for (list = SkipMenuIndex(list); list->pdata && startindex < UECLI_CFG_AUTOCOMP_NUM; ++list)
+            startindex = MatchCompleteCmd(strtable, startindex, list);
     }
     return startindex;
 }
 
-// Զȫ֧
+// 自动补全支持
 static void AutoCompleteInstring(void)
 {
-    // ֱʾϢ
+    // 无输入直接显示帮助信息
     if (!GetCmdlineLength(&uecli.instring))
     {
         uecli_PrintString(UECLI_NEWLINE);
@@ -520,12 +1169,17 @@ static void AutoCompleteInstring(void)
     const char* matchStringTable[UECLI_CFG_AUTOCOMP_NUM];
     int i = 0;
 
-    // ƥϵͳ
+    // 匹配系统命令
     i = SearchCompleteCmd(matchStringTable, i, GetSyscmdHandle());
     if (i < UECLI_CFG_AUTOCOMP_NUM)
         i = SearchCompleteCmd(matchStringTable, i, GetUserCmdHandle());
+#if UECLI_01_SECTION>0
+    const uecli_MenuItem* item;
+    for (uint32_t n = 0; i < UECLI_CFG_AUTOCOMP_NUM && NULL != (item = GetSectionCmd(n)); ++n)
+        i = MatchCompleteCmd(matchStringTable, i, item);
+#endif
 
-    // ֻҵ1ƥ ֱ
+    // 只找到1个匹配 直接完成
     if (1 == i)
         CopyStringToCmdline(&uecli.instring, matchStringTable[0]);
     else if (i)
@@ -533,190 +1187,2587 @@ static void AutoCompleteInstring(void)
 }
 #endif
 
-// ַ
-static char cli_echo(char c)
-{
-    UECLI_LOG("յַ0X%02x:%c", c, c);
+// ********************************************************************************************
+// 输出重定向支持
 
-    // 
-    switch (c)
+#if UECLI_01_REDIRECT>0
+
+// 在引号外的重定向符处截断命令行并获取文件名
+//
+// 没有重定向时文件名为NULL，返回false表示重定向格式错误
+static bool ParseRedirect(char* str, char** pname, bool* append)
+{
+    *pname = NULL;
+    for (; '\0' != *str; ++str)
     {
-    case '\r':
-    case '\n':  // س
-        uecli_PrintString(UECLI_NEWLINE);
-        return '\n';
-        break;
-    case '\b':  // ˸ַ
-        if (DeleteCmdlineChar(&uecli.instring))
+        if (IsQuoteChar(*str))
+            str = SkipQuote(str);
+        else if ('>' == *str)
+        {
+            *str++ = '\0';
+            if ((*append = ('>' == *str)))
+                ++str;
+
+            // 获取文件名 文件名之后不允许再有其他参数
+            if (NULL != (str = GetNextDelim(str, pname)) && NULL == GetNextDelim(str, &str))
+                return true;
+
+            uecli_PrintString(STRING_INVALID_REDIRECT);
+            uecli_PrintString(UECLI_NEWLINE);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 开始重定向 之后的命令输出将写入文件，外层命令的重定向保存到outer中
+static bool StartRedirect(const char* name, bool append, RedirectState* outer)
+{
+    outer->file = uecli.outfile;
+    outer->bytes = uecli.outbytes;
+    outer->start = uecli.outstart;
+    if (NULL == name)
+        return true;
+
+    void* file = uecli_port_fopen(name, append);
+    if (NULL == file)
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_REDIRECT_FAILED, name);
+        uecli_PrintString(uecli.tmpString);
+        uecli_PrintString(UECLI_NEWLINE);
+        return false;
+    }
+
+    uecli.outfile = file;
+    uecli.outbytes = 0;
+    uecli.outstart = uecli_gettime_ns();
+    return true;
+}
+
+// 结束重定向 关闭文件，恢复外层命令的重定向后报告写入字节数和耗时
+static void FinishRedirect(const RedirectState* outer)
+{
+    bool result = uecli_port_fclose(uecli.outfile);
+    uint32_t us = (uint32_t)((uecli_gettime_ns() - uecli.outstart) / 1000);
+    uint32_t bytes = uecli.outbytes;
+
+    uecli.outfile = outer->file;
+    uecli.outbytes = outer->bytes;
+    uecli.outstart = outer->start;
+
+    if (result)
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_REDIRECT_RESULT,
+            bytes, us / 1000, us % 1000);
+    else
+        uecli_strncpy(uecli.tmpString, STRING_REDIRECT_ERROR, UECLI_CFG_TEMP_MAXLEN);
+    uecli_PrintString(uecli.tmpString);
+    uecli_PrintString(UECLI_NEWLINE);
+}
+#endif
+
+#if UECLI_01_STEP>0
+// 非阻塞发送 队列为空时直接写入端口，端口不能写入的部分进入发送队列
+static void StepOut(const void* buff, uint32_t num)
+{
+    const char* pdata = (const char*)buff;
+
+    if (uecli_tx.head == uecli_tx.tail)
+    {
+        int len = uecli_port_write(pdata, num);
+        if (len < 0)
+            return;
+        pdata += len;
+        num -= (uint32_t)len;
+    }
+
+    // 队列满时丢弃超出的部分
+    uint32_t space = UECLI_CFG_STEP_OUTSIZE - (uecli_tx.head - uecli_tx.tail);
+    if (num > space)
+    {
+        uecli_tx.dropped += num - space;
+        num = space;
+    }
+    for (; num; --num)
+        uecli_tx.buff[uecli_tx.head++ & (UECLI_CFG_STEP_OUTSIZE - 1)] = *pdata++;
+}
+#endif
+
+#if UECLI_01_TX_RING>0
+// 写入发送队列 队列超过高水位时暂停，等待端口发送到低水位以下再继续
+static void TxRingOut(const void* buff, uint32_t num)
+{
+    const char* pdata = (const char*)buff;
+
+    while (num)
+    {
+        uint32_t head = uecli_txring.head;
+        uint32_t pending = head - uecli_atomic_load(&uecli_txring.tail);
+
+        if (pending >= UECLI_CFG_TX_HIGHWATER)
+        {
+            do
+            {
+                uecli_port_tx_kick();
+                uecli_port_tx_wait();
+            } while (head - uecli_atomic_load(&uecli_txring.tail) > UECLI_CFG_TX_LOWWATER);
+            continue;
+        }
+
+        // 分两段复制到环形缓存
+        uint32_t len = UECLI_CFG_TX_RINGSIZE - pending;
+        if (len > num)
+            len = num;
+        uint32_t pos = head & (UECLI_CFG_TX_RINGSIZE - 1);
+        uint32_t first = UECLI_CFG_TX_RINGSIZE - pos;
+        if (first > len)
+            first = len;
+        memcpy(&uecli_txring.buff[pos], pdata, first);
+        memcpy(uecli_txring.buff, pdata + first, len - first);
+        uecli_atomic_store(&uecli_txring.head, head + len);
+        pdata += len;
+        num -= len;
+    }
+
+    // 端口空闲时开始发送 端口忙时本次数据与之前的数据合并发送
+    uecli_port_tx_kick();
+}
+#endif
+
+// 发送数据到端口
+static inline void PortOut(const void* buff, uint32_t num)
+{
+    UECLI_TRACE_BEGIN(tracestart);
+#if UECLI_01_SESSION>0
+    if (uecli.outfun)
+        uecli.outfun(uecli.outctx, buff, num);
+    else
+#endif
+#if UECLI_01_STEP>0
+    StepOut(buff, num);
+#elif UECLI_01_TX_RING>0
+    TxRingOut(buff, num);
+#else
+    uecli_port_out(buff, num);
+#endif
+    UECLI_TRACE_END(UECLI_TRACE_OUTPUT, NULL, tracestart);
+}
+
+#if UECLI_01_WATCH>0
+static void WatchWrite(const char* buff, int len);
+#endif
+#if UECLI_01_PAGER>0
+static void PagerWrite(const char* buff, int len);
+#endif
+
+// 发送最终输出数据 重定向时写入文件，否则送往端口
+static void SendOutput(const char* buff, int len)
+{
+#if UECLI_01_REDIRECT>0
+    if (uecli.outfile)
+    {
+        uecli_port_fwrite(uecli.outfile, buff, len);
+        uecli.outbytes += len;
+        return;
+    }
+#endif
+#if UECLI_01_WATCH>0
+    // watch执行的命令输出写入画面 执行完成后只发送变化的部分
+    if (uecli.watchrun)
+    {
+        WatchWrite(buff, len);
+        return;
+    }
+#endif
+#if UECLI_01_PAGER>0
+    // 分页输出时统计显示的行数 查找时只显示匹配之后的内容
+    if (uecli.pagerun)
+    {
+        PagerWrite(buff, len);
+        return;
+    }
+#endif
+#if UECLI_01_JSON>0
+    // 命令的文本输出转义后作为记录中的字符串
+    if (uecli.record)
+    {
+        uecli_JsonText(&uecli.json, buff, len);
+        return;
+    }
+#endif
+    PortOut(buff, len);
+}
+
+// ********************************************************************************************
+// 结构化输出支持
+
+#if UECLI_01_JSON>0
+
+// 记录写入器输出 不经过管道和重定向
+static void JsonOut(void* ctx, const char* buff, uint32_t num)
+{
+    PortOut(buff, num);
+    (void)ctx;
+}
+
+// 开始一条命令记录 {"line":命令行,"out":[文本或命令写入的数据...]
+static void BeginRecord(const char* cmdline)
+{
+    uecli_JsonInit(&uecli.json, UECLI_FORMAT_CBOR == uecli.format, JsonOut, NULL);
+    uecli_JsonObjectBegin(&uecli.json, NULL);
+    uecli_JsonString(&uecli.json, "line", cmdline);
+    uecli_JsonArrayBegin(&uecli.json, "out");
+    uecli.record = true;
+}
+
+// 结束命令记录 ,"status":状态,"us":耗时}
+static void EndRecord(int status, uint64_t ns)
+{
+    uecli.record = false;
+    uecli_JsonArrayEnd(&uecli.json);
+    uecli_JsonInt(&uecli.json, "status", status);
+    uecli_JsonFixed(&uecli.json, "us", (int64_t)ns, 3);
+    uecli_JsonObjectEnd(&uecli.json);
+    if (!uecli.json.cbor)
+        uecli_JsonRaw(&uecli.json, "\n", 1);
+    uecli_JsonFlush(&uecli.json);
+}
+#endif
+
+// ********************************************************************************************
+// 输出管道过滤支持
+
+#if UECLI_01_PIPE>0
+
+static void PipeWrite(int index, const char* buff, int len);
+
+// 处理过滤级中缓存的一整行
+static void PipeLine(int index)
+{
+    PipeStage* ps = &uecli.pipe[index];
+    bool pass = false;
+
+    ps->line[ps->length] = '\0';
+    switch (ps->type)
+    {
+    case PIPE_FILTER_GREP:
+        pass = (NULL != (ps->nocase ? estrstrNocase(ps->line, ps->pattern) :
+            estrstr(ps->line, ps->pattern))) != ps->invert;
+        break;
+    case PIPE_FILTER_HEAD:
+        if (ps->count < ps->limit)
+        {
+            ++ps->count;
+            pass = true;
+        }
+
+        // 输出行数已满，上游的输出都不再需要，通知命令取消
+        if (ps->count >= ps->limit)
+            uecli.cancel = true;
+        break;
+    case PIPE_FILTER_COUNT:
+        ++ps->count;
+        break;
+    default:
+        break;
+    }
+
+    if (pass)
+    {
+        PipeWrite(index + 1, ps->line, ps->length);
+        PipeWrite(index + 1, "\n", 1);
+    }
+    ps->length = 0;
+}
+
+// 向指定过滤级写入数据 超出最后一级时直接输出到端口
+static void PipeWrite(int index, const char* buff, int len)
+{
+    if (index >= uecli.pipenum)
+    {
+        SendOutput(buff, len);
+        return;
+    }
+
+    PipeStage* ps = &uecli.pipe[index];
+    for (; len > 0; --len, ++buff)
+    {
+        if ('\n' == *buff)
+            PipeLine(index);
+        else if (ps->length < UECLI_CFG_PIPE_LINELEN - 1)
+            ps->line[ps->length++] = *buff;
+    }
+}
+
+// 解析一级过滤器及其参数
+static bool ParsePipeStage(PipeStage* ps, char* str)
+{
+    char* argv[UECLI_CFG_MAX_ARGNUM];
+    int argc = SplitString(str, argv, UECLI_CFG_MAX_ARGNUM);
+    int i = 1;
+
+    ps->invert = ps->nocase = false;
+    ps->pattern = NULL;
+    ps->limit = 10;
+    ps->count = ps->length = 0;
+
+    // 查找过滤器类型
+    for (ps->type = PIPE_FILTER_GREP; argc && ps->type < PIPE_FILTER_NUM; ++ps->type)
+    {
+        if (!uecli_strcasecmp(argv[0], uecli_filterList[ps->type]))
+            break;
+    }
+
+    switch (argc ? ps->type : PIPE_FILTER_NUM)
+    {
+    case PIPE_FILTER_GREP:  // grep [-v] [-i] pattern
+        for (; i < argc - 1 && '-' == argv[i][0]; ++i)
+        {
+            if (!uecli_strcasecmp(argv[i], "-v"))
+                ps->invert = true;
+            else if (!uecli_strcasecmp(argv[i], "-i"))
+                ps->nocase = true;
+            else
+                break;
+        }
+        ps->pattern = argv[i];
+        if (i == argc - 1)
+            return true;
+        break;
+    case PIPE_FILTER_HEAD:  // head [-n] [N]
+        if (i < argc && !uecli_strcasecmp(argv[i], "-n"))
+            ++i;
+        if (i == argc || (i == argc - 1 && estrtoi(argv[i], &ps->limit) && ps->limit > 0))
+            return true;
+        break;
+    case PIPE_FILTER_COUNT: // count
+        if (1 == argc)
+            return true;
+        break;
+    default:
+        break;
+    }
+
+    uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_INVALID_FILTER, argc ? argv[0] : "");
+    uecli_PrintString(uecli.tmpString);
+    uecli_PrintString(UECLI_NEWLINE);
+    return false;
+}
+
+// 在引号外的管道符处截断命令行并解析各级过滤器 返回过滤级数量，-1表示失败
+//
+// 过滤器解析到正在生效的过滤级之后的空闲级中，嵌套执行时不改变外层命令的过滤级
+static int ParsePipeline(char* str)
+{
+    char* stagestr[UECLI_CFG_PIPE_STAGES];
+    int base = uecli.pipenum;
+    int num = 0;
+
+    // 先截断所有管道符，过滤器参数分割时会改写字符串
+    for (; '\0' != *str; ++str)
+    {
+        if (IsQuoteChar(*str))
+            str = SkipQuote(str);
+        else if ('|' == *str)
+        {
+            if (base + num >= UECLI_CFG_PIPE_STAGES)
+            {
+                uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_INVALID_FILTER, str);
+                uecli_PrintString(uecli.tmpString);
+                uecli_PrintString(UECLI_NEWLINE);
+                return -1;
+            }
+            *str = '\0';
+            stagestr[num++] = str + 1;
+        }
+    }
+
+    for (int i = 0; i < num; ++i)
+    {
+        if (!ParsePipeStage(&uecli.pipe[base + i], stagestr[i]))
+            return -1;
+    }
+    return num;
+}
+
+// 将前num级过滤器循环左移count级
+static void RotatePipe(int num, int count)
+{
+    PipeStage temp;
+
+    for (; count > 0; --count)
+    {
+        temp = uecli.pipe[0];
+        memmove(&uecli.pipe[0], &uecli.pipe[1], (num - 1) * sizeof(PipeStage));
+        uecli.pipe[num - 1] = temp;
+    }
+}
+
+// 启动管道 之后的命令输出将经过各级过滤器
+//
+// 嵌套执行的命令的过滤级移到外层命令的过滤级之前，输出先经过自己的过滤器再进入外层的过滤器
+static inline void StartPipeline(int num)
+{
+    RotatePipe(uecli.pipenum + num, uecli.pipenum);
+    uecli.pipenum += num;
+}
+
+// 结束管道 将各级缓存的残余行和统计结果依次传递到下一级，恢复外层命令的过滤级和取消状态
+static void FinishPipeline(int num, bool cancel)
+{
+    for (int i = 0; i < num; ++i)
+    {
+        PipeStage* ps = &uecli.pipe[i];
+        if (ps->length)
+            PipeLine(i);
+        if (PIPE_FILTER_COUNT == ps->type)
+        {
+            uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, "%d" UECLI_NEWLINE, ps->count);
+            PipeWrite(i + 1, uecli.tmpString, uecli_strlen(uecli.tmpString));
+        }
+    }
+    RotatePipe(uecli.pipenum, num);
+    uecli.pipenum -= num;
+    uecli.cancel = cancel;
+}
+#endif
+
+// ********************************************************************************************
+// 命令执行统计支持
+
+#if UECLI_01_STATS>0
+
+// 获取最高有效位位置
+static inline int GetHighestBit(uint64_t value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int n = 0;
+    while (value >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
+// 计算耗时对应的直方图桶
+static inline int GetStatsBucket(uint64_t ns)
+{
+    if (ns < STATS_SUBCOUNT)
+        return (int)ns;
+
+    int bit = GetHighestBit(ns);
+    if (bit >= UECLI_CFG_STATS_MAXBITS)
+        return STATS_BUCKETS - 1;
+    return ((bit - UECLI_CFG_STATS_SUBBITS + 1) << UECLI_CFG_STATS_SUBBITS) +
+        (int)((ns >> (bit - UECLI_CFG_STATS_SUBBITS)) & (STATS_SUBCOUNT - 1));
+}
+
+// 计算直方图桶所能表示的最大耗时
+static uint64_t GetStatsBucketValue(int index)
+{
+    if (index < STATS_SUBCOUNT)
+        return index;
+
+    int shift = (index >> UECLI_CFG_STATS_SUBBITS) - 1;
+    return ((uint64_t)(STATS_SUBCOUNT + (index & (STATS_SUBCOUNT - 1))) << shift) +
+        ((uint64_t)1 << shift) - 1;
+}
+
+// 查找命令的统计 add为true时不存在则分配 统计表已满返回NULL
+static CmdStats* FindCmdStats(const uecli_MenuItem* item, bool add)
+{
+    int i = (int)(((uintptr_t)item >> 3) % UECLI_CFG_STATS_NUM);
+
+    for (int n = 0; n < UECLI_CFG_STATS_NUM; ++n)
+    {
+        if (item == uecli_stats[i].item)
+            return &uecli_stats[i];
+        if (NULL == uecli_stats[i].item)
+        {
+            if (!add)
+                break;
+            uecli_stats[i].item = item;
+            return &uecli_stats[i];
+        }
+        i = CYCLE_INCREMENT(i, UECLI_CFG_STATS_NUM - 1);
+    }
+    return NULL;
+}
+
+// 记录一次命令执行 执行期间统计被清除时不记录
+static inline void RecordCmdStats(CmdStats* pstat, const uecli_MenuItem* item, uint64_t ns)
+{
+    if (NULL == pstat || item != pstat->item)
+        return;
+
+    ++pstat->calls;
+    ++pstat->hist[GetStatsBucket(ns)];
+    if (ns > pstat->maxns)
+        pstat->maxns = ns;
+}
+
+// 获取耗时的百分位数值 permille为千分比
+static uint64_t GetStatsPercentile(const CmdStats* pstat, uint32_t permille)
+{
+    uint32_t target = (uint32_t)(((uint64_t)pstat->calls * permille + 999) / 1000);
+    uint32_t sum = 0;
+
+    for (int i = 0; i < STATS_BUCKETS; ++i)
+    {
+        sum += pstat->hist[i];
+        if (sum >= target && sum)
+        {
+            uint64_t value = GetStatsBucketValue(i);
+            return value < pstat->maxns ? value : pstat->maxns;
+        }
+    }
+    return pstat->maxns;
+}
+#endif
+
+// 输出数据 命令的输出经由此函数送往过滤器或端口
+static inline void OutputData(const char* buff, int len)
+{
+#if UECLI_01_STATS>0
+    if (uecli.statcur && uecli.statcur->item)
+        uecli.statcur->bytes += len;
+#endif
+#if UECLI_01_PIPE>0
+    if (uecli.pipenum)
+    {
+        if (!uecli.cancel)
+            PipeWrite(0, buff, len);
+        return;
+    }
+#endif
+    SendOutput(buff, len);
+}
+
+// 回显输入字符
+static char cli_echo(char c)
+{
+    UECLI_LOG("接收到字符0X%02x:%c", c, c);
+
+    // 解析控制命令
+    switch (c)
+    {
+    case '\r':
+    case '\n':  // 回车换行
+        uecli_PrintString(UECLI_NEWLINE);
+        return '\n';
+        break;
+    case '\b':  // 退格字符
+    case '\x7f':    // 终端中退格键一般发送DEL
+        if (DeleteCmdlineChar(&uecli.instring))
             uecli_PrintString("\b \b");
         break;
         
     #if UECLI_01_COMPLETE>0
-    case '\t':  // Ʊ
+    case '\t':  // 制表符
         AutoCompleteInstring();
         break;
     #endif  
     
     #if UECLI_01_HISTORY>0
-    case '\x1b': // ESC չܷ
+    case '\x1b': // ESC 扩展功能符
         ProcessESCSequence(c);
         break;
     #endif
     
-    default:    // ɴӡַ
+    default:    // 其他可打印字符
     #if UECLI_01_HISTORY>0
         if (!ProcessESCSequence(c))
             break;
     #endif
-        if (uecli_isprintfchar(c) && AppendCmdlinechar(&uecli.instring,c))
-            uecli_port_out((const uint8_t*)&c, 1);		/*  */
+        if (uecli_isprintfchar(c) && AppendCmdlinechar(&uecli.instring,c))
+            PortOut((const uint8_t*)&c, 1);		/* 输出回显 */
+    }
+
+    return c;
+}
+
+// 跳过命令表开头的索引项
+static inline const uecli_MenuItem* SkipMenuIndex(const uecli_MenuItem* list)
+{
+    return (list && UECLI_TYPE_INDEX == list->itemType) ? list + 1 : list;
+}
+
+// 在命令表中搜索命令 有索引时使用索引查找
+static const uecli_MenuItem* SearchMenuList(const uecli_MenuItem* list, const char* cmdstring)
+{
+    if (NULL == list)
+        return NULL;
+    if (UECLI_TYPE_INDEX == list->itemType)
+    {
+        const uecli_CmdIndex* index = (const uecli_CmdIndex*)list->pdata;
+        uint32_t pos = uecli_HashName(cmdstring, index->seed);
+        uint16_t slot;
+
+        for (; 0 != (slot = index->slots[pos & index->mask]); ++pos)
+        {
+            if (!uecli_strcasecmp(cmdstring, list[slot].exename))
+                return &list[slot];
+        }
+        return NULL;
+    }
+
+    for (; list->pdata; ++list)
+    {
+        if (!uecli_strcasecmp(cmdstring, list->exename))
+            return list;
+    }
+    return NULL;
+}
+
+// 搜索匹配的命令项
+static const uecli_MenuItem* SearchMatchCommand(const char* cmdstring)
+{
+    // 先搜索系统命令列表 再搜索用户命令列表和链接段命令
+    const uecli_MenuItem* ptr = SearchMenuList(GetSyscmdHandle(), cmdstring);
+    if (NULL == ptr)
+        ptr = SearchMenuList(GetUserCmdHandle(), cmdstring);
+#if UECLI_01_SECTION>0
+    if (NULL == ptr)
+        ptr = SearchSectionCmd(cmdstring);
+#endif
+    return ptr;
+}
+
+// 执行一条命令 返回执行状态，找到命令时设置*pfound
+//
+// raw为分割前的命令，命令行过长没有保存时为NULL
+static int RunCommand(char* str, const char* raw, bool* pfound, char*** pargv)
+{
+    char** argcbuff = *pargv;
+    int count = 0;
+    int status = UECLI_STATUS_SYNTAX;
+    bool valid = true;
+
+    // 重定向或过滤器无效时不执行命令
+#if UECLI_01_REDIRECT>0
+    char* filename;
+    bool append = false;
+    valid = ParseRedirect(str, &filename, &append);
+#endif
+#if UECLI_01_PIPE>0
+    int pipenum = valid ? ParsePipeline(str) : -1;
+    valid = pipenum >= 0;
+#endif
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+    int rawlen = valid && raw ? uecli_strlen(str) : 0;
+#else
+    (void)raw;
+#endif
+    if (valid)
+    {
+        UECLI_TRACE_BEGIN(tracestart);
+        count = SplitArgs(str, pargv);
+        argcbuff = *pargv;
+        UECLI_TRACE_END(UECLI_TRACE_SPLIT, NULL, tracestart);
+    }
+    if (0 == count)
+        return status;
+
+    // 搜索并执行命令
+    UECLI_LOG("接收到命令:%s", argcbuff[0]);
+    UECLI_TRACE_BEGIN(tracestart);
+    const uecli_MenuItem* phand = SearchMatchCommand(argcbuff[0]);
+    UECLI_TRACE_END(UECLI_TRACE_LOOKUP, NULL, tracestart);
+    if (NULL == phand)
+    {
+        UECLI_LOG("\"%s\" 不是有效的命令", argcbuff[0]);
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN,STRING_INVALID_COMMAND, argcbuff[0]);
+        uecli_PrintString(uecli.tmpString);
+        uecli_PrintString(UECLI_NEWLINE);
+        return UECLI_STATUS_NOTFOUND;
+    }
+
+    *pfound = true;
+    status = UECLI_STATUS_OK;
+    if (UECLI_TYPE_SUBMENU == phand->itemType)
+    {
+    #if UECLI_01_SUBMENU>0
+        PushMenuStack(phand);
+    #endif
+        return status;
+    }
+
+    // 处理器中可以嵌套执行命令行，只结束本次开始的重定向、过滤器和统计
+#if UECLI_01_REDIRECT>0
+    RedirectState outer;
+    if (!StartRedirect(filename, append, &outer))
+        return UECLI_STATUS_ERROR;
+#endif
+#if UECLI_01_PIPE>0
+    bool cancel = uecli.cancel;
+    StartPipeline(pipenum);
+#endif
+#if UECLI_01_STATS>0
+    CmdStats* statprev = uecli.statcur;
+    uecli.statcur = FindCmdStats(phand, true);
+    uint64_t starttime = uecli_gettime_ns();
+#endif
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+    const char* rawprev = uecli.cmdraw;
+    int rawlenprev = uecli.cmdrawlen;
+    uecli.cmdraw = raw;
+    uecli.cmdrawlen = rawlen;
+#endif
+    UECLI_TRACE_BEGIN(handlerstart);
+    if (UECLI_TYPE_FUNEX == phand->itemType)
+        status = ((int(*)(int, char**))(uintptr_t)phand->pdata)(count, argcbuff);
+    else if (UECLI_TYPE_BOUND == phand->itemType)
+        status = ((const uecli_Bound*)phand->pdata)->invoke(count, argcbuff);
+    else
+        ((void(*)(int, char**))(uintptr_t)phand->pdata)(count, argcbuff);
+    UECLI_TRACE_END(UECLI_TRACE_HANDLER, phand->exename, handlerstart);
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+    uecli.cmdraw = rawprev;
+    uecli.cmdrawlen = rawlenprev;
+#endif
+#if UECLI_01_STATS>0
+    RecordCmdStats(uecli.statcur, phand, uecli_gettime_ns() - starttime);
+    uecli.statcur = statprev;
+#endif
+#if UECLI_01_PIPE>0
+    FinishPipeline(pipenum, cancel);
+#endif
+#if UECLI_01_REDIRECT>0
+    if (filename)
+        FinishRedirect(&outer);
+#endif
+    return status;
+}
+
+// 正在执行watch或定时命令 不保存历史记录
+static inline bool IsTimedRun(void)
+{
+    bool timed = false;
+#if UECLI_01_WATCH>0
+    timed = timed || uecli.watchrun;
+#endif
+#if UECLI_01_SCHED>0
+    timed = timed || uecli.schedrun;
+#endif
+    return timed;
+}
+
+// 执行一条命令 命令的重定向和管道只作用于该命令
+static int ExeCommand(char* str, const char* raw, bool* pfound)
+{
+    char* argbuff[UECLI_CFG_MAX_ARGNUM];
+    char** argv = argbuff;
+
+    int status = RunCommand(str, raw, pfound, &argv);
+#if UECLI_01_LONG_LINE>0
+    if (argv != argbuff)
+        uecli_free(argv);
+#endif
+    return status;
+}
+
+// 执行命令行 str在执行过程中被分割，cmdstring为分割前的命令行
+static void ExeLine(char* str, const char* cmdstring)
+{
+    bool found = false;
+
+    // 分割会改变命令行 先为历史记录和命令的原始参数保存一份
+    // 历史记录和watch、定时命令只能保存UECLI_CFG_STR_MAXLEN的命令行，打开长命令行时更长的也不保存
+#if UECLI_01_HISTORY>0 || UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+    char rawline[UECLI_CFG_STR_MAXLEN];
+    uecli_strncpy(rawline, str, UECLI_CFG_STR_MAXLEN);
+    const char* raw = uecli_strlen(rawline) == uecli_strlen(str) ? rawline : NULL;
+#else
+    const char* raw = NULL;
+#endif
+
+    // 结构化输出模式下每条非空命令行输出一条记录
+#if UECLI_01_JSON>0
+    uint64_t recordstart = 0;
+    if (UECLI_FORMAT_TEXT != uecli.format)
+    {
+        recordstart = uecli_gettime_ns();
+        BeginRecord(cmdstring);
+    }
+#endif
+
+#if UECLI_01_SEQUENCE>0
+    char* cmds[UECLI_CFG_SEQUENCE_NUM];
+    uint8_t types[UECLI_CFG_SEQUENCE_NUM];
+    int num = SplitSequence(str, cmds, types, UECLI_CFG_SEQUENCE_NUM);
+    if (num < 0)
+    {
+        uecli_PrintString(STRING_INVALID_SEQUENCE);
+        uecli_PrintString(UECLI_NEWLINE);
+        uecli.status = UECLI_STATUS_SYNTAX;
+    }
+
+    // 跳过的命令不改变执行状态
+    for (int i = 0; i < num; ++i)
+    {
+        if ((SEQUENCE_AND == types[i] && UECLI_STATUS_OK != uecli.status)
+            || (SEQUENCE_OR == types[i] && UECLI_STATUS_OK == uecli.status))
+            continue;
+        uecli.status = ExeCommand(cmds[i], raw ? raw + (cmds[i] - str) : NULL, &found);
+    }
+#else
+    uecli.status = ExeCommand(str, raw, &found);
+#endif
+
+#if UECLI_01_HISTORY>0
+    if (found && raw && !IsTimedRun())
+        SaveHistory(raw);
+#endif
+#if UECLI_01_JSON>0
+    if (uecli.record)
+        EndRecord(uecli.status, uecli_gettime_ns() - recordstart);
+#endif
+    (void)found;
+    (void)cmdstring;
+}
+
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+// 取得正在执行命令从第index个参数开始的原始命令行 保留引号和转义，$?在执行时才展开
+//
+// 只有一个加引号的参数时取去除引号后的参数，含有管道等的命令行可以整体加引号。
+// 命令行超过UECLI_CFG_STR_MAXLEN没有保存时返回false
+static bool GetArgsLine(int argc, char* argv[], int index, char* line)
+{
+    const char* str = uecli.cmdraw;
+    const char* end = str + uecli.cmdrawlen;
+
+    if (NULL == str)
+        return false;
+
+    // 按分割参数的规则跳过前index个参数
+    for (int i = 0; ; ++i)
+    {
+        for (; str < end && IsBlankChar(*str); ++str);
+        if (i == index)
+            break;
+        for (; str < end && !IsBlankChar(*str); ++str)
+        {
+            if (IsQuoteChar(*str))
+                str = SkipQuote((char*)str);
+        }
+    }
+    if (index + 1 == argc && ('"' == *str || '\'' == *str))
+    {
+        str = argv[index];
+        end = str + uecli_strlen(str);
+    }
+    for (; end > str && IsBlankChar(end[-1]); --end);
+
+    memcpy(line, str, end - str);
+    line[end - str] = '\0';
+    return true;
+}
+#endif
+
+// ********************************************************************************************
+// 外部接口函数
+
+/// \brief 初始化CLI命令行对象
+///
+/// \param cmdlist 所支持的命令表
+/// \return void
+void uecli_Initialize(const uecli_MenuItem* cmdlist)
+{
+#if UECLI_01_SESSION>0
+    uecli_cur = &uecli_default;
+#endif
+    memset(&uecli,0,sizeof(uecli));
+    uecli.cmdlist = cmdlist;
+
+    uecli_port_init();      // 底层接口初始化
+    uecli_PrintString(STRING_COPYRIGHT_INFO);
+    UpdateCLIPrompt();      // 更新提示符字符串
+    PrintCLIPrompt();       // 打印提示符
+}
+
+#if UECLI_01_SESSION>0
+
+/// \brief 获取会话对象大小 用于为会话分配内存
+///
+/// \return uint32_t 会话对象字节数
+uint32_t uecli_SessionSize(void)
+{
+    return sizeof(struct uecli_Type);
+}
+
+/// \brief 初始化会话 并向会话输出版本信息和提示符
+///
+/// \param session 会话对象 大小为uecli_SessionSize()
+/// \param cmdlist 所支持的命令表
+/// \param outfun 会话输出函数
+/// \param ctx 输出函数上下文
+/// \return void
+void uecli_SessionInit(uecli_Session* session, const uecli_MenuItem* cmdlist, uecli_OutFun outfun, void* ctx)
+{
+    uecli_Session* prev = uecli_SessionSelect(session);
+
+    memset(&uecli, 0, sizeof(uecli));
+    uecli.cmdlist = cmdlist;
+    uecli.outfun = outfun;
+    uecli.outctx = ctx;
+
+    uecli_PrintString(STRING_COPYRIGHT_INFO);
+    UpdateCLIPrompt();
+    PrintCLIPrompt();
+    uecli_SessionSelect(prev);
+}
+
+/// \brief 释放会话占用的资源 释放会话内存之前调用
+///
+/// \param session 会话对象
+/// \return void
+void uecli_SessionDeinit(uecli_Session* session)
+{
+    uecli_Session* prev = uecli_SessionSelect(session);
+    ClearCmdlineString(&uecli.instring);
+#if UECLI_01_HELP_CACHE>0
+    FreeHelpCache();
+#endif
+    uecli_SessionSelect(prev);
+}
+
+/// \brief 选择当前线程处理的会话 之后在该线程中调用的接口都作用于该会话
+///
+/// \param session 会话对象 NULL表示默认会话
+/// \return uecli_Session* 之前的会话
+uecli_Session* uecli_SessionSelect(uecli_Session* session)
+{
+    uecli_Session* prev = uecli_cur;
+    uecli_cur = session ? session : &uecli_default;
+    return prev;
+}
+
+/// \brief 获取当前会话的输出函数上下文 命令函数中可用于识别所属连接
+///
+/// \return void* 上下文 默认会话返回NULL
+void* uecli_SessionContext(void)
+{
+    return uecli.outctx;
+}
+#endif
+
+#if UECLI_01_STEP>0
+
+/// \brief 获取需要等待的端口描述符 用于加入外部事件循环
+///
+/// \param event UECLI_POLLIN或UECLI_POLLOUT 输入输出可能使用不同的描述符
+/// \return int 描述符
+int uecli_PollFd(uint32_t event)
+{
+    return uecli_port_pollfd(event);
+}
+
+/// \brief 获取当前需要等待的事件 每次处理后应重新获取
+///
+/// 捕获命令暂时不能接收数据时不等待可读，命令恢复接收后应直接调用uecli_OnReadable
+/// \return uint32_t UECLI_POLLIN，发送队列中有数据时加上UECLI_POLLOUT
+uint32_t uecli_PollEvents(void)
+{
+    return (uecli_rx.pos < uecli_rx.len ? 0 : UECLI_POLLIN)
+        | (uecli_tx.head != uecli_tx.tail ? UECLI_POLLOUT : 0);
+}
+
+/// \brief 端口可读时调用 读取全部可用数据并处理，不会阻塞
+///
+/// 捕获命令暂时不能接收时停止读取端口，数据留在端口中形成反压
+/// \return bool 端口已关闭或出错返回false
+bool uecli_OnReadable(void)
+{
+    int len = 0;
+
+    for (;;)
+    {
+        // 先处理上次剩余的数据
+        if (uecli_rx.pos < uecli_rx.len)
+        {
+            uecli_rx.pos += (uint16_t)uecli_ProcessInput(&uecli_rx.buff[uecli_rx.pos], uecli_rx.len - uecli_rx.pos);
+            if (uecli_rx.pos < uecli_rx.len)
+                return true;
+        }
+        if ((len = uecli_port_read(uecli_rx.buff, sizeof(uecli_rx.buff))) <= 0)
+            break;
+        uecli_rx.pos = 0;
+        uecli_rx.len = (uint16_t)len;
+    }
+    return len >= 0;
+}
+
+/// \brief 端口可写时调用 发送队列中的数据，不会阻塞
+///
+/// \return void
+void uecli_OnWritable(void)
+{
+    while (uecli_tx.head != uecli_tx.tail)
+    {
+        // 发送环形缓存中连续的一段
+        uint32_t pos = uecli_tx.tail & (UECLI_CFG_STEP_OUTSIZE - 1);
+        uint32_t num = uecli_tx.head - uecli_tx.tail;
+        if (num > UECLI_CFG_STEP_OUTSIZE - pos)
+            num = UECLI_CFG_STEP_OUTSIZE - pos;
+
+        int len = uecli_port_write(&uecli_tx.buff[pos], num);
+        if (len < 0)
+            uecli_tx.tail = uecli_tx.head;
+        else
+            uecli_tx.tail += (uint32_t)len;
+        if (len < (int)num)
+            break;
+    }
+}
+#endif
+
+#if UECLI_01_INPUT_RING>0
+
+/// \brief 在中断或接收线程中放入输入数据 不加锁不等待
+///
+/// 只允许一个生产者调用，队列满时多出的数据被丢弃并计入溢出计数
+/// \param buff 输入数据
+/// \param num 数据数量
+/// \return uint32_t 实际放入的数量
+uint32_t uecli_PushInputISR(const void* buff, uint32_t num)
+{
+    uint32_t head = uecli_inring.head;
+    uint32_t space = UECLI_CFG_INPUT_RINGSIZE - (head - uecli_atomic_load(&uecli_inring.tail));
+
+    if (num > space)
+    {
+        uecli_atomic_store(&uecli_inring.overflow, uecli_inring.overflow + num - space);
+        num = space;
+    }
+
+    // 分两段复制到环形缓存
+    uint32_t pos = head & (UECLI_CFG_INPUT_RINGSIZE - 1);
+    uint32_t first = UECLI_CFG_INPUT_RINGSIZE - pos;
+    if (first > num)
+        first = num;
+    memcpy(&uecli_inring.buff[pos], buff, first);
+    memcpy(uecli_inring.buff, (const char*)buff + first, num - first);
+
+    // 数据写入完成后再发布写入位置
+    uecli_atomic_store(&uecli_inring.head, head + num);
+    return num;
+}
+
+/// \brief 在任务中处理队列中的全部输入
+///
+/// 直接以环形缓存中连续的数据段调用uecli_ProcessInput，处理完成后才释放空间，
+/// 捕获命令暂时不能接收时未处理的数据留在队列中，队列满后uecli_PushInputISR返回值变小
+/// \return uint32_t 处理的字节数
+uint32_t uecli_DrainInput(void)
+{
+    uint32_t tail = uecli_inring.tail;
+    uint32_t head = uecli_atomic_load(&uecli_inring.head);
+    uint32_t start = tail;
+
+    while (tail != head)
+    {
+        uint32_t pos = tail & (UECLI_CFG_INPUT_RINGSIZE - 1);
+        uint32_t num = head - tail;
+        if (num > UECLI_CFG_INPUT_RINGSIZE - pos)
+            num = UECLI_CFG_INPUT_RINGSIZE - pos;
+
+        uint32_t done = (uint32_t)uecli_ProcessInput(&uecli_inring.buff[pos], (int)num);
+        tail += done;
+        uecli_atomic_store(&uecli_inring.tail, tail);
+        if (done < num)
+            break;
+    }
+    return tail - start;
+}
+
+/// \brief 获取输入队列溢出丢弃的字节数
+///
+/// \return uint32_t 溢出字节数
+uint32_t uecli_InputOverflow(void)
+{
+    return uecli_atomic_load(&uecli_inring.overflow);
+}
+#endif
+
+#if UECLI_01_JSON>0
+
+/// \brief 设置当前会话的输出格式
+///
+/// 结构化格式下不回显输入也不显示提示符，每条命令输出一条记录
+/// \param format 输出格式
+/// \return void
+void uecli_SetFormat(uecli_Format format)
+{
+    uecli.format = (uint8_t)format;
+}
+
+/// \brief 获取命令记录写入器
+///
+/// 命令函数可以通过写入器在记录的out数组中写入结构化数据，
+/// 写入的数据不经过管道和重定向
+/// \return uecli_Json* 文本格式或不在命令中时返回NULL
+uecli_Json* uecli_JsonOutput(void)
+{
+    return uecli.record ? &uecli.json : NULL;
+}
+#endif
+
+#if UECLI_01_TX_RING>0
+
+/// \brief 端口获取发送队列中连续的一段数据
+///
+/// 端口发送完成后调用uecli_TxConsume释放，只允许一个发送线程或中断调用
+/// \param pbuff 返回数据起始地址
+/// \return uint32_t 数据长度 队列为空时返回0
+uint32_t uecli_TxPeek(const char** pbuff)
+{
+    uint32_t tail = uecli_txring.tail;
+    uint32_t pos = tail & (UECLI_CFG_TX_RINGSIZE - 1);
+    uint32_t num = uecli_atomic_load(&uecli_txring.head) - tail;
+
+    if (num > UECLI_CFG_TX_RINGSIZE - pos)
+        num = UECLI_CFG_TX_RINGSIZE - pos;
+    *pbuff = &uecli_txring.buff[pos];
+    return num;
+}
+
+/// \brief 端口释放已发送的数据
+///
+/// \param num 已发送的字节数 不能超过uecli_TxPeek返回的长度
+/// \return void
+void uecli_TxConsume(uint32_t num)
+{
+    uecli_atomic_store(&uecli_txring.tail, uecli_txring.tail + num);
+}
+
+/// \brief 获取发送队列中等待发送的字节数
+///
+/// \return uint32_t 字节数
+uint32_t uecli_TxPending(void)
+{
+    return uecli_atomic_load(&uecli_txring.head) - uecli_atomic_load(&uecli_txring.tail);
+}
+
+/// \brief 发送队列是否超过高水位
+///
+/// 输出大量数据的命令可以在返回true时先处理其他工作，继续输出将暂停到队列低于低水位
+/// \return bool 超过高水位返回true
+bool uecli_OutputBusy(void)
+{
+    return uecli_TxPending() >= UECLI_CFG_TX_HIGHWATER;
+}
+#endif
+
+#if UECLI_01_ASYNC_LOG>0
+
+/// \brief 在任意线程中写入一条日志 不加锁不等待
+///
+/// 日志由会话线程调用uecli_DrainLog输出，超过UECLI_CFG_LOG_LINELEN的部分被截断
+/// \param str 日志内容 不需要换行符
+/// \return bool 队列满丢弃时返回false
+bool uecli_Log(const char* str)
+{
+    uint32_t pos = uecli_atomic_load(&uecli_log.enqueue);
+    LogSlot* pslot;
+
+    for (;;)
+    {
+        uint32_t lap = pos & ~(uint32_t)(UECLI_CFG_LOG_SLOTS - 1);
+        pslot = &uecli_log.slot[pos & (UECLI_CFG_LOG_SLOTS - 1)];
+        int32_t diff = (int32_t)(uecli_atomic_load(&pslot->seq) - lap);
+
+        if (0 == diff)
+        {
+            if (uecli_atomic_cas(&uecli_log.enqueue, pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // 上一圈的日志还没有被取出
+            uecli_atomic_fetch_add(&uecli_log.dropped, 1);
+            return false;
+        }
+        pos = uecli_atomic_load(&uecli_log.enqueue);
+    }
+
+    uecli_strncpy(pslot->text, str, UECLI_CFG_LOG_LINELEN);
+    uecli_atomic_store(&pslot->seq, (pos & ~(uint32_t)(UECLI_CFG_LOG_SLOTS - 1)) + 1);
+    return true;
+}
+
+/// \brief 格式化写入一条日志
+///
+/// \param fmt 格式字符串
+/// \return bool 队列满丢弃时返回false
+bool uecli_Logf(const char* fmt, ...)
+{
+    char buff[UECLI_CFG_LOG_LINELEN];
+    va_list ap;
+
+    va_start(ap, fmt);
+    uecli_vsnprintf(buff, sizeof(buff), fmt, ap);
+    va_end(ap);
+    return uecli_Log(buff);
+}
+
+// 日志输出缓存 第一次写入时先擦除当前行
+typedef struct
+{
+    char buff[256];
+    uint32_t len;
+    bool erased;
+}LogBurst;
+
+static void LogAppend(LogBurst* pb, const char* str)
+{
+    if (!pb->erased)
+    {
+        pb->erased = true;
+        LogAppend(pb, "\r\033[K");
+    }
+    for (; *str; ++str)
+    {
+        if (pb->len == sizeof(pb->buff))
+        {
+            PortOut(pb->buff, pb->len);
+            pb->len = 0;
+        }
+        pb->buff[pb->len++] = *str;
+    }
+}
+
+/// \brief 在会话线程中输出队列中的日志
+///
+/// 有日志时擦除提示符和正在输入的命令行，输出日志后重新显示，全部内容合并为一次输出。
+/// 每秒最多显示UECLI_CFG_LOG_RATE条，超出和队列满丢弃的日志每秒提示一次数量。
+/// JSON/CBOR模式或捕获输入(watch、分页等)期间日志留在队列中，恢复后再输出。
+/// 应在等待输入的循环中定期调用，不能在命令函数中调用
+/// \return void
+void uecli_DrainLog(void)
+{
+    uint64_t now = uecli_gettime_ns();
+    LogBurst burst;
+
+    // 插入的日志会混入结构化记录、画面或捕获的数据
+#if UECLI_01_JSON>0
+    if (UECLI_FORMAT_TEXT != uecli.format)
+        return;
+#endif
+#if UECLI_01_IN_HOOK>0
+    if (uecli.capturing)
+        return;
+#endif
+    if (uecli.running)
+        return;
+
+    burst.len = 0;
+    burst.erased = false;
+
+    // 按经过的时间补充可显示的条数 不足一条的时间留到下次，已满时不累计
+    uint64_t elapsed = now - uecli_log.filltime;
+    uint64_t fill = elapsed >= 1000000000u ? UECLI_CFG_LOG_RATE : elapsed * UECLI_CFG_LOG_RATE / 1000000000u;
+    if (fill + uecli_log.tokens >= UECLI_CFG_LOG_RATE)
+    {
+        uecli_log.tokens = UECLI_CFG_LOG_RATE;
+        uecli_log.filltime = now;
+    }
+    else
+    {
+        uecli_log.tokens += (uint32_t)fill;
+        uecli_log.filltime += fill * 1000000000u / UECLI_CFG_LOG_RATE;
+    }
+
+    for (;;)
+    {
+        uint32_t pos = uecli_log.dequeue;
+        uint32_t lap = pos & ~(uint32_t)(UECLI_CFG_LOG_SLOTS - 1);
+        LogSlot* pslot = &uecli_log.slot[pos & (UECLI_CFG_LOG_SLOTS - 1)];
+
+        if (uecli_atomic_load(&pslot->seq) != lap + 1)
+            break;
+        if (uecli_log.tokens)
+        {
+            --uecli_log.tokens;
+            LogAppend(&burst, pslot->text);
+            LogAppend(&burst, UECLI_NEWLINE);
+        }
+        else
+            ++uecli_log.suppressed;
+        uecli_atomic_store(&pslot->seq, lap + UECLI_CFG_LOG_SLOTS);
+        uecli_log.dequeue = pos + 1;
+    }
+
+    // 提示抑制的数量
+    uint32_t dropped = uecli_atomic_load(&uecli_log.dropped);
+    uecli_log.suppressed += dropped - uecli_log.reported;
+    uecli_log.reported = dropped;
+    if (uecli_log.suppressed && now - uecli_log.noticetime >= 1000000000u)
+    {
+        char notice[48];
+        uecli_snprintf(notice, sizeof(notice), STRING_LOG_SUPPRESSED, uecli_log.suppressed);
+        LogAppend(&burst, notice);
+        uecli_log.suppressed = 0;
+        uecli_log.noticetime = now;
+    }
+
+    // 重新显示提示符和正在输入的命令行 提示符开头的换行已经由日志输出
+    if (burst.erased)
+    {
+        LogAppend(&burst, uecli.prompt + sizeof(UECLI_NEWLINE) - 1);
+        LogAppend(&burst, GetCmdlineString(&uecli.instring));
+    }
+    if (burst.len)
+        PortOut(burst.buff, burst.len);
+}
+#endif
+
+#if UECLI_01_IN_HOOK>0
+
+// 结束捕获 恢复命令行
+static void EndCapture(uecli_CaptureEnd reason)
+{
+    uecli.capturing = false;
+    if (uecli.capture.endfun)
+        uecli.capture.endfun(uecli.capture.ctx, reason);
+
+    // 在命令函数中结束时由命令行执行完成后打印提示符
+    if (!uecli.running)
+        PrintCLIPrompt();
+}
+
+// 把数据交给捕获命令 返回命令处理的字节数
+static uint32_t CaptureData(const char* buff, uint32_t num)
+{
+    if (0 == num)
+        return 0;
+
+    uint32_t done = uecli.capture.datafun(uecli.capture.ctx, buff, num);
+    if (done > num)
+        done = num;
+    uecli.capbytes += done;
+    return done;
+}
+
+// 结束序列前m个字节匹配而下一个字节不匹配时 仍可能匹配的最长前缀(KMP失败函数)
+// 结束序列通常只有几个字节，直接比较计算，不在会话中保存失败表
+static uint32_t EscapeFallback(const char* escape, uint32_t m)
+{
+    for (uint32_t k = m - 1; k > 0; --k)
+    {
+        if (0 == memcmp(escape, &escape[m - k], k))
+            return k;
+    }
+    return 0;
+}
+
+// 捕获模式下处理输入 返回处理的字节数
+static int CaptureInput(const char* buff, int len)
+{
+    const char* escape = uecli.capture.escape;
+    uint64_t now = uecli_gettime_ns();
+
+    // 空闲超时 剩余的数据按命令行处理
+    if (uecli.capture.timeoutms
+        && now - uecli.caplast >= (uint64_t)uecli.capture.timeoutms * 1000000u)
+    {
+        EndCapture(UECLI_CAPTURE_TIMEOUT);
+        return 0;
+    }
+    if (len > 0)
+        uecli.caplast = now;
+
+    // 先补交匹配失败的结束序列 其内容就是结束序列的开头部分
+    if (uecli.escoff < uecli.escowed)
+    {
+        uecli.escoff += (uint8_t)CaptureData(&escape[uecli.escoff], uecli.escowed - uecli.escoff);
+        if (uecli.escoff < uecli.escowed || !uecli.capturing)
+            return 0;
+    }
+
+    uint32_t num = (uint32_t)len;
+    if (uecli.capture.bytes && num > uecli.capture.bytes - uecli.capbytes)
+        num = (uint32_t)(uecli.capture.bytes - uecli.capbytes);
+
+    // 查找结束序列 数据末尾不完整的结束序列暂不交给命令
+    uint32_t used = num;        // 处理的输入字节数
+    uint32_t end = num;         // 交给命令的数据结尾
+    bool found = false;
+    if (escape)
+    {
+        uint32_t held = uecli.escmatch;
+        uint32_t m = held;
+        for (uint32_t i = 0; i < num; ++i)
+        {
+            // 没有部分匹配时直接查找结束序列的第一个字符
+            if (0 == m)
+            {
+                const char* p = (const char*)memchr(&buff[i], escape[0], num - i);
+                if (NULL == p)
+                    break;
+                i = (uint32_t)(p - buff);
+            }
+            // 不匹配时回退到仍可能匹配的位置 结束序列自身重叠时不会漏掉
+            while (m && buff[i] != escape[m])
+                m = EscapeFallback(escape, m);
+            if (buff[i] == escape[m] && '\0' == escape[++m])
+            {
+                found = true;
+                used = i + 1;
+                break;
+            }
+        }
+
+        // 之前保留的held字节在前，末尾m字节是结束序列或它的开头，其余交给命令
+        uint32_t deliver = held + used - m;
+        if (held && deliver)
+        {
+            // 保留部分的开头不再属于结束序列 补交后按剩余部分重新处理
+            uint32_t owed = deliver < held ? deliver : held;
+            uecli.escmatch = (uint8_t)(held - owed);
+            uecli.escoff = 0;
+            uecli.escowed = (uint8_t)owed;
+            return CaptureInput(buff, len);
+        }
+        end = held ? 0 : deliver;
+        uecli.escmatch = found ? 0 : (uint8_t)m;
+    }
+
+    uint32_t done = CaptureData(buff, end);
+    if (done < end)
+    {
+        // 命令暂时不能接收 剩余数据以后重新处理
+        uecli.escmatch = 0;
+        return (int)done;
+    }
+    if (!uecli.capturing)
+        return (int)end;
+    if (found)
+        EndCapture(UECLI_CAPTURE_ESCAPE);
+    else if (uecli.capture.bytes && uecli.capbytes >= uecli.capture.bytes)
+        EndCapture(UECLI_CAPTURE_BYTES);
+    return (int)used;
+}
+
+/// \brief 开始捕获输入 通常在命令函数中调用
+///
+/// 捕获期间所有输入不回显不解析，直接交给capture->datafun，
+/// 收到结束序列、达到字节数、空闲超时或调用uecli_CaptureStop后调用endfun并恢复命令行
+/// \param capture 捕获参数 函数内部保存一份拷贝，结束序列字符串需要一直有效
+/// \return bool 已经在捕获或参数无效返回false
+bool uecli_CaptureStart(const uecli_Capture* capture)
+{
+    if (uecli.capturing || NULL == capture || NULL == capture->datafun)
+        return false;
+    if (capture->escape && uecli_strlen(capture->escape) > 255)
+        return false;
+
+    uecli.capture = *capture;
+    if (capture->escape && '\0' == capture->escape[0])
+        uecli.capture.escape = NULL;
+    uecli.escmatch = uecli.escoff = uecli.escowed = 0;
+    uecli.capbytes = 0;
+    uecli.caplast = uecli_gettime_ns();
+    uecli.capturing = true;
+    return true;
+}
+
+/// \brief 结束捕获 可以在捕获的数据处理函数中调用
+///
+/// 本次输入中剩余的数据按命令行处理
+/// \return void
+void uecli_CaptureStop(void)
+{
+    if (uecli.capturing)
+        EndCapture(UECLI_CAPTURE_STOP);
+}
+
+/// \brief 检查是否正在捕获输入
+///
+/// \return bool
+bool uecli_IsCapturing(void)
+{
+    return uecli.capturing;
+}
+
+// 钩子函数的捕获数据处理 数据指针以argv[0]的形式传入
+static uint32_t HookData(void* ctx, const char* buff, uint32_t num)
+{
+    char* pdata = (char*)buff;
+    ((void(*)(int,char**))ctx)((int)num, &pdata);
+    return num;
+}
+
+/// \brief 输入钩子支持 设置后所有的输入数据都传向指定的函数
+///
+/// 钩子函数的argc为数据长度，argv[0]指向数据，基于输入捕获实现
+/// \param pfun 钩子处理函数 NULL表示取消钩子
+/// \return void* 之前的钩子指针
+void* uecli_SetHook(void(*pfun)(int,char**))
+{
+    void* temp = uecli_IsValidHook() ? uecli.capture.ctx : NULL;
+
+    if (temp)
+        uecli_CaptureStop();
+    if (pfun)
+    {
+        uecli_Capture capture = {HookData, NULL, (void*)pfun, NULL, 0, 0};
+        uecli_CaptureStart(&capture);
+    }
+    return temp;
+}
+
+/// \brief 检查是否设置钩子
+///
+/// \return bool
+bool uecli_IsValidHook(void)
+{
+    return uecli.capturing && HookData == uecli.capture.datafun;
+}
+#endif
+
+// ********************************************************************************************
+// watch命令支持
+
+#if UECLI_01_WATCH>0
+
+// 画面第一行在屏幕上的行号 第一行显示命令，第二行空白
+#define WATCH_TOP   (3)
+
+// 命令输出写入当前帧 控制字符和ESC序列不占位置，超出画面的部分丢弃
+static void WatchWrite(const char* buff, int len)
+{
+    char (*frame)[UECLI_CFG_WATCH_COLS] = uecli.frame[uecli.framecur];
+
+    for (; len > 0; --len)
+    {
+        char c = *buff++;
+
+        // ESC[...以字母结束 其他ESC序列为两个字符
+        if (uecli.watchesc)
+        {
+            if (1 == uecli.watchesc && '[' == c)
+                uecli.watchesc = 2;
+            else if (1 == uecli.watchesc || (c >= '@' && c <= '~'))
+                uecli.watchesc = 0;
+            continue;
+        }
+
+        switch (c)
+        {
+        case '\033':
+            uecli.watchesc = 1;
+            break;
+        case '\r':
+            uecli.watchcol = 0;
+            break;
+        case '\n':
+            uecli.watchcol = 0;
+            if (uecli.watchrow < UECLI_CFG_WATCH_ROWS)
+                ++uecli.watchrow;
+            break;
+        case '\t':
+            uecli.watchcol = (uint8_t)((uecli.watchcol + 8) & ~7);
+            if (uecli.watchcol > UECLI_CFG_WATCH_COLS)
+                uecli.watchcol = UECLI_CFG_WATCH_COLS;
+            break;
+        default:
+            if ((uint8_t)c < ' ' || uecli.watchcol >= UECLI_CFG_WATCH_COLS)
+                break;
+            if (uecli.watchrow < UECLI_CFG_WATCH_ROWS)
+                frame[uecli.watchrow][uecli.watchcol] = c;
+            ++uecli.watchcol;
+            break;
+        }
+    }
+}
+
+// 与上一帧比较 只发送变化的行中从第一个到最后一个变化字符之间的部分
+static void WatchRender(void)
+{
+    char (*cur)[UECLI_CFG_WATCH_COLS] = uecli.frame[uecli.framecur];
+    char (*old)[UECLI_CFG_WATCH_COLS] = uecli.frame[uecli.framecur ^ 1];
+    char move[16];
+
+    for (int row = 0; row < UECLI_CFG_WATCH_ROWS; ++row)
+    {
+        const char* pcur = cur[row];
+        const char* pold = old[row];
+        int first = 0, last = UECLI_CFG_WATCH_COLS - 1, end = UECLI_CFG_WATCH_COLS;
+
+        if (!memcmp(pcur, pold, UECLI_CFG_WATCH_COLS))
+            continue;
+        for (; pcur[first] == pold[first]; ++first);
+        for (; pcur[last] == pold[last]; --last);
+        for (; end && ' ' == pcur[end - 1]; --end);
+
+        // 含有多字节字符时屏幕列与字节位置不对应 重画整行
+        for (int i = 0; i < UECLI_CFG_WATCH_COLS; ++i)
+        {
+            if ((uint8_t)pcur[i] >= 0x80 || (uint8_t)pold[i] >= 0x80)
+            {
+                first = 0;
+                last = UECLI_CFG_WATCH_COLS - 1;
+                break;
+            }
+        }
+
+        uecli_snprintf(move, sizeof(move), "\033[%d;%dH", row + WATCH_TOP, first + 1);
+        PortOut(move, uecli_strlen(move));
+        if (last >= end)
+        {
+            // 行尾变为空白 擦除到行尾
+            PortOut(&pcur[first], end > first ? (uint32_t)(end - first) : 0);
+            PortOut("\033[K", 3);
+        }
+        else
+            PortOut(&pcur[first], (uint32_t)(last - first + 1));
+    }
+    uecli.watchrows = uecli.watchrow + (uecli.watchcol ? 1 : 0);
+}
+
+// 执行时间已到时执行一次命令并更新画面
+static void WatchPoll(void)
+{
+    if (!uecli.watching || uecli.running)
+        return;
+
+    uint64_t now = uecli_gettime_ns();
+    uint64_t interval = (uint64_t)uecli.watchms * 1000000u;
+    if ((int64_t)(now - uecli.watchnext) < 0)
+        return;
+
+    // 落后超过一个间隔时不补执行
+    uecli.watchnext = now - uecli.watchnext >= interval ? now + interval : uecli.watchnext + interval;
+
+    // 分割会改写命令行 每次执行前重新拷贝
+    char line[UECLI_CFG_STR_MAXLEN];
+    uecli_strncpy(line, uecli.watchline, UECLI_CFG_STR_MAXLEN);
+    memset(uecli.frame[uecli.framecur], ' ', sizeof(uecli.frame[0]));
+    uecli.watchrow = uecli.watchcol = uecli.watchesc = 0;
+
+    uecli.running = uecli.watchrun = true;
+    ExeLine(line, uecli.watchline);
+    uecli.running = uecli.watchrun = false;
+
+    WatchRender();
+    uecli.framecur ^= 1;
+}
+
+// 任意输入结束监视
+static uint32_t WatchKey(void* ctx, const char* buff, uint32_t num)
+{
+    uecli_CaptureStop();
+    (void)ctx;
+    (void)buff;
+    return num;
+}
+
+// 监视结束 光标移到画面之后
+static void WatchEnd(void* ctx, uecli_CaptureEnd reason)
+{
+    char move[16];
+
+    uecli.watching = false;
+    uecli_snprintf(move, sizeof(move), "\033[%d;1H", uecli.watchrows + WATCH_TOP);
+    PortOut(move, uecli_strlen(move));
+    (void)ctx;
+    (void)reason;
+}
+
+// 开始监视 清屏并显示命令，之后由uecli_ProcessInput按间隔执行命令
+static bool WatchStart(const char* cmdline, uint32_t ms)
+{
+    uecli_Capture capture = {WatchKey, WatchEnd, NULL, NULL, 0, 0};
+
+    if (!uecli_CaptureStart(&capture))
+        return false;
+
+    uecli_strncpy(uecli.watchline, cmdline, UECLI_CFG_STR_MAXLEN);
+    uecli.watchms = ms;
+    uecli.watchnext = uecli_gettime_ns();
+    uecli.watchrows = 0;
+    uecli.watching = true;
+    memset(uecli.frame, ' ', sizeof(uecli.frame));
+
+    PortOut(STRING_CLEAR_SCREEN, uecli_strlen(STRING_CLEAR_SCREEN));
+    uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_WATCH_HEAD, ms, cmdline);
+    PortOut(uecli.tmpString, uecli_strlen(uecli.tmpString));
+    return true;
+}
+#endif
+
+// ********************************************************************************************
+// 定时命令支持
+
+#if UECLI_01_SCHED>0
+
+// 当前节拍
+static inline uint32_t SchedNow(void)
+{
+    return (uint32_t)(uecli_gettime_ns() / SCHED_TICKNS);
+}
+
+// 毫秒数转换为节拍数 不足一个节拍按一个节拍计算
+static inline uint32_t SchedTicks(uint32_t ms)
+{
+    uint32_t ticks = ms / UECLI_CFG_SCHED_TICK + (ms % UECLI_CFG_SCHED_TICK ? 1 : 0);
+    return ticks ? ticks : 1;
+}
+
+// 最低的置位序号 mask不能为0
+static inline uint32_t SchedFirstBit(uint32_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(mask);
+#else
+    uint32_t index = 0;
+    for (; !(mask & 1); mask >>= 1) ++index;
+    return index;
+#endif
+}
+
+// 加入链表头部
+static void SchedPush(uint16_t id, uint16_t list)
+{
+    SchedTimer* pt = &uecli.sched[id - 1];
+
+    pt->list = list;
+    pt->prev = 0;
+    pt->next = uecli.schedhead[list];
+    if (pt->next)
+        uecli.sched[pt->next - 1].prev = id;
+    uecli.schedhead[list] = id;
+    if (list != SCHED_FREE && list < SCHED_RUN)
+        uecli.schedmap[(list - 1) / SCHED_SLOTS] |= 1u << ((list - 1) % SCHED_SLOTS);
+}
+
+// 从所在链表中移除 槽变为空时清除位图
+static void SchedUnlink(uint16_t id)
+{
+    SchedTimer* pt = &uecli.sched[id - 1];
+
+    if (SCHED_EXEC == pt->list)
+        return;
+    if (pt->prev)
+        uecli.sched[pt->prev - 1].next = pt->next;
+    else
+        uecli.schedhead[pt->list] = pt->next;
+    if (pt->next)
+        uecli.sched[pt->next - 1].prev = pt->prev;
+    if (!uecli.schedhead[pt->list] && pt->list != SCHED_FREE && pt->list < SCHED_RUN)
+        uecli.schedmap[(pt->list - 1) / SCHED_SLOTS] &= ~(1u << ((pt->list - 1) % SCHED_SLOTS));
+}
+
+// 按到期节拍放入时间轮 距离当前节拍越远放入越高的级，超出范围的放入最远的槽，到达后重新放入
+static void SchedPlace(uint16_t id)
+{
+    uint32_t delta = uecli.sched[id - 1].expire - uecli.schedtick;
+    int level = 0;
+
+    if ((int32_t)delta < 0)
+        delta = 0;
+    else if (delta >= SCHED_RANGE)
+        delta = SCHED_RANGE - 1;
+    while (delta >> ((level + 1) * SCHED_BITS))
+        ++level;
+
+    uint32_t at = uecli.schedtick + delta;
+    SchedPush(id, (uint16_t)(1 + level * SCHED_SLOTS + ((at >> (level * SCHED_BITS)) & (SCHED_SLOTS - 1))));
+}
+
+// 释放定时命令
+static void SchedFree(uint16_t id)
+{
+    SchedPush(id, SCHED_FREE);
+    --uecli.schedcount;
+}
+
+// 下一个需要处理的节拍 没有定时命令时返回false
+// 第0级为槽中命令到期的节拍，其他级为槽中命令需要移到低级的节拍
+static bool SchedNextTick(uint32_t* ptick)
+{
+    uint32_t tick = uecli.schedtick;
+    uint32_t best = 0;
+    bool found = false;
+
+    if (uecli.schedhead[SCHED_RUN])
+    {
+        *ptick = tick;
+        return true;
+    }
+    for (int level = 0; level < SCHED_LEVELS; ++level)
+    {
+        uint32_t map = uecli.schedmap[level];
+        int shift = level * SCHED_BITS;
+        if (!map)
+            continue;
+
+        // 当前节拍正好是该级的边界时，当前槽也在本节拍处理
+        uint32_t first = (tick >> shift) + ((tick & ((1u << shift) - 1)) ? 1 : 0);
+        uint32_t rot = first & (SCHED_SLOTS - 1);
+        map = (map >> rot) | (map << ((SCHED_SLOTS - rot) & (SCHED_SLOTS - 1)));
+        uint32_t at = (first + SchedFirstBit(map)) << shift;
+        if (!found || at - tick < best - tick)
+            best = at;
+        found = true;
+    }
+    *ptick = best;
+    return found;
+}
+
+// 处理一个节拍 高级槽中的命令移到低级，第0级槽中的命令移到到期链表
+static void SchedAdvance(uint32_t tick)
+{
+    uecli.schedtick = tick;
+    for (int level = 1; level < SCHED_LEVELS && !(tick & ((1u << (level * SCHED_BITS)) - 1)); ++level)
+    {
+        uint16_t list = (uint16_t)(1 + level * SCHED_SLOTS + ((tick >> (level * SCHED_BITS)) & (SCHED_SLOTS - 1)));
+        uint16_t id = uecli.schedhead[list];
+
+        uecli.schedhead[list] = 0;
+        uecli.schedmap[level] &= ~(1u << ((list - 1) % SCHED_SLOTS));
+        while (id)
+        {
+            uint16_t next = uecli.sched[id - 1].next;
+            SchedPlace(id);
+            id = next;
+        }
+    }
+
+    uint16_t list = (uint16_t)(1 + (tick & (SCHED_SLOTS - 1)));
+    for (uint16_t id = uecli.schedhead[list]; id; id = uecli.schedhead[list])
+    {
+        SchedUnlink(id);
+        SchedPush(id, SCHED_RUN);
+    }
+    uecli.schedtick = tick + 1;
+}
+
+// 执行定时命令 擦除正在输入的命令行，执行后重新显示，不改变$?
+static void SchedExec(const SchedTimer* pt)
+{
+    char line[UECLI_CFG_STR_MAXLEN];
+    int status = uecli.status;
+    bool text = true;
+
+#if UECLI_01_JSON>0
+    text = UECLI_FORMAT_TEXT == uecli.format;
+#endif
+    if (text)
+        uecli_PrintString("\r\033[K");
+
+    uecli_strncpy(line, pt->line, UECLI_CFG_STR_MAXLEN);
+    uecli.running = uecli.schedrun = true;
+    ExeLine(line, pt->line);
+    uecli.running = uecli.schedrun = false;
+    uecli.status = status;
+
+    if (text)
+    {
+        PrintCLIPrompt();
+    #if UECLI_01_IN_HOOK>0
+        if (!uecli.capturing)
+    #endif
+        uecli_PrintString(GetCmdlineString(&uecli.instring));
+    }
+}
+
+// 执行到期的定时命令 周期命令落后于计划时不补执行
+static void SchedFire(uint16_t id, uint32_t now)
+{
+    SchedTimer* pt = &uecli.sched[id - 1];
+
+    SchedUnlink(id);
+    if ((int32_t)(pt->expire - now) > 0)
+    {
+        SchedPlace(id);
+        return;
     }
 
-    return c;
+    pt->list = SCHED_EXEC;
+    SchedExec(pt);
+    if (SCHED_EXEC != pt->list)
+        return;     // 执行中被取消
+    if (!pt->period)
+    {
+        SchedFree(id);
+        return;
+    }
+    pt->expire += pt->period;
+    if ((int32_t)(pt->expire - now) <= 0)
+        pt->expire = now + pt->period;
+    SchedPlace(id);
 }
 
-// ƥ
-static const uecli_MenuItem* SearchMatchCommand(const char* cmdstring)
+// 处理到当前节拍为止的定时命令 没有到期命令的节拍直接跳过
+static void SchedPoll(void)
 {
-    const uecli_MenuItem* ptr = NULL;
-    
-    // ϵͳб
-    for (ptr = GetSyscmdHandle(); ptr->pdata; ++ptr)
+    if (!uecli.schedcount || uecli.running)
+        return;
+#if UECLI_01_IN_HOOK>0
+    if (uecli.capturing)
+        return;
+#endif
+
+    uint32_t now = SchedNow();
+    uint32_t next;
+    while (SchedNextTick(&next) && (int32_t)(next - now) <= 0)
     {
-        if (!uecli_strcasecmp(cmdstring, ptr->exename))
-            return ptr;
+        if (!uecli.schedhead[SCHED_RUN])
+            SchedAdvance(next);
+        while (uecli.schedhead[SCHED_RUN])
+        {
+        #if UECLI_01_IN_HOOK>0
+            // 命令开始捕获输入后暂停 捕获结束后继续
+            if (uecli.capturing)
+                return;
+        #endif
+            SchedFire(uecli.schedhead[SCHED_RUN], now);
+        }
     }
-    
-    // ûб
-    for (ptr = GetUserCmdHandle(); ptr->pdata; ++ptr)
+    if ((int32_t)(now - uecli.schedtick) >= 0)
+        uecli.schedtick = now + 1;
+}
+
+// 添加定时命令 返回编号，没有空闲的定时命令时返回0
+static uint16_t SchedAdd(const char* cmdline, uint32_t delayms, uint32_t periodms)
+{
+    uint16_t id = uecli.schedhead[SCHED_FREE];
+    uint32_t now = SchedNow();
+    uint32_t start = (uint32_t)((uecli_gettime_ns() + SCHED_TICKNS - 1) / SCHED_TICKNS);
+
+    if (id)
+        SchedUnlink(id);
+    else if (uecli.schedused < UECLI_CFG_SCHED_NUM)
+        id = ++uecli.schedused;
+    else
+        return 0;
+
+    // 时间轮为空时从当前节拍开始
+    if (!uecli.schedcount++)
+        uecli.schedtick = now;
+
+    SchedTimer* pt = &uecli.sched[id - 1];
+    uecli_strncpy(pt->line, cmdline, UECLI_CFG_STR_MAXLEN);
+    pt->period = periodms ? SchedTicks(periodms) : 0;
+    pt->expire = start + SchedTicks(delayms);     // 从下一个节拍边界开始计算 不会提前执行
+    SchedPlace(id);
+    return id;
+}
+
+// 取消定时命令 编号无效时返回false
+static bool SchedCancel(uint32_t id)
+{
+    if (id < 1 || id > uecli.schedused || SCHED_FREE == uecli.sched[id - 1].list)
+        return false;
+    SchedUnlink((uint16_t)id);
+    SchedFree((uint16_t)id);
+    return true;
+}
+
+// 显示定时命令列表
+static void SchedList(void)
+{
+    uint32_t now = SchedNow();
+
+    uecli_PrintString(STRING_SCHED_HEAD);
+    for (uint16_t id = 1; id <= uecli.schedused; ++id)
     {
-        if (!uecli_strcasecmp(cmdstring, ptr->exename))
-            return ptr;
+        const SchedTimer* pt = &uecli.sched[id - 1];
+        int32_t left = (int32_t)(pt->expire - now);
+
+        if (SCHED_FREE == pt->list)
+            continue;
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_SCHED_ROW, id,
+            left > 0 ? left * UECLI_CFG_SCHED_TICK : 0, (int)pt->period * UECLI_CFG_SCHED_TICK);
+        uecli_PrintString(uecli.tmpString);
+        uecli_PrintString(pt->line);
+        uecli_PrintString(UECLI_NEWLINE);
     }
-    return NULL;
 }
+#endif
 
 // ********************************************************************************************
-// ⲿӿں
+// 分页输出支持
 
-/// \brief ʼCLIж
-///
-/// \param cmdlist ֵ֧
-/// \return void
-void uecli_Initialize(const uecli_MenuItem* cmdlist)
+#if UECLI_01_PAGER>0
+
+// 按键状态
+#define PAGEKEY_NORMAL  (0)     // 等待翻页按键
+#define PAGEKEY_PATTERN (1)     // 正在输入查找的字符串
+#define PAGEKEY_ESC     (2)     // 收到ESC
+#define PAGEKEY_CSI     (3)     // 收到ESC[
+
+// 每页行数 含状态行
+static inline uint8_t PageRows(void)
 {
-    memset(&uecli,0,sizeof(uecli));
-    uecli.cmdlist = cmdlist;
+    return uecli.pagerows ? uecli.pagerows : UECLI_CFG_PAGER_ROWS;
+}
 
-    uecli_port_init();      // ײӿڳʼ
-    uecli_PrintString(STRING_COPYRIGHT_INFO);
-    UpdateCLIPrompt();      // ʾַ
-    PrintCLIPrompt();       // ӡʾ
+static void PagerWrite(const char* buff, int len);
+
+// 显示预取的行
+static void PagerFlushPeek(void)
+{
+    int len = uecli.peeklen;
+
+    uecli.peeklen = 0;
+    PagerWrite(uecli.peekline, len);
 }
 
-#if UECLI_01_IN_HOOK>0
+// 生成函数的输出 不查找时直接发送，查找时按行缓存，找到匹配的行后开始显示
+//
+// 超过行缓存的行只在开头部分查找，匹配时缓存之后的部分直接发送，整行都会显示
+static void PagerWrite(const char* buff, int len)
+{
+    // 预取的行放不下时直接显示 该页多显示一行
+    if (uecli.peeking)
+    {
+        if (uecli.peeklen + len <= UECLI_CFG_PAGER_LINELEN)
+        {
+            memcpy(&uecli.peekline[uecli.peeklen], buff, len);
+            uecli.peeklen += (uint16_t)len;
+            return;
+        }
+        uecli.peeking = false;
+        PagerFlushPeek();
+    }
 
-/// \brief 빳֧ úеݶָĺ
-///
-/// \param pfun Ӵ
-/// \return void* ֮ǰĹָ
-void* uecli_SetHook(void(*pfun)(int,char**))
+    while (len > 0)
+    {
+        if (!uecli.searching)
+        {
+            int num = 0;
+            while (num < len && '\n' != buff[num])
+                ++num;
+            if (num < len)
+            {
+                ++num;
+                ++uecli.pageshown;
+            }
+            PortOut(buff, (uint32_t)num);
+            buff += num;
+            len -= num;
+            continue;
+        }
+
+        char c = *buff++;
+        --len;
+
+        // 开头部分不匹配的超长行 丢弃到行尾
+        if (uecli.pagelen >= UECLI_CFG_PAGER_LINELEN)
+        {
+            if ('\n' == c)
+                uecli.pagelen = 0;
+            continue;
+        }
+        if ('\n' != c)
+        {
+            uecli.pageline[uecli.pagelen++] = c;
+            if (uecli.pagelen < UECLI_CFG_PAGER_LINELEN - 1)
+                continue;
+        }
+
+        // 行结束或行缓存已满时查找
+        uecli.pageline[uecli.pagelen] = '\0';
+        if (estrstr(uecli.pageline, uecli.pattern))
+        {
+            uecli.searching = false;
+            PortOut(uecli.pageline, uecli.pagelen);
+            uecli.pagelen = 0;
+            if ('\n' == c)
+            {
+                PortOut("\n", 1);
+                ++uecli.pageshown;
+            }
+        }
+        else
+            uecli.pagelen = '\n' == c ? 0 : UECLI_CFG_PAGER_LINELEN;
+    }
+}
+
+// 调用生成函数直到显示了rows行 内容已结束或输出被取消时返回false
+//
+// 查找时没有匹配的行不计入显示行数，生成函数一直有内容时靠取消标记结束。
+// 一页显示满后预取下一行，内容正好在页尾结束时也返回false，不再等待翻页
+static bool PagerPull(uint8_t rows)
 {
-    void* temp = (void*)(uecli.hookfun);
-    uecli.hookfun = (void(*)(int,const char**))pfun;
+    bool more = true;
+
+    uecli.pageshown = 0;
+    uecli.pagerun = true;
+    if (uecli.peeklen)
+        PagerFlushPeek();
+    while (uecli.pageshown < rows && (more = !uecli_IsCancelled() && uecli.pager.nextfun(&uecli.pager)))
+        ++uecli.pager.index;
+    if (more && !uecli.searching)
+    {
+        uecli.peeking = true;
+        if ((more = !uecli_IsCancelled() && uecli.pager.nextfun(&uecli.pager)))
+            ++uecli.pager.index;
+        uecli.peeking = false;
+        if (!more && uecli.peeklen)
+            PagerFlushPeek();
+    }
+    uecli.pagerun = false;
+    return more;
+}
 
-    return temp;
+// 显示状态行
+static void PagerStatus(void)
+{
+    PortOut(STRING_PAGER_MORE, uecli_strlen(STRING_PAGER_MORE));
+}
+
+// 擦除状态行
+static inline void PagerErase(void)
+{
+    PortOut("\r\033[K", 4);
+}
+
+// 显示后续的rows行 内容结束时退出分页
+static void PagerNext(uint8_t rows)
+{
+    PagerErase();
+    if (PagerPull(rows))
+    {
+        PagerStatus();
+        return;
+    }
+    if (uecli.searching)
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_PAGER_NOTFOUND, uecli.pattern);
+        PortOut(uecli.tmpString, uecli_strlen(uecli.tmpString));
+    }
+    uecli_CaptureStop();
+}
+
+// 查找下一个匹配的行 从该行开始显示一页
+static void PagerSearch(void)
+{
+    uecli.searching = true;
+    uecli.pagelen = 0;
+    PagerNext((uint8_t)(PageRows() - 1));
+}
+
+// 翻页按键 返回处理的字节数，退出分页后剩余的数据按命令行处理
+static uint32_t PagerKey(void* ctx, const char* buff, uint32_t num)
+{
+    uint32_t i = 0;
+
+    while (i < num && uecli.paging)
+    {
+        char c = buff[i++];
+
+        switch (uecli.pagekey)
+        {
+        case PAGEKEY_PATTERN:
+            if ('\r' == c || '\n' == c)
+            {
+                uecli.pagekey = PAGEKEY_NORMAL;
+                if (uecli.pattern[0])
+                    PagerSearch();
+                else
+                {
+                    PagerErase();
+                    PagerStatus();
+                }
+            }
+            else if (('\b' == c || 0x7F == c) && uecli.pagelen)
+            {
+                uecli.pattern[--uecli.pagelen] = '\0';
+                PortOut("\b \b", 3);
+            }
+            else if (0x1B == c)
+            {
+                uecli.pattern[0] = '\0';
+                uecli.pagekey = PAGEKEY_NORMAL;
+                PagerErase();
+                PagerStatus();
+            }
+            else if ((uint8_t)c >= ' ' && 0x7F != c && uecli.pagelen < UECLI_CFG_PAGER_LINELEN - 1)
+            {
+                uecli.pattern[uecli.pagelen++] = c;
+                uecli.pattern[uecli.pagelen] = '\0';
+                PortOut(&c, 1);
+            }
+            break;
+        case PAGEKEY_ESC:
+            // 方向键等ESC序列不处理
+            uecli.pagekey = '[' == c ? PAGEKEY_CSI : PAGEKEY_NORMAL;
+            break;
+        case PAGEKEY_CSI:
+            if (c >= '@' && c <= '~')
+                uecli.pagekey = PAGEKEY_NORMAL;
+            break;
+        default:
+            switch (c)
+            {
+            case ' ':
+                PagerNext((uint8_t)(PageRows() - 1));
+                break;
+            case '\r':
+            case '\n':
+                PagerNext(1);
+                break;
+            case '/':
+                uecli.pagekey = PAGEKEY_PATTERN;
+                uecli.pagelen = 0;
+                uecli.pattern[0] = '\0';
+                PagerErase();
+                PortOut("/", 1);
+                break;
+            case 'n':
+                if (uecli.pattern[0])
+                    PagerSearch();
+                break;
+            case 'q':
+            case 'Q':
+            case 0x03:
+                PagerErase();
+                uecli_CaptureStop();
+                break;
+            case 0x1B:
+                uecli.pagekey = PAGEKEY_ESC;
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+    }
+    (void)ctx;
+    return i;
+}
+
+// 退出分页 通知生成函数释放资源
+static void PagerEnd(void* ctx, uecli_CaptureEnd reason)
+{
+    uecli.paging = false;
+    if (uecli.pager.endfun)
+        uecli.pager.endfun(&uecli.pager);
+    (void)ctx;
+    (void)reason;
+}
+
+// 输出是否直接显示在终端上 重定向、管道过滤、结构化输出和定时执行时不分页
+static bool CanPage(void)
+{
+    if (uecli.pageoff || uecli.capturing || IsTimedRun())
+        return false;
+#if UECLI_01_PIPE>0
+    if (uecli.pipenum)
+        return false;
+#endif
+#if UECLI_01_REDIRECT>0
+    if (uecli.outfile)
+        return false;
+#endif
+#if UECLI_01_JSON>0
+    if (UECLI_FORMAT_TEXT != uecli.format)
+        return false;
+#endif
+    return true;
 }
+#endif
 
-/// \brief Ƿù
+/// \brief 分页输出 在命令函数中调用
 ///
-/// \return bool
-bool uecli_IsValidHook(void)
+/// 内容由pager->nextfun逐行生成，只在需要显示时调用。输出超过一页时暂停并捕获输入，
+/// 空格显示下一页，回车显示下一行，/查找，n查找下一个，q退出，
+/// 退出或内容结束时调用pager->endfun。不能分页时(重定向、管道过滤、结构化输出等)
+/// 在本函数中生成全部内容，输出被取消时提前结束
+/// \param pager 内容来源 被复制，函数返回后可以释放
+/// \return int 执行状态 UECLI_STATUS_OK
+int uecli_PageOutput(const uecli_Pager* pager)
 {
-    return uecli.hookfun != NULL;
+#if UECLI_01_PAGER>0
+    if (CanPage())
+    {
+        uecli.pager = *pager;
+        uecli.searching = false;
+        uecli.peeklen = 0;
+        if (!PagerPull((uint8_t)(PageRows() - 1)))
+        {
+            if (uecli.pager.endfun)
+                uecli.pager.endfun(&uecli.pager);
+            return UECLI_STATUS_OK;
+        }
+
+        // 超过一页 捕获输入等待翻页按键
+        uecli_Capture capture = {PagerKey, PagerEnd, NULL, NULL, 0, 0};
+        if (uecli_CaptureStart(&capture))
+        {
+            uecli.paging = true;
+            uecli.pagekey = PAGEKEY_NORMAL;
+            uecli.pattern[0] = '\0';
+            PagerStatus();
+            return UECLI_STATUS_OK;
+        }
+        pager = &uecli.pager;
+    }
+#endif
+
+    // 直接生成全部内容
+    uecli_Pager local = *pager;
+    while (!uecli_IsCancelled() && local.nextfun(&local))
+        ++local.index;
+    if (local.endfun)
+        local.endfun(&local);
+    return UECLI_STATUS_OK;
 }
+
+// 没有输入时也需要按时处理的工作
+static void PollTimers(void)
+{
+#if UECLI_01_WATCH>0
+    WatchPoll();
+#endif
+#if UECLI_01_SCHED>0
+    SchedPoll();
 #endif
+}
 
-/// \brief ַзָִ
+/// \brief 对输入的命令行字符串进行分割并查找命令执行
 ///
-/// \param cmdline ַ
-/// \return void
-void uecli_ExeCmdine(const char* cmdstring)
+/// 命令行可以用;、&&、||连接多条命令，&&和||根据上一条命令的执行状态决定是否执行
+/// 其他来源的命令行超过可用的缓存时不执行，返回UECLI_STATUS_SYNTAX
+/// \param cmdline 输入的命令字符串
+/// \return int 最后执行的命令的状态 UECLI_STATUS_*，空白行返回之前的状态
+int uecli_ExeCmdine(const char* cmdstring)
 {
     char strbuff[UECLI_CFG_STR_MAXLEN];
-    char* argcbuff[UECLI_CFG_MAX_ARGNUM];
+    char* str = strbuff;
+
+    // 接收到的命令行直接在输入缓存中分割，其他命令行先拷贝一份
+    if (cmdstring == GetCmdlineString(&uecli.instring))
+        str = GetCmdlineBuff(&uecli.instring);
+    else
+    {
+        // 放不下的命令行不执行 截断后执行的将是另一条命令
+        int len = uecli_strlen(cmdstring) + 1;
+        if (len > UECLI_CFG_STR_MAXLEN)
+        {
+        #if UECLI_01_LONG_LINE>0
+            str = len <= UECLI_CFG_LINE_MAXSIZE ? (char*)uecli_realloc(NULL, len) : NULL;
+        #else
+            str = NULL;
+        #endif
+        }
+        if (str)
+            memcpy(str, cmdstring, len);
+    }
+
+    bool nested = uecli.running;
+    uecli.running = true;
+    if (NULL == str)
+    {
+        uecli_PrintString(STRING_LINE_TOO_LONG);
+        uecli_PrintString(UECLI_NEWLINE);
+        uecli.status = UECLI_STATUS_SYNTAX;
+    }
+    else if (!IsBlankCommand(str))
+        ExeLine(str, cmdstring);
+    uecli.running = nested;
 
-    // ַָıԭݣȿһݳ
-    uecli_strncpy(strbuff, cmdstring, UECLI_CFG_STR_MAXLEN);
-    int count = SplitString(strbuff, argcbuff, UECLI_CFG_MAX_ARGNUM);
+#if UECLI_01_LONG_LINE>0
+    if (str && str != strbuff && str != GetCmdlineBuff(&uecli.instring))
+        uecli_free(str);
+#endif
 
-    // ִ
-    if (count)
+    // 清除命令行输入 打印提示符 嵌套执行时外层命令的参数还在输入缓存中
+    if (!nested)
     {
-        UECLI_LOG("յ:%s", cmdstring);
+        ClearCmdlineString(&uecli.instring);
+        PrintCLIPrompt();
+    }
+    return uecli.status;
+}
+
+/// \brief 处理接收到的字符数据
+///
+/// 捕获命令暂时不能接收的数据被丢弃，需要反压时使用uecli_ProcessInput
+/// \param recchar 接收到的字符数据数组
+/// \param len 数据数量
+/// \return void
+void uecli_ProcessRecChar(const char recchar[], int len)
+{
+    (void)uecli_ProcessInput(recchar, len);
+}
+
+/// \brief 处理接收到的字符数据 返回处理的字节数
+///
+/// 正在捕获输入且捕获命令暂时不能接收时返回值小于len，
+/// 调用者应保留剩余数据并暂停读取端口，稍后重新提供。
+/// 捕获设置了空闲超时、正在执行watch命令或有定时命令时，没有数据时也应按uecli_NextTimeout以len为0调用
+/// \param recchar 接收到的字符数据数组
+/// \param len 数据数量
+/// \return int 处理的字节数
+int uecli_ProcessInput(const char recchar[], int len)
+{
+#if UECLI_01_IN_HOOK>0
+    if (uecli.capturing && len <= 0)
+        CaptureInput(recchar, 0);
+#endif
 
-        const uecli_MenuItem* phand = SearchMatchCommand(argcbuff[0]);
-        if (NULL != phand)
+    for (int i = 0; i < len; )
+    {
+#if UECLI_01_IN_HOOK>0
+        // 捕获模式 命令中开始捕获后剩余的数据也交给命令
+        if (uecli.capturing)
         {
-        #if UECLI_01_HISTORY>0
-            SaveHistory(cmdstring);
-        #endif
-            if (UECLI_TYPE_FUN == phand->itemType)
-                ((void(*)(int, char**))(uint32_t)phand->pdata)(count, argcbuff);
-            else
+            i += CaptureInput(&recchar[i], len - i);
+            if (uecli.capturing)
             {
-            #if UECLI_01_SUBMENU>0
-                PushMenuStack(phand);
-            #endif
+                PollTimers();
+                return i;
             }
+            continue;
         }
-        else
+#endif
+
+#if UECLI_01_JSON>0
+        // 结构化输出模式 不回显也不编辑，回车或换行结束一行
+        if (UECLI_FORMAT_TEXT != uecli.format)
         {
-            UECLI_LOG("\"%s\" Ч", argcbuff[0]);
-            uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN,STRING_INVALID_COMMAND, argcbuff[0]);
-            uecli_PrintString(uecli.tmpString);
-            uecli_PrintString(UECLI_NEWLINE);
+            for (; i < len && '\r' != recchar[i] && '\n' != recchar[i]; ++i)
+                AppendCmdlinechar(&uecli.instring, recchar[i]);
+            if (i++ < len)
+                uecli_ExeCmdine(GetCmdlineString(&uecli.instring));
+            continue;
         }
+#endif
+
+        // 处理接收到的字符直到换行
+        UECLI_TRACE_BEGIN(tracestart);
+        for (; i < len && '\n' != cli_echo(recchar[i]); ++i);
+        UECLI_TRACE_END(UECLI_TRACE_DECODE, NULL, tracestart);
+
+        // 执行命令行 一次收到多行时逐行执行
+        if (i++ < len)
+            uecli_ExeCmdine(GetCmdlineString(&uecli.instring));
     }
-    
-    //  ӡʾ
-    ClearCmdlineString(&uecli.instring);
-    PrintCLIPrompt();
+    PollTimers();
+    return len;
 }
 
-/// \brief յַ
+/// \brief 获取距离下次需要处理定时工作的毫秒数
 ///
-/// \param recchar յַ
-/// \param len 
-/// \return void
-void uecli_ProcessRecChar(const char recchar[], int len)
+/// 捕获的空闲超时、watch命令和定时命令在没有输入时也需要调用uecli_ProcessInput(NULL, 0)处理，
+/// 等待输入时以返回值为超时时间，不需要固定间隔轮询
+/// \return int32_t 毫秒数 -1表示没有定时工作，可以一直等待输入
+int32_t uecli_NextTimeout(void)
 {
-    // Ƿ
-    if (uecli.hookfun)
+    uint64_t now = uecli_gettime_ns();
+    uint64_t wait = UINT64_MAX;
+    bool capturing = false;
+
+#if UECLI_01_IN_HOOK>0
+    capturing = uecli.capturing;
+    if (capturing && uecli.capture.timeoutms)
     {
-        uecli.hookfun(len,&recchar);
-        return;
+        uint64_t deadline = uecli.caplast + (uint64_t)uecli.capture.timeoutms * 1000000u;
+        wait = deadline > now ? deadline - now : 0;
     }
-    
-    // յÿַ
-    for (int i = 0; i < len; ++i)
+#endif
+#if UECLI_01_WATCH>0
+    if (uecli.watching && wait > (uecli.watchnext > now ? uecli.watchnext - now : 0))
+        wait = uecli.watchnext > now ? uecli.watchnext - now : 0;
+#endif
+#if UECLI_01_SCHED>0
+    // 捕获期间不执行定时命令
+    uint32_t next;
+    if (!capturing && uecli.schedcount && SchedNextTick(&next))
     {
-        if ('\n' == cli_echo(recchar[i]))
-        {
-            /* ִ */
-            uecli_ExeCmdine(GetCmdlineString(&uecli.instring));
-            break;
-        }
+        uint64_t tick = now / SCHED_TICKNS;
+        int32_t ticks = (int32_t)(next - (uint32_t)tick);
+        uint64_t sched = ticks > 0 ? (tick + (uint64_t)ticks) * SCHED_TICKNS - now : 0;
+        if (wait > sched)
+            wait = sched;
     }
+#endif
+    (void)capturing;
+    (void)now;
+
+    if (UINT64_MAX == wait)
+        return -1;
+    wait = (wait + 999999u) / 1000000u;
+    return wait > 0x7FFFFFFF ? 0x7FFFFFFF : (int32_t)wait;
+}
+
+#if UECLI_01_HELP_CACHE>0
+/// \brief 命令表的内容改变后调用 所有会话缓存的帮助在下次使用时重新渲染
+///
+/// 命令表是常量时不需要调用，切换命令表和进入子菜单时缓存按命令表区分
+/// \return void
+void uecli_HelpChanged(void)
+{
+    ++uecli_helpgen;
 }
+#endif
 
-/// \brief ӡַָ
+/// \brief 打印指定的字符串
 ///
-/// \param str ӡַ
+/// \param str 待打印的字符串
 /// \return void
 void uecli_PrintString(const char* str)
 {
     if (str)
-        uecli_port_out(str, uecli_strlen(str));
+        OutputData(str, uecli_strlen(str));
+}
+
+/// \brief 按命令行的规则分割字符串 处理引号和转义
+///
+/// 在原位置分割，参数指向str中的位置，可用于命令函数进一步分割参数
+/// \param str 待分割的字符串 分割后被改写
+/// \param argv 参数表
+/// \param size 参数表大小
+/// \return int 参数数量
+int uecli_SplitString(char* str, char* argv[], int size)
+{
+    return SplitString(str, argv, size);
+}
+
+/// \brief 检查命令输出是否已被取消
+///
+/// 输出经过管道且下游已不再需要数据时（如head已输出足够的行数），
+/// 大量输出的命令应检查该标记并尽快返回
+/// \return bool 已取消返回true
+bool uecli_IsCancelled(void)
+{
+#if UECLI_01_PIPE>0
+    return uecli.cancel;
+#else
+    return false;
+#endif
+}
+
+/// \brief 获取上一条命令的执行状态 与命令行中的$?相同
+///
+/// \return int UECLI_STATUS_*或命令函数返回的状态
+int uecli_LastStatus(void)
+{
+    return uecli.status;
+}
+
+/// \brief 计算命令名称的哈希值
+///
+/// 名称中的'A'-'Z'转换为小写后计算32位FNV-1a，初始值与seed异或
+/// uecli.hpp在编译时以相同的算法生成命令表索引
+/// \param name 命令名称
+/// \param seed 哈希种子
+/// \return 哈希值
+uint32_t uecli_HashName(const char* name, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    char c;
+
+    for (; '\0' != (c = *name); ++name)
+    {
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        hash = (hash ^ (uint8_t)c) * 16777619u;
+    }
+    return hash;
 }
 
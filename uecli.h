@@ -1,55 +1,91 @@
 /// \file uecli.h
-/// \brief ļ
+/// \brief 核心文件
 ///
 /// \details
-/// uecli Ƕʽнӿ֧ģ
-/// ֧ȫʷ¼Ӳ˵Ϣ
+/// uecli 是嵌入式精简的命令行接口支持模块
+/// 其支持命令补全、历史记录、子菜单、长帮助信息等特性
 ///
-/// \author ʫ
+/// \author 张诗星
 /// \par
-/// (C) Copyright ݴʿƼ޹˾
+/// (C) Copyright 杭州大仁科技有限公司
 ///
 /// \version
-/// 2017/07/24 ʫ ʼ汾\n
+/// 2017/07/24 张诗星 初始版本\n
 
 #ifndef _U_E_CLI_H_
 #define _U_E_CLI_H_
 
 // ********************************************************************************************
-// ͷļ
+// 头文件
 
 #include <stdint.h>
 #include <stdbool.h>
 #include "uecli_cfg.h"
+#include "uecli_json.h"
 
 // ********************************************************************************************
-// Ͷ
+// 类型定义
 
-/// \brief ˵Ŀ
+/// \brief 命令菜单项条目类型
 ///
 typedef enum
 {
-    UECLI_TYPE_FUN = 0,     ///< ĿΪһԵ
-    UECLI_TYPE_SUBMENU      ///< ĿΪӲ˵
+    UECLI_TYPE_FUN = 0,     ///< 该条目为一个功能性的命令
+    UECLI_TYPE_SUBMENU,     ///< 该条目为子菜单
+    UECLI_TYPE_FUNEX,       ///< 该条目为返回执行状态的命令 int(*)(int, char**)
+    UECLI_TYPE_BOUND,       ///< 该条目的pdata指向uecli_Bound 由uecli.hpp生成
+    UECLI_TYPE_INDEX        ///< 命令表开头的索引项 pdata指向uecli_CmdIndex
 }uecli_ItemType;
 
-/// \brief бͶ
+/// \brief 绑定的命令
 ///
-/// û붨б飬ڳʼʱø
-/// Ϊֵ֧ĸб
+/// 命令函数指针保存在数据对象中，命令表不需要将函数指针转换为void*，可以在编译时生成
 typedef struct
 {
-    const void* pdata;          ///< ָӲ˵ָ
-    uecli_ItemType itemType;    ///< ʾǰĿͣorӲ˵
-    const char* exename;        ///< ƥִַ
-    const char* desc;           ///< ʾhelpе˵ַ
+    int(*invoke)(int argc, char** argv);    ///< 转换参数并调用命令函数 返回执行状态
+}uecli_Bound;
+
+/// \brief 命令表索引
+///
+/// 命令表第一项为UECLI_TYPE_INDEX时，查找命令使用该索引，不再逐项比较
+/// 命令名称转换为小写后以uecli_HashName计算哈希值，从槽hash&mask开始线性探测
+typedef struct
+{
+    uint32_t seed;              ///< 哈希种子
+    uint32_t mask;              ///< 槽数量减1 槽数量为2的幂且大于命令数量
+    const uint16_t* slots;      ///< 命令在命令表中的序号(索引项为0) 0表示空槽
+}uecli_CmdIndex;
+
+/// \brief 命令列表类型定义
+///
+/// 用户必须定义命令列表数组，并在初始化时引用该数组
+/// 数组为包含支持的各种命令的列表
+typedef struct
+{
+    const void* pdata;          ///< 指向命令函数或子菜单命令表的数据指针
+    uecli_ItemType itemType;    ///< 表示当前条目类型，命令or子菜单
+    const char* exename;        ///< 用于匹配执行命令输入的字符串
+    const char* desc;           ///< 显示在help命令中的说明字符串
     
 #if UECLI_01_LONG_HELP>0
-    const char* helpstr;        ///< ʹhelp+ʱʾĳϢ
+    const char* helpstr;        ///< 使用help+命令时显示的长帮助信息
 #endif
 }uecli_MenuItem;
 
-/// \defgroup  UECLI_DECLAREӿ
+/// \brief 链接段命令索引
+///
+/// 由tools/uecli_index.c在编译后生成，放在uecli_index段中
+/// 命令数量与uecli_cmds段不一致时不使用索引，逐项查找
+typedef struct
+{
+    uint32_t seed;                          ///< 哈希种子 与uecli_CmdIndex相同
+    uint32_t mask;                          ///< 槽数量减1
+    uint32_t count;                         ///< 生成索引时的命令数量
+    const uecli_MenuItem* const* slots;     ///< 哈希槽 NULL表示空槽
+    const uecli_MenuItem* const* order;     ///< 按名称排序的命令 help和补全按此顺序显示
+}uecli_SectionIndex;
+
+/// \defgroup  UECLI_DECLARE命令接口声明定义
 /// \{
 #if UECLI_01_LONG_HELP>0     
 #define UECLI_DECLARE_COMMAND(PDATA, EXENAME, HELPSTR, ...) \
@@ -57,41 +93,216 @@ typedef struct
 
 #define UECLI_DECLARE_SUBMENU(PDATA, MENUNAME, HELPSTR) \
     {(void*)PDATA, UECLI_TYPE_SUBMENU, MENUNAME, HELPSTR, 0}
+
+#define UECLI_DECLARE_COMMAND_EX(PDATA, EXENAME, HELPSTR, ...) \
+    {(void*)PDATA, UECLI_TYPE_FUNEX, EXENAME, HELPSTR, ##__VA_ARGS__}
     
 #else
 
-///< ˵
+///< 定义命令菜单项
 #define UECLI_DECLARE_COMMAND(PDATA, EXENAME, HELPSTR, ...) \
     {(void*)PDATA, UECLI_TYPE_FUN, EXENAME, HELPSTR}
 
-///< Ӳ˵
+///< 定义子菜单项
 #define UECLI_DECLARE_SUBMENU(PDATA, MENUNAME, HELPSTR) \
     {(void*)PDATA, UECLI_TYPE_SUBMENU, MENUNAME, HELPSTR}
+
+///< 定义返回执行状态的命令菜单项 命令函数返回UECLI_STATUS_*
+#define UECLI_DECLARE_COMMAND_EX(PDATA, EXENAME, HELPSTR, ...) \
+    {(void*)PDATA, UECLI_TYPE_FUNEX, EXENAME, HELPSTR}
 #endif
 
-///< бβ
+///< 命令列表定义结尾
 #define UECLI_DECLARE_END() {0}
+
+///< 命令表索引项 必须为命令表的第一项
+#define UECLI_DECLARE_INDEX(PINDEX) \
+    {(const void*)(PINDEX), UECLI_TYPE_INDEX, 0, 0}
 /// \}
 
+/// \defgroup  UECLI_COMMAND链接段命令定义
+/// 在任意源文件中定义命令，链接时放入uecli_cmds段，自动加入根命令表
+/// 命令名称NAME为标识符，同名命令链接时报告重复定义
+/// \{
+#if UECLI_01_SECTION>0
+#ifdef __cplusplus
+#define UECLI_SECTION_LINKAGE extern "C"
+#else
+#define UECLI_SECTION_LINKAGE
+#endif
+
+#define UECLI_SECTION_ITEM(NAME, ...) \
+    UECLI_SECTION_LINKAGE const uecli_MenuItem uecli_cmd_##NAME \
+    __attribute__((used, section("uecli_cmds"), aligned(__alignof__(uecli_MenuItem)))) = __VA_ARGS__
+
+///< 定义命令 参数与UECLI_DECLARE_COMMAND相同，名称不加引号
+#define UECLI_COMMAND(NAME, PDATA, HELPSTR, ...) \
+    UECLI_SECTION_ITEM(NAME, UECLI_DECLARE_COMMAND(PDATA, #NAME, HELPSTR, ##__VA_ARGS__))
+
+///< 定义返回执行状态的命令
+#define UECLI_COMMAND_EX(NAME, PDATA, HELPSTR, ...) \
+    UECLI_SECTION_ITEM(NAME, UECLI_DECLARE_COMMAND_EX(PDATA, #NAME, HELPSTR, ##__VA_ARGS__))
+
+///< 定义子菜单
+#define UECLI_COMMAND_MENU(NAME, PDATA, HELPSTR) \
+    UECLI_SECTION_ITEM(NAME, UECLI_DECLARE_SUBMENU(PDATA, #NAME, HELPSTR))
+
+///< 命令索引 由tools/uecli_index.c生成
+#define UECLI_SECTION_INDEX(SEED, MASK, COUNT, SLOTS, ORDER) \
+    UECLI_SECTION_LINKAGE const uecli_SectionIndex uecli_section_index \
+    __attribute__((used, section("uecli_index"))) = {SEED, MASK, COUNT, SLOTS, ORDER}
+#endif
+/// \}
+
+/// \defgroup  UECLI_STATUS命令执行状态 与shell的退出码含义相同
+/// \{
+#define UECLI_STATUS_OK         (0)     ///< 执行成功
+#define UECLI_STATUS_ERROR      (1)     ///< 执行失败
+#define UECLI_STATUS_SYNTAX     (2)     ///< 命令行格式错误 如重定向或过滤器无效
+#define UECLI_STATUS_NOTFOUND   (127)   ///< 命令不存在
+/// \}
+
+#if UECLI_01_SESSION>0
+/// \brief 会话对象
+///
+/// 每个会话拥有独立的输入行、历史记录、子菜单和输出状态
+/// 会话内存由用户分配，大小通过uecli_SessionSize获取
+typedef struct uecli_Type uecli_Session;
+
+/// \brief 会话输出函数 ctx为初始化会话时指定的上下文
+typedef void(*uecli_OutFun)(void* ctx, const void* buff, uint32_t num);
+#endif
+
+#if UECLI_01_JSON>0
+/// \brief 会话输出格式
+///
+typedef enum
+{
+    UECLI_FORMAT_TEXT = 0,  ///< 文本 有回显和提示符
+    UECLI_FORMAT_JSON,      ///< 每条命令输出一行JSON记录 无回显和提示符
+    UECLI_FORMAT_CBOR       ///< 每条命令输出一个CBOR记录 无回显和提示符
+}uecli_Format;
+#endif
+
+#if UECLI_01_IN_HOOK>0
+/// \brief 捕获结束原因
+///
+typedef enum
+{
+    UECLI_CAPTURE_ESCAPE = 0,   ///< 收到结束序列
+    UECLI_CAPTURE_BYTES,        ///< 达到指定的字节数
+    UECLI_CAPTURE_TIMEOUT,      ///< 超过指定时间没有收到数据
+    UECLI_CAPTURE_STOP          ///< 调用uecli_CaptureStop结束
+}uecli_CaptureEnd;
+
+/// \brief 输入捕获参数
+///
+/// 捕获期间输入数据不回显也不解析，直接以输入缓存中的数据段调用datafun，
+/// datafun返回处理的字节数，小于num时剩余数据由uecli_ProcessInput返回给调用者稍后重新提供
+typedef struct
+{
+    uint32_t(*datafun)(void* ctx, const char* buff, uint32_t num);  ///< 数据处理函数
+    void(*endfun)(void* ctx, uecli_CaptureEnd reason);              ///< 捕获结束时调用 可为NULL
+    void* ctx;                  ///< 函数的上下文参数
+    const char* escape;         ///< 结束序列 不交给datafun，NULL表示不使用
+    uint64_t bytes;             ///< 捕获的字节数 0表示不限制
+    uint32_t timeoutms;         ///< 空闲超时毫秒数 0表示不限制
+}uecli_Capture;
+#endif
+
+/// \brief 分页输出的内容来源
+///
+/// 分页器只在需要显示时调用nextfun，每次调用用uecli_PrintString等输出下一行，
+/// 输出结束或用户退出后调用endfun释放生成内容占用的资源
+typedef struct uecli_Pager uecli_Pager;
+struct uecli_Pager
+{
+    bool(*nextfun)(uecli_Pager* pager);     ///< 输出第index行 没有更多内容时返回false
+    void(*endfun)(uecli_Pager* pager);      ///< 结束时调用 可为NULL
+    void* ctx;                  ///< 生成函数的上下文
+    uintptr_t cursor;           ///< 生成函数保存的位置 如指针或偏移
+    uint32_t index;             ///< 已生成的行数 由分页器在nextfun返回true后递增
+};
+
+#if UECLI_01_STEP>0
+/// \defgroup  UECLI_POLL等待事件 数值与POSIX的POLLIN/POLLOUT相同
+/// \{
+#define UECLI_POLLIN    (0x0001)    ///< 等待端口可读
+#define UECLI_POLLOUT   (0x0004)    ///< 等待端口可写 发送队列中有数据时需要
+/// \}
+#endif
+
 // ********************************************************************************************
-// ӿں
+// 接口函数
 
-//C C++ϱ
+//兼容C C++混合编程
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void uecli_Initialize(const uecli_MenuItem* cmdlist);
-void uecli_ExeCmdine(const char* cmdstring);
+int uecli_ExeCmdine(const char* cmdstring);
 void uecli_ProcessRecChar(const char recchar[], int len);
+int uecli_ProcessInput(const char recchar[], int len);
+int32_t uecli_NextTimeout(void);
+int uecli_PageOutput(const uecli_Pager* pager);
+#if UECLI_01_HELP_CACHE>0
+void uecli_HelpChanged(void);
+#endif
 void uecli_PrintString(const char* str);
+int uecli_SplitString(char* str, char* argv[], int size);
+bool uecli_IsCancelled(void);
+int uecli_LastStatus(void);
+uint32_t uecli_HashName(const char* name, uint32_t seed);
+
+#if UECLI_01_SESSION>0
+uint32_t uecli_SessionSize(void);
+void uecli_SessionInit(uecli_Session* session, const uecli_MenuItem* cmdlist, uecli_OutFun outfun, void* ctx);
+void uecli_SessionDeinit(uecli_Session* session);
+uecli_Session* uecli_SessionSelect(uecli_Session* session);
+void* uecli_SessionContext(void);
+#endif
+
+#if UECLI_01_STEP>0
+int uecli_PollFd(uint32_t event);
+uint32_t uecli_PollEvents(void);
+bool uecli_OnReadable(void);
+void uecli_OnWritable(void);
+#endif
+
+#if UECLI_01_INPUT_RING>0
+uint32_t uecli_PushInputISR(const void* buff, uint32_t num);
+uint32_t uecli_DrainInput(void);
+uint32_t uecli_InputOverflow(void);
+#endif
+
+#if UECLI_01_ASYNC_LOG>0
+bool uecli_Log(const char* str);
+bool uecli_Logf(const char* fmt, ...);
+void uecli_DrainLog(void);
+#endif
+
+#if UECLI_01_TX_RING>0
+uint32_t uecli_TxPeek(const char** pbuff);
+void uecli_TxConsume(uint32_t num);
+uint32_t uecli_TxPending(void);
+bool uecli_OutputBusy(void);
+#endif
+
+#if UECLI_01_JSON>0
+void uecli_SetFormat(uecli_Format format);
+uecli_Json* uecli_JsonOutput(void);
+#endif
 
 #if UECLI_01_IN_HOOK>0
+bool uecli_CaptureStart(const uecli_Capture* capture);
+void uecli_CaptureStop(void);
+bool uecli_IsCapturing(void);
 void* uecli_SetHook(void(*pfun)(int,char**));
 bool uecli_IsValidHook(void);
 #endif
 
-//C C++ϱ
+//兼容C C++混合编程
 #ifdef __cplusplus
 }
 #endif
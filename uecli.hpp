@@ -0,0 +1,859 @@
+﻿/// \file uecli.hpp
+/// \brief C++命令表
+///
+/// \details
+/// 在编译时由带类型的命令函数生成命令表，需要C++17
+/// - 命令函数的参数由命令行参数转换，支持整数、bool、浮点数、const char*和std::optional
+/// - 命令表按名称排序，第一项为哈希索引，查找命令不需要运行时初始化
+/// - 名称重复(不区分大小写)、与系统命令冲突或含有空白和特殊字符时编译失败
+/// - C++20时提供uecli::format和uecli::print，格式在编译时解析并检查参数
+///
+/// \code
+/// static int led(int32_t index, bool on) { ... }
+/// static void reboot() { ... }
+/// UECLI_TABLE(systable,
+///     uecli::Command<&reboot>("reboot", "重启"));
+/// UECLI_TABLE(maintable,
+///     uecli::Command<&led>("led", "控制LED", "led <序号> <on|off>"),
+///     uecli::Menu("sys", "系统菜单", systable));
+/// uecli_Initialize(maintable);
+/// \endcode
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/28 张诗星 初始版本\n
+
+#ifndef _U_E_CLI_HPP_
+#define _U_E_CLI_HPP_
+
+// ********************************************************************************************
+// 头文件
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "uecli.h"
+
+namespace uecli
+{
+
+// ********************************************************************************************
+// 类型定义
+
+/// \brief 命令表中的一项 由Command或Menu生成
+///
+struct Entry
+{
+    const char* name;           ///< 命令名称
+    const char* desc;           ///< help中显示的说明
+    const char* help;           ///< 长帮助信息
+    uecli_ItemType type;        ///< UECLI_TYPE_BOUND或UECLI_TYPE_SUBMENU
+    const void* data;           ///< uecli_Bound或子菜单命令表
+};
+
+namespace detail
+{
+
+// ********************************************************************************************
+// 名称检查和哈希
+
+constexpr char ToLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// 不区分大小写比较 与estrcmpNocase的顺序相同
+constexpr int CompareNocase(const char* a, const char* b)
+{
+    for (; ToLower(*a) == ToLower(*b); ++a, ++b)
+    {
+        if ('\0' == *a)
+            return 0;
+    }
+    return ToLower(*a) < ToLower(*b) ? -1 : 1;
+}
+
+// 与uecli_HashName相同
+constexpr uint32_t HashName(const char* name, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (; '\0' != *name; ++name)
+        hash = (hash ^ static_cast<uint8_t>(ToLower(*name))) * 16777619u;
+    return hash;
+}
+
+// 名称可以在命令行中输入 不为空且不含空白、控制字符、引号和命令行分隔字符
+constexpr bool IsValidName(const char* name)
+{
+    if (!name || '\0' == *name)
+        return false;
+    for (; '\0' != *name; ++name)
+    {
+        char c = *name;
+        if (c <= ' ' || c > '~' || '|' == c || ';' == c || '&' == c || '>' == c
+            || '"' == c || '\'' == c || '\\' == c)
+            return false;
+    }
+    return true;
+}
+
+// 与uecli_cmd.h的系统命令表相同 系统命令先于用户命令查找
+constexpr bool IsReservedName(const char* name)
+{
+    const char* reserved[] =
+    {
+        "..", "help", "ver", "cls",
+#if UECLI_01_STATS>0
+        "stats",
+#endif
+#if UECLI_01_TRACE>0
+        "trace",
+#endif
+#if UECLI_01_JSON>0
+        "format",
+#endif
+#if UECLI_01_WATCH>0
+        "watch",
+#endif
+#if UECLI_01_SCHED>0
+        "every", "at", "sched",
+#endif
+#if UECLI_01_PAGER>0
+        "more",
+#endif
+    };
+    for (const char* r : reserved)
+    {
+        if (!CompareNocase(name, r))
+            return true;
+    }
+    return false;
+}
+
+// 索引槽数量 不小于命令数量的2倍的2的幂
+constexpr std::size_t SlotCount(std::size_t num)
+{
+    std::size_t count = 2;
+    while (count < num * 2)
+        count *= 2;
+    return count;
+}
+
+// ********************************************************************************************
+// 参数转换
+
+template <typename T>
+struct IsOptional : std::false_type {};
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct Unwrap { using Type = T; };
+template <typename T>
+struct Unwrap<std::optional<T>> { using Type = T; };
+
+template <typename T>
+struct Unsupported : std::false_type {};
+
+// 转换一个参数 失败返回false
+template <typename T>
+bool ParseArg(const char* str, T& value)
+{
+    if constexpr (std::is_same_v<T, const char*>)
+    {
+        value = str;
+        return true;
+    }
+    else if constexpr (std::is_same_v<T, bool>)
+    {
+        static const char* const names[] = {"0", "off", "false", "no", "1", "on", "true", "yes"};
+        for (int i = 0; i < 8; ++i)
+        {
+            if (!estrcmpNocase(str, names[i]))
+            {
+                value = i >= 4;
+                return true;
+            }
+        }
+        return false;
+    }
+    else if constexpr (std::is_same_v<T, char>)
+    {
+        value = str[0];
+        return '\0' != str[0] && '\0' == str[1];
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        static_assert(sizeof(T) <= sizeof(int32_t), "整数参数最大为32位");
+        int32_t num;
+        if (!estrtoi(str, &num))
+            return false;
+        // 无符号数不接受负号 32位无符号数可以使用0x十六进制输入全部范围
+        if constexpr (std::is_unsigned_v<T>)
+        {
+            for (; ' ' == *str; ++str);
+            if ('-' == *str)
+                return false;
+            if constexpr (sizeof(T) < sizeof(int32_t))
+            {
+                if (num < 0 || static_cast<uint32_t>(num) > std::numeric_limits<T>::max())
+                    return false;
+            }
+        }
+        else if constexpr (sizeof(T) < sizeof(int32_t))
+        {
+            if (num < std::numeric_limits<T>::min() || num > std::numeric_limits<T>::max())
+                return false;
+        }
+        value = static_cast<T>(num);
+        return true;
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        float num;
+        if (!estrtof(str, &num))
+            return false;
+        value = static_cast<T>(num);
+        return true;
+    }
+    else
+    {
+        static_assert(Unsupported<T>::value, "不支持的命令参数类型");
+        return false;
+    }
+}
+
+// 打印参数错误
+template <typename... A>
+int ArgError(const char* fmt, A... args)
+{
+    char buff[UECLI_CFG_TEMP_MAXLEN];
+    esnprintf(buff, sizeof(buff), fmt, args...);
+    uecli_PrintString(buff);
+    uecli_PrintString(UECLI_NEWLINE);
+    return UECLI_STATUS_SYNTAX;
+}
+
+template <typename Fn>
+struct Signature;
+
+// 原始命令函数 void(int, char**)或int(int, char**)
+template <typename R>
+struct Signature<R(*)(int, char**)>
+{
+    static constexpr bool raw = true;
+    using Result = R;
+    using Args = std::tuple<>;
+};
+
+template <typename R, typename... A>
+struct Signature<R(*)(A...)>
+{
+    static constexpr bool raw = false;
+    using Result = R;
+    using Args = std::tuple<std::decay_t<A>...>;
+};
+
+// 必需参数的数量 std::optional只能出现在最后
+template <typename... A>
+constexpr std::size_t RequiredArgs(std::tuple<A...>*)
+{
+    constexpr bool optional[] = {IsOptional<A>::value..., false};
+    std::size_t required = 0;
+    for (; required < sizeof...(A) && !optional[required]; ++required);
+    for (std::size_t i = required; i < sizeof...(A); ++i)
+    {
+        if (!optional[i])
+            return static_cast<std::size_t>(-1);
+    }
+    return required;
+}
+
+// 转换所有参数 返回第一个无效参数的序号，全部有效时返回0
+template <typename Tuple, std::size_t... I>
+int ParseArgs(Tuple& values, int argc, char** argv, std::index_sequence<I...>)
+{
+    int bad = 0;
+    auto parse = [&](auto& value, int index)
+    {
+        using T = std::decay_t<decltype(value)>;
+        if (bad || index >= argc)
+            return;
+        if constexpr (IsOptional<T>::value)
+        {
+            typename Unwrap<T>::Type inner{};
+            if (ParseArg(argv[index], inner))
+                value = inner;
+            else
+                bad = index;
+        }
+        else if (!ParseArg(argv[index], value))
+            bad = index;
+    };
+    (parse(std::get<I>(values), static_cast<int>(I) + 1), ...);
+    (void)parse;
+    return bad;
+}
+
+// 转换参数并调用命令函数
+template <auto Fn>
+int Invoke(int argc, char** argv)
+{
+    using Sig = Signature<decltype(Fn)>;
+    using Result = typename Sig::Result;
+
+    if constexpr (Sig::raw)
+    {
+        if constexpr (std::is_void_v<Result>)
+        {
+            Fn(argc, argv);
+            return UECLI_STATUS_OK;
+        }
+        else
+            return static_cast<int>(Fn(argc, argv));
+    }
+    else
+    {
+        using Args = typename Sig::Args;
+        constexpr std::size_t total = std::tuple_size_v<Args>;
+        constexpr std::size_t required = RequiredArgs(static_cast<Args*>(nullptr));
+        static_assert(required != static_cast<std::size_t>(-1), "std::optional参数只能位于最后");
+
+        if (argc - 1 < static_cast<int>(required) || argc - 1 > static_cast<int>(total))
+        {
+            if (required == total)
+                return ArgError("%s: 需要%d个参数", argv[0], static_cast<int>(total));
+            return ArgError("%s: 需要%d到%d个参数", argv[0], static_cast<int>(required), static_cast<int>(total));
+        }
+        Args values{};
+        if (int bad = ParseArgs(values, argc, argv, std::make_index_sequence<total>()))
+            return ArgError("%s: 第%d个参数无效: %s", argv[0], bad, argv[bad]);
+
+        if constexpr (std::is_void_v<Result>)
+        {
+            std::apply(Fn, values);
+            return UECLI_STATUS_OK;
+        }
+        else if constexpr (std::is_same_v<Result, bool>)
+            return std::apply(Fn, values) ? UECLI_STATUS_OK : UECLI_STATUS_ERROR;
+        else
+            return static_cast<int>(std::apply(Fn, values));
+    }
+}
+
+// 每个命令函数一个绑定对象
+template <auto Fn>
+inline constexpr uecli_Bound bound = {&Invoke<Fn>};
+
+}   // namespace detail
+
+// ********************************************************************************************
+// 命令表
+
+/// \brief 编译时生成的命令表
+///
+/// 第一项为索引项，之后为按名称排序的命令，最后为结尾项
+/// 索引项指向表内的索引，因此必须直接定义为命名空间作用域的constexpr变量，不能复制
+template <std::size_t N>
+struct Table
+{
+    static constexpr std::size_t slotcount = detail::SlotCount(N);
+
+    uecli_MenuItem items[N + 2] = {};       ///< 命令表 可传给uecli_Initialize
+    uint16_t slots[slotcount] = {};         ///< 索引槽
+    uecli_CmdIndex index = {};              ///< 索引
+    bool duplicate = false;                 ///< 名称重复(不区分大小写)
+    bool reserved = false;                  ///< 名称与系统命令相同
+    bool invalid = false;                   ///< 名称为空或含有不能输入的字符
+    bool perfect = false;                   ///< 索引没有冲突 每次查找只比较一次
+
+    template <typename... E, typename = std::enable_if_t<(std::is_same_v<E, Entry> && ...)>>
+    constexpr explicit Table(const E&... entries) : Table(std::array<Entry, N>{entries...})
+    {
+    }
+
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    /// \brief 可直接传给uecli_Initialize或作为子菜单
+    constexpr operator const uecli_MenuItem*() const
+    {
+        return items;
+    }
+
+private:
+    constexpr explicit Table(std::array<Entry, N> list)
+    {
+        static_assert(N > 0 && N < 0xFFFF, "命令数量为1到65534");
+
+        // 按名称排序 检查名称
+        for (std::size_t i = 1; i < N; ++i)
+        {
+            for (std::size_t j = i; j > 0 && detail::CompareNocase(list[j].name, list[j - 1].name) < 0; --j)
+            {
+                Entry temp = list[j];
+                list[j] = list[j - 1];
+                list[j - 1] = temp;
+            }
+        }
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            invalid = invalid || !detail::IsValidName(list[i].name);
+            if (invalid)
+                break;
+            reserved = reserved || detail::IsReservedName(list[i].name);
+            duplicate = duplicate || (i && !detail::CompareNocase(list[i].name, list[i - 1].name));
+        }
+
+        items[0].pdata = &index;
+        items[0].itemType = UECLI_TYPE_INDEX;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            uecli_MenuItem& item = items[i + 1];
+            item.pdata = list[i].data;
+            item.itemType = list[i].type;
+            item.exename = list[i].name;
+            item.desc = list[i].desc;
+#if UECLI_01_LONG_HELP>0
+            item.helpstr = list[i].help;
+#endif
+        }
+        if (invalid)
+            return;
+
+        // 寻找没有冲突的种子 找不到时使用种子0线性探测
+        index.mask = static_cast<uint32_t>(slotcount - 1);
+        index.slots = slots;
+        for (uint32_t seed = 0; seed < 256 && !perfect; ++seed)
+        {
+            perfect = Place(seed, false);
+            index.seed = seed;
+        }
+        if (!perfect)
+        {
+            index.seed = 0;
+            Place(0, true);
+        }
+    }
+
+    // 以指定种子放入索引 probe为false时遇到冲突返回false
+    constexpr bool Place(uint32_t seed, bool probe)
+    {
+        for (std::size_t i = 0; i < slotcount; ++i)
+            slots[i] = 0;
+        for (std::size_t i = 1; i <= N; ++i)
+        {
+            uint32_t pos = detail::HashName(items[i].exename, seed);
+            for (; slots[pos & index.mask]; ++pos)
+            {
+                if (!probe)
+                    return false;
+            }
+            slots[pos & index.mask] = static_cast<uint16_t>(i);
+        }
+        return true;
+    }
+};
+
+/// \brief 命令项
+///
+/// Fn为命令函数，参数由命令行参数转换，返回void、bool或执行状态
+/// 也可以是原始的void(int, char**)或int(int, char**)函数
+/// \param name 命令名称
+/// \param desc help中显示的说明
+/// \param help 长帮助信息
+template <auto Fn>
+constexpr Entry Command(const char* name, const char* desc, const char* help = nullptr)
+{
+    return Entry{name, desc, help, UECLI_TYPE_BOUND, &detail::bound<Fn>};
+}
+
+/// \brief 子菜单项
+///
+/// \param name 子菜单名称
+/// \param desc help中显示的说明
+/// \param list 子菜单命令表 Table或C语言定义的命令表
+constexpr Entry Menu(const char* name, const char* desc, const uecli_MenuItem* list)
+{
+    return Entry{name, desc, nullptr, UECLI_TYPE_SUBMENU, list};
+}
+
+template <typename... E>
+Table(const E&...) -> Table<sizeof...(E)>;
+
+// ********************************************************************************************
+// 编译时格式化
+
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+
+/// \brief 格式字符串 作为模板参数在编译时解析
+template <std::size_t N>
+struct FixedString
+{
+    char data[N] = {};
+
+    consteval FixedString(const char (&str)[N])
+    {
+        for (std::size_t i = 0; i < N; ++i)
+            data[i] = str[i];
+    }
+};
+
+namespace detail
+{
+
+// 格式标记 与esnprintf相同
+enum : uint8_t
+{
+    FMT_SIGN = 0x01,        // '+'标记 正数前放置正号
+    FMT_SIGNSP = 0x02,      // ' '标记 正数前放置空格
+    FMT_LEFT = 0x04,        // '-'标记 左对齐
+    FMT_LEADZERO = 0x08,    // '0'标记 放置前导零
+    FMT_ALTERNATE = 0x10,   // '#'标记 加0x、0b、0前缀
+};
+
+enum class FmtError
+{
+    None,
+    Incomplete,     // 格式在%之后结束
+    Star,           // 不支持参数指定宽度
+    Conversion,     // 不支持的转换字符
+};
+
+// 格式中的一段 先输出文本再输出一个转换
+struct FmtPiece
+{
+    std::size_t begin = 0;      // 文本在格式中的位置
+    std::size_t length = 0;     // 文本长度
+    char conv = 0;              // 转换字符 0表示只有文本
+    uint8_t flags = 0;
+    uint16_t width = 0;
+    std::size_t arg = 0;        // 使用的参数序号
+};
+
+template <std::size_t N>
+struct FmtParsed
+{
+    FmtPiece pieces[N] = {};
+    std::size_t count = 0;      // 段数量
+    std::size_t args = 0;       // 需要的参数数量
+    FmtError error = FmtError::None;
+};
+
+// 段数量上限
+template <std::size_t N>
+consteval std::size_t FmtPieceCount(const FixedString<N>& fmt)
+{
+    std::size_t count = 1;
+    for (std::size_t i = 0; i < N; ++i)
+        count += '%' == fmt.data[i];
+    return count;
+}
+
+// 解析格式
+template <std::size_t M, std::size_t N>
+consteval FmtParsed<M> FmtParse(const FixedString<N>& fmt)
+{
+    FmtParsed<M> result;
+    std::size_t i = 0;
+
+    for (;;)
+    {
+        FmtPiece& piece = result.pieces[result.count++];
+        piece.begin = i;
+        for (; fmt.data[i] && '%' != fmt.data[i]; ++i);
+        piece.length = i - piece.begin;
+        if (!fmt.data[i])
+            return result;
+
+        // %%作为文本的最后一个字符
+        if ('%' == fmt.data[++i])
+        {
+            ++piece.length;
+            ++i;
+            continue;
+        }
+        for (;; ++i)
+        {
+            char c = fmt.data[i];
+            if (' ' == c) piece.flags |= FMT_SIGNSP;
+            else if ('+' == c) piece.flags |= FMT_SIGN;
+            else if ('-' == c) piece.flags |= FMT_LEFT;
+            else if ('#' == c) piece.flags |= FMT_ALTERNATE;
+            else if ('0' == c) piece.flags |= FMT_LEADZERO;
+            else break;
+        }
+        if ('*' == fmt.data[i])
+        {
+            result.error = FmtError::Star;
+            return result;
+        }
+        for (; fmt.data[i] >= '0' && fmt.data[i] <= '9'; ++i)
+            piece.width = static_cast<uint16_t>(piece.width * 10 + (fmt.data[i] - '0'));
+        if (piece.flags & FMT_LEFT)
+            piece.flags &= ~FMT_LEADZERO;
+
+        piece.conv = fmt.data[i++];
+        switch (piece.conv)
+        {
+        case 's': case 'c': case 'd': case 'x': case 'X': case 'b': case 'B': case 'o':
+            piece.arg = result.args++;
+            break;
+        case '\0':
+            result.error = FmtError::Incomplete;
+            return result;
+        default:
+            result.error = FmtError::Conversion;
+            return result;
+        }
+    }
+}
+
+template <FixedString F>
+inline constexpr auto fmtparsed = FmtParse<FmtPieceCount(F)>(F);
+
+// 参数类型检查
+template <typename T>
+inline constexpr bool fmtchar = std::is_same_v<T, char> || std::is_same_v<T, signed char>
+    || std::is_same_v<T, unsigned char>;
+
+template <char Conv, typename T>
+inline constexpr bool fmtaccepts = ('s' == Conv) ?
+    (std::is_convertible_v<T, const char*> || std::is_same_v<T, std::string_view>) :
+    ('c' == Conv) ? fmtchar<T> : std::is_integral_v<T>;
+
+// 输出到缓冲区 超出的字符丢弃
+struct FmtBuffer
+{
+    char* ptr;
+    char* end;      // 保留结尾字符
+
+    void Write(const char* str, std::size_t num)
+    {
+        std::size_t left = static_cast<std::size_t>(end - ptr);
+        num = num < left ? num : left;
+        std::memcpy(ptr, str, num);
+        ptr += num;
+    }
+
+    void Fill(char c, std::size_t num)
+    {
+        std::size_t left = static_cast<std::size_t>(end - ptr);
+        num = num < left ? num : left;
+        std::memset(ptr, c, num);
+        ptr += num;
+    }
+};
+
+// 分块输出到控制台
+struct FmtPrinter
+{
+    char buff[UECLI_CFG_TEMP_MAXLEN];
+    std::size_t num = 0;
+
+    void Flush()
+    {
+        buff[num] = '\0';
+        uecli_PrintString(buff);
+        num = 0;
+    }
+
+    void Write(const char* str, std::size_t len)
+    {
+        while (len)
+        {
+            std::size_t part = sizeof(buff) - 1 - num;
+            part = len < part ? len : part;
+            std::memcpy(&buff[num], str, part);
+            num += part;
+            str += part;
+            len -= part;
+            if (num == sizeof(buff) - 1)
+                Flush();
+        }
+    }
+
+    void Fill(char c, std::size_t len)
+    {
+        for (; len; --len)
+            Write(&c, 1);
+    }
+};
+
+// 输出填充和内容 宽度和填充与C标准printf相同
+template <uint8_t Flags, uint16_t Width, typename W>
+void FmtField(W& w, const char* prefix, std::size_t prelen, const char* str, std::size_t len)
+{
+    std::size_t pad = Width > prelen + len ? Width - prelen - len : 0;
+    if constexpr (!(Flags & (FMT_LEFT | FMT_LEADZERO)))
+        w.Fill(' ', pad);
+    w.Write(prefix, prelen);
+    if constexpr (Flags & FMT_LEADZERO)
+        w.Fill('0', pad);
+    w.Write(str, len);
+    if constexpr (Flags & FMT_LEFT)
+        w.Fill(' ', pad);
+}
+
+// 整数转换 按参数类型的全部宽度输出，%d以外按无符号数输出
+template <char Conv, uint8_t Flags, uint16_t Width, typename W, typename T>
+void FmtInteger(W& w, T value)
+{
+    using U = std::make_unsigned_t<std::conditional_t<std::is_same_v<T, bool>, unsigned, T>>;
+    constexpr unsigned base = ('d' == Conv) ? 10 : ('b' == Conv || 'B' == Conv) ? 2 : ('o' == Conv) ? 8 : 16;
+    const char* digits = ('X' == Conv || 'B' == Conv) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char buff[sizeof(U) * 8];
+    char prefix[3] = {};
+    std::size_t prelen = 0;
+    char* p = &buff[sizeof(buff)];
+    U nv = static_cast<U>(value);
+
+    if constexpr ('d' == Conv)
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            if (value < 0)
+            {
+                nv = static_cast<U>(0 - nv);
+                prefix[prelen++] = '-';
+            }
+        }
+        if constexpr ((Flags & (FMT_SIGN | FMT_SIGNSP)) != 0)
+        {
+            if (!prelen)
+                prefix[prelen++] = (Flags & FMT_SIGN) ? '+' : ' ';
+        }
+    }
+    else if constexpr (Flags & FMT_ALTERNATE)
+    {
+        // 与C标准相同 0不加前缀
+        if (nv)
+        {
+            prefix[prelen++] = '0';
+            if constexpr ('o' != Conv)
+                prefix[prelen++] = Conv;
+        }
+    }
+
+    do
+    {
+        *--p = digits[nv % base];
+        nv /= base;
+    } while (nv);
+    FmtField<Flags, Width>(w, prefix, prelen, p, static_cast<std::size_t>(&buff[sizeof(buff)] - p));
+}
+
+// 输出一段
+template <FixedString F, std::size_t I, typename W, typename Tuple>
+void FmtEmit(W& w, const Tuple& args)
+{
+    constexpr FmtPiece piece = fmtparsed<F>.pieces[I];
+    if constexpr (piece.length > 0)
+        w.Write(&F.data[piece.begin], piece.length);
+
+    if constexpr (0 != piece.conv)
+    {
+        const auto& value = std::get<piece.arg>(args);
+        using T = std::decay_t<decltype(value)>;
+        static_assert(fmtaccepts<piece.conv, T>, "uecli::format: 参数类型与格式不符");
+
+        if constexpr ('s' == piece.conv)
+        {
+            std::string_view str(value);
+            FmtField<piece.flags, piece.width>(w, "", 0, str.data(), str.size());
+        }
+        else if constexpr ('c' == piece.conv)
+        {
+            char c = static_cast<char>(value);
+            FmtField<piece.flags, piece.width>(w, "", 0, &c, 1);
+        }
+        else
+            FmtInteger<piece.conv, piece.flags, piece.width>(w, value);
+    }
+}
+
+template <FixedString F, typename W, typename Tuple, std::size_t... I>
+void FmtRun(W& w, const Tuple& args, std::index_sequence<I...>)
+{
+    (FmtEmit<F, I>(w, args), ...);
+}
+
+template <FixedString F, std::size_t Args>
+consteval bool FmtCheck()
+{
+    constexpr auto& parsed = fmtparsed<F>;
+    static_assert(parsed.error != FmtError::Incomplete, "uecli::format: 格式在%之后结束");
+    static_assert(parsed.error != FmtError::Star, "uecli::format: 不支持*宽度，宽度须写在格式中");
+    static_assert(parsed.error != FmtError::Conversion, "uecli::format: 不支持的转换字符");
+    static_assert(parsed.error != FmtError::None || parsed.args == Args, "uecli::format: 参数数量与格式不符");
+    return parsed.error == FmtError::None && parsed.args == Args;
+}
+
+}   // namespace detail
+
+/// \brief 格式化到缓冲区
+///
+/// 格式与esnprintf相同，支持%s %c %d %x %X %b %B %o、标记" +-#0"和宽度，输出与C标准的snprintf相同，
+/// 格式在编译时解析并检查参数类型和数量，运行时不解析格式。
+/// 整数按参数类型的全部宽度输出，%s可使用const char*或std::string_view
+/// \code
+/// char buff[32];
+/// uecli::format<"%s=%08x">(buff, sizeof(buff), name, value);
+/// \endcode
+/// \param buff 缓冲区 超出的字符丢弃，结尾总是'\0'
+/// \param size 缓冲区大小
+/// \return 写入的字符数量 不含结尾的'\0'
+template <FixedString F, typename... A>
+uint32_t format(char* buff, uint32_t size, const A&... args)
+{
+    if constexpr (detail::FmtCheck<F, sizeof...(A)>())
+    {
+        if (!size)
+            return 0;
+        detail::FmtBuffer w{buff, buff + size - 1};
+        detail::FmtRun<F>(w, std::tie(args...), std::make_index_sequence<detail::fmtparsed<F>.count>());
+        *w.ptr = '\0';
+        return static_cast<uint32_t>(w.ptr - buff);
+    }
+    return 0;
+}
+
+/// \brief 格式化输出到控制台
+///
+/// 格式与format相同，输出长度不受临时缓冲区大小的限制
+template <FixedString F, typename... A>
+void print(const A&... args)
+{
+    if constexpr (detail::FmtCheck<F, sizeof...(A)>())
+    {
+        detail::FmtPrinter w;
+        detail::FmtRun<F>(w, std::tie(args...), std::make_index_sequence<detail::fmtparsed<F>.count>());
+        if (w.num)
+            w.Flush();
+    }
+}
+
+#endif
+
+}   // namespace uecli
+
+/// \brief 定义命令表并检查名称
+///
+/// 在命名空间作用域使用，定义名为NAME的uecli::Table常量
+#define UECLI_TABLE(NAME, ...) \
+    inline constexpr ::uecli::Table NAME{__VA_ARGS__}; \
+    static_assert(!NAME.invalid, "uecli: 命令名称为空或含有空白、引号和命令行分隔字符"); \
+    static_assert(!NAME.duplicate, "uecli: 命令名称重复(不区分大小写)"); \
+    static_assert(!NAME.reserved, "uecli: 命令名称与系统命令相同")
+
+#endif
@@ -1,67 +1,138 @@
 /// \file uecli_cfg.h
-/// \brief uecliͷļ
+/// \brief uecli配置头文件
 ///
 /// \details
-/// uecli Ƕʽнӿ֧ģ
-/// ֧ȫʷ¼Ӳ˵Ϣ
+/// uecli 是嵌入式精简的命令行接口支持模块
+/// 其支持命令补全、历史记录、子菜单、长帮助信息等特性
 ///
-/// \author ʫ
+/// \author 张诗星
 /// \par
-/// (C) Copyright ݴʿƼ޹˾
+/// (C) Copyright 杭州大仁科技有限公司
 ///
 /// \version
-/// 2017/07/24 ʫ ʼ汾\n
+/// 2017/07/24 张诗星 初始版本\n
 
 #ifndef _U_E_CLI_CFG_H_
 #define _U_E_CLI_CFG_H_
 
 // ********************************************************************************************
-// 
+// 配置
 
-/// \defgroup  UECLI_CFGö
+/// \defgroup  UECLI_CFG相关配置定义
 /// \{
-#define UECLI_CFG_STR_MAXLEN     (32)    ///< ַ󳤶
-#define UECLI_CFG_TEMP_MAXLEN    (64)    ///< ڲʱַ󳤶
-#define UECLI_CFG_MAX_ARGNUM     (6)     ///< ָ
-#define UECLI_CFG_MAX_POMPTLINE  (32)    ///< ʾַ󳤶
-#define UECLI_CFG_HISTORY_COUNT  (8)     ///< ʷ
-#define UECLI_CFG_STACK_COUNT    (8)     ///< Ӳ˵ջ
-#define UECLI_CFG_AUTOCOMP_NUM   (16)    ///< Զȫʾ
+#define UECLI_CFG_STR_MAXLEN     (32)    ///< 输入命令行字符串最大长度
+#define UECLI_CFG_TEMP_MAXLEN    (64)    ///< 内部处理临时字符串最大长度
+#define UECLI_CFG_MAX_ARGNUM     (6)     ///< 输入命令行中最大分割参数数量
+#define UECLI_CFG_MAX_POMPTLINE  (32)    ///< 提示符字符串最大长度
+#define UECLI_CFG_HISTORY_COUNT  (8)     ///< 输入命令行历史最大数量
+#define UECLI_CFG_STACK_COUNT    (8)     ///< 子菜单堆栈最大数量
+#define UECLI_CFG_AUTOCOMP_NUM   (16)    ///< 自动补全最大显示数量
+#define UECLI_CFG_PIPE_STAGES    (4)     ///< 管道过滤器最大级数
+#define UECLI_CFG_PIPE_LINELEN   (128)   ///< 管道过滤器行缓存长度
+#define UECLI_CFG_FILE_CHUNKSIZE (65536) ///< 重定向文件缓存块大小
+#define UECLI_CFG_FILE_CHUNKS    (8)     ///< 重定向文件缓存块数量
+#define UECLI_CFG_STATS_NUM      (32)    ///< 命令统计最大命令数量
+#define UECLI_CFG_STATS_SUBBITS  (3)     ///< 延迟直方图每个2的幂区间细分为2^N个桶
+#define UECLI_CFG_STATS_MAXBITS  (36)    ///< 延迟直方图最大记录2^N纳秒
+#define UECLI_CFG_TRACE_EVENTS   (4096)  ///< 每个线程的跟踪事件缓存数量 必须为2的幂
+#define UECLI_CFG_TRACE_THREADS  (8)     ///< 最大跟踪线程数量
+#define UECLI_CFG_CACHELINE      (64)    ///< CPU缓存行大小
+#define UECLI_CFG_STEP_OUTSIZE   (4096)  ///< 非阻塞接口发送队列大小 必须为2的幂
+#define UECLI_CFG_INPUT_RINGSIZE (1024)  ///< 中断输入队列大小 必须为2的幂
+#define UECLI_CFG_LOG_SLOTS      (64)    ///< 异步日志队列条数 必须为2的幂
+#define UECLI_CFG_LOG_LINELEN    (96)    ///< 每条异步日志最大长度
+#define UECLI_CFG_LOG_RATE       (50)    ///< 每秒最多显示的日志条数 超出的日志被抑制
+#define UECLI_CFG_TX_RINGSIZE    (4096)  ///< 发送队列大小 必须为2的幂
+#define UECLI_CFG_TX_HIGHWATER   (3072)  ///< 发送队列高水位 超过后暂停输出直到低于低水位
+#define UECLI_CFG_TX_LOWWATER    (1024)  ///< 发送队列低水位
+#define UECLI_CFG_JSON_BUFFSIZE  (128)   ///< 结构化输出合并缓存大小
+#define UECLI_CFG_SEQUENCE_NUM   (8)     ///< 一行中以;、&&、||连接的最大命令数量
+#define UECLI_CFG_LINE_CHUNK     (256)   ///< 长命令行输入缓存每次增长的大小
+#define UECLI_CFG_LINE_MAXSIZE   (8192)  ///< 长命令行输入缓存上限 超出的字符被丢弃
+#define UECLI_CFG_WATCH_ROWS     (24)    ///< watch画面最大行数 超出的行不显示
+#define UECLI_CFG_WATCH_COLS     (80)    ///< watch画面最大列数 超出的字符不显示
+#define UECLI_CFG_SCHED_NUM      (16)    ///< 每个会话最大定时命令数量 不能大于65535
+#define UECLI_CFG_SCHED_TICK     (10)    ///< 定时命令时间轮节拍毫秒数
+#define UECLI_CFG_PAGER_ROWS     (24)    ///< 分页输出每页行数 含状态行
+#define UECLI_CFG_PAGER_LINELEN  (128)   ///< 分页查找的行缓存长度 超出的部分不参与查找
+#define UECLI_CFG_HELP_CACHEMAX  (4096)  ///< 每级菜单帮助缓存最大字节数 超出时不缓存
 /// \}
 
-/// \defgroup  UECLI_01ֿ֧
+/// \defgroup  UECLI_01功能支持开关
 /// \{
-#define UECLI_01_COLOR          (0)     ///< ֧ɫչ
-#define UECLI_01_IN_HOOK        (1)     ///< 빳֧
-#define UECLI_01_LONG_HELP      (1)     ///< Ϣ֧
-#define UECLI_01_SUBMENU        (1)     ///< Ӳ˵֧
-#define UECLI_01_HISTORY        (1)     ///< ʷ֧
-#define UECLI_01_COMPLETE       (1)     ///< Զȫ֧
+#define UECLI_01_COLOR          (0)     ///< 支持颜色扩展
+#define UECLI_01_IN_HOOK        (1)     ///< 输入钩子和输入捕获支持
+#define UECLI_01_LONG_HELP      (1)     ///< 长帮助信息支持
+#define UECLI_01_SUBMENU        (1)     ///< 子菜单支持
+#define UECLI_01_HISTORY        (1)     ///< 命令历史支持
+#define UECLI_01_COMPLETE       (1)     ///< 自动补全支持
+#define UECLI_01_PIPE           (0)     ///< 输出管道过滤支持
+#define UECLI_01_SEQUENCE       (0)     ///< 命令序列支持 ;、&&、||连接多条命令，$?为上一条命令的执行状态
+#define UECLI_01_REDIRECT       (0)     ///< 输出重定向到文件支持 需要uecli_file.c
+#define UECLI_01_STATS          (0)     ///< 命令执行统计支持
+#define UECLI_01_TRACE          (0)     ///< 运行过程跟踪支持 需要uecli_trace.c
+#define UECLI_01_SESSION        (0)     ///< 多会话支持 每个连接一个会话对象
+#define UECLI_01_STEP           (0)     ///< 非阻塞单步接口 需要端口实现uecli_port_read/write/pollfd
+#define UECLI_01_INPUT_RING     (0)     ///< 中断或接收线程输入队列支持
+#define UECLI_01_ASYNC_LOG      (0)     ///< 多线程异步日志支持 输出时保留正在输入的命令行
+#define UECLI_01_TX_RING        (0)     ///< 发送队列支持 端口异步发送 需要端口实现uecli_port_tx_kick/wait
+#define UECLI_01_JSON           (0)     ///< JSON/CBOR结构化输出模式支持 需要uecli_json.c
+#define UECLI_01_LONG_LINE      (0)     ///< 长命令行支持 输入缓存和参数表超过内置大小后动态增长，历史记录和watch、定时命令仍受UECLI_CFG_STR_MAXLEN限制
+#define UECLI_01_WATCH          (0)     ///< watch命令支持 定时重复执行命令，只发送变化的内容 需要UECLI_01_IN_HOOK
+#define UECLI_01_SCHED          (0)     ///< 定时命令支持 every、at命令在会话中周期或延迟执行命令
+#define UECLI_01_PAGER          (0)     ///< 分页输出支持 输出超过一屏时暂停，按键翻页、查找或退出 需要UECLI_01_IN_HOOK
+#define UECLI_01_HELP_CACHE     (0)     ///< 帮助缓存支持 每级菜单渲染好的命令列表缓存在会话中，一次输出
+#define UECLI_01_SECTION        (0)     ///< 链接段命令注册支持 UECLI_COMMAND定义的命令自动加入根命令表 需要GCC/Clang和ELF链接器
 /// \}
 
-///< з
+///< 换行符
 #define UECLI_NEWLINE   "\r\n"
 
-///< log֧
+///< 单调时钟 返回纳秒计数，用于统计命令耗时
+#define uecli_gettime_ns()  uecli_port_time_ns()
+
+///< 原子操作和线程局部变量 只用于32位整数
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define uecli_atomic_load(p)            (_ReadWriteBarrier(), *(volatile uint32_t*)(p))
+#define uecli_atomic_store(p, v)        do { _ReadWriteBarrier(); *(volatile uint32_t*)(p) = (v); } while (0)
+#define uecli_atomic_fetch_add(p, v)    ((uint32_t)_InterlockedExchangeAdd((volatile long*)(p), (long)(v)))
+#define uecli_atomic_cas(p, e, v)       (_InterlockedCompareExchange((volatile long*)(p), (long)(v), (long)(e)) == (long)(e))
+#define UECLI_THREAD_LOCAL              __declspec(thread)
+#else
+#define uecli_atomic_load(p)            __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define uecli_atomic_store(p, v)        __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define uecli_atomic_fetch_add(p, v)    __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL)
+#define uecli_atomic_cas(p, e, v)       __sync_bool_compare_and_swap(p, e, v)
+#define UECLI_THREAD_LOCAL              __thread
+#endif
+
+///< log支持
 #define UECLI_LOG(FORMAT, ...) /*eprintf(FORMAT UECLI_NEWLINE, ##__VA_ARGS__)*/
 
-//ַ
+//字符串操作函数定义
 #include "estring.h"
 #define uecli_snprintf(sd,num,ss,...) esnprintf(sd,num,ss,##__VA_ARGS__)
+#define uecli_vsnprintf(sd,num,ss,ap) evsnprintf(sd,num,ss,ap)
 #define uecli_isprintfchar(ch) ((ch)>=0x20&&(ch)<=0x7f)
 
-///< ַ
+///< 复制字符串
 #define uecli_strncpy(sd,ss,num) estrncpy(sd,ss,num)
 
-///< ַȽ
+///< 命令字符比较
 #define uecli_strcasecmp(sd,ss) estrcmpNocase(sd,ss)
 
-///< ׷ַ
+///< 追加字符
 #define uecli_strncat(sd, ss, len)  estrncat(sd,ss,len)
 
-///< ȡַ
+///< 获取字符串长度
 #define uecli_strlen(str)   estrlen(str)
 
+///< 长命令行内存分配 可替换为带上限的内存池
+#include <stdlib.h>
+#define uecli_realloc(p, size)  realloc(p, size)
+#define uecli_free(p)           free(p)
+
 #include <assert.h>
 #define uecli_assert(x) assert(x)
 
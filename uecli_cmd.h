@@ -1,86 +1,431 @@
 /// \file uecli_cmd.h
-/// \brief ϵͳ֧
+/// \brief 系统命令支持
 ///
 /// \details
-/// uecli Ƕʽнӿ֧ģ
-/// ֧ȫʷ¼Ӳ˵Ϣ
+/// uecli 是嵌入式精简的命令行接口支持模块
+/// 其支持命令补全、历史记录、子菜单、长帮助信息等特性
 ///
-/// \author ʫ
+/// \author 张诗星
 /// \par
-/// (C) Copyright ݴʿƼ޹˾
+/// (C) Copyright 杭州大仁科技有限公司
 ///
 /// \version
-/// 2017/07/24 ʫ ʼ汾\n
+/// 2017/07/24 张诗星 初始版本\n
  
 #include "uecli.h"
 
 // ********************************************************************************************
-// ַ
+// 字符串表
 
-// ʾ
+// 命令提示符
 const char* STRING_PROMPT = ">>";
 
-// ȨϢ
+// 版权描述信息
 const char* STRING_COPYRIGHT_INFO =
 "\r\n**********************************************************"
-"\r\n*                 UECLI Ƕʽ̨                 *"
+"\r\n*                 UECLI 嵌入式控制台界面                 *"
 "\r\n**********************************************************" UECLI_NEWLINE;
 
-// ʾ
-const char* STRING_INVALID_COMMAND = "\"%s\" Ч";
+// 错误命令提示
+const char* STRING_INVALID_COMMAND = "\"%s\" 不是有效的命令！";
 
-// 汾
+// 命令行过长提示
+const char* STRING_LINE_TOO_LONG = "命令行过长，没有执行！";
+
+// 版本描述
 const char* STRING_VERSIONS =
 "Versions: V0.2 Copyright2016" UECLI_NEWLINE
 "email: zhangjinxing_2006@163.com" UECLI_NEWLINE
 __DATE__ " -- " __TIME__ UECLI_NEWLINE;
 
-//ַ
+//清屏命令字符串
 const char* STRING_CLEAR_SCREEN = "\033[2J\033[0;0H";
 
-//бַ
+//命令列表字符串
 const char* STRING_CMD_LIST = "%-16s";
-//Ӳ˵ӡַ
+//子菜单打印字符串
 const char* STRING_SUBMENU_LIST = "/%-15s";
 
+#if UECLI_01_SEQUENCE>0
+// 命令序列格式错误提示
+const char* STRING_INVALID_SEQUENCE = "命令序列格式错误或命令过多！";
+#endif
+
+#if UECLI_01_PIPE>0
+// 错误过滤器提示
+const char* STRING_INVALID_FILTER = "\"%s\" 不是有效的过滤器！";
+
+// 管道过滤器名称表 顺序与PipeFilterType一致
+static const char* const uecli_filterList[PIPE_FILTER_NUM] = { "grep", "head", "count" };
+#endif
+
+#if UECLI_01_STATS>0
+// 命令统计表头
+const char* STRING_STATS_HEAD =
+"command            calls    p50(us)    p99(us)    max(us)      bytes" UECLI_NEWLINE;
+// 命令统计数据行
+const char* STRING_STATS_ROW = "%8d%7d.%03d%7d.%03d%7d.%03d%11s" UECLI_NEWLINE;
+// 命令统计机器可读格式 每行一个JSON对象
+const char* STRING_STATS_JSON1 = "{\"cmd\":\"%s\",\"calls\":%d,\"bytes\":%s,";
+const char* STRING_STATS_JSON2 = "\"p50_us\":%d.%03d,\"p99_us\":%d.%03d,\"max_us\":%d.%03d}" UECLI_NEWLINE;
+#endif
+
+#if UECLI_01_TRACE>0
+// 跟踪状态
+const char* STRING_TRACE_STATUS = "trace: %s, %d events" UECLI_NEWLINE;
+#endif
+
+#if UECLI_01_JSON>0
+// 输出格式
+const char* STRING_FORMAT_STATUS = "format: %s" UECLI_NEWLINE;
+#endif
+
+#if UECLI_01_ASYNC_LOG>0
+// 日志抑制提示
+const char* STRING_LOG_SUPPRESSED = "[已抑制 %d 条日志]" UECLI_NEWLINE;
+#endif
+
+#if UECLI_01_WATCH>0
+// watch命令用法
+const char* STRING_WATCH_USAGE = "用法: watch [-n 毫秒] 命令";
+// watch画面第一行
+const char* STRING_WATCH_HEAD = "每%dms执行: %s    按任意键退出";
+#endif
+
+#if UECLI_01_SCHED>0
+// 定时命令用法
+const char* STRING_EVERY_USAGE = "用法: every 间隔 命令";
+const char* STRING_AT_USAGE = "用法: at +延迟 命令";
+const char* STRING_SCHED_USAGE = "用法: sched [cancel 编号|all]";
+// 定时命令表头
+const char* STRING_SCHED_HEAD = "id    left(ms)    period(ms)  command" UECLI_NEWLINE;
+// 定时命令数据行 后接命令行
+const char* STRING_SCHED_ROW = "%-6d%-12d%-12d";
+// 定时命令已添加
+const char* STRING_SCHED_ADDED = "定时命令 %d 已添加" UECLI_NEWLINE;
+// 没有空闲的定时命令
+const char* STRING_SCHED_FULL = "定时命令已满！" UECLI_NEWLINE;
+// 定时命令编号无效
+const char* STRING_SCHED_INVALID = "\"%s\" 不是有效的定时命令编号！" UECLI_NEWLINE;
+#endif
+
+#if UECLI_01_PAGER>0
+// 分页状态行
+const char* STRING_PAGER_MORE = "--更多-- 空格:下一页 回车:下一行 /:查找 q:退出";
+// 查找失败提示
+const char* STRING_PAGER_NOTFOUND = "未找到 \"%s\"" UECLI_NEWLINE;
+// more命令用法
+const char* STRING_MORE_USAGE = "用法: more [行数(2-255)|on|off]";
+// 分页设置
+const char* STRING_PAGER_STATUS = "more: %d" UECLI_NEWLINE;
+#endif
+
+#if UECLI_01_REDIRECT>0
+// 重定向格式错误提示
+const char* STRING_INVALID_REDIRECT = "缺少重定向文件名或参数过多！";
+// 重定向文件打开失败提示
+const char* STRING_REDIRECT_FAILED = "无法打开文件 \"%s\"！";
+// 重定向完成提示
+const char* STRING_REDIRECT_RESULT = "已写入 %d 字节，耗时 %d.%03d ms";
+// 重定向写入错误提示
+const char* STRING_REDIRECT_ERROR = "写入文件出错！";
+#endif
+
 // ********************************************************************************************
-// ϵͳ֧
+// 系统命令支持
 
 static inline const uecli_MenuItem* GetSyscmdHandle(void);
 static const uecli_MenuItem* GetUserCmdHandle(void);
 static const uecli_MenuItem* PopMenuStack(void);
 static const uecli_MenuItem* SearchMatchCommand(const char* cmdline);
+static inline const uecli_MenuItem* SkipMenuIndex(const uecli_MenuItem* list);
+#if UECLI_01_SECTION>0
+static const uecli_MenuItem* GetSectionCmd(uint32_t i);
+#endif
+#if UECLI_01_WATCH>0
+static bool WatchStart(const char* cmdline, uint32_t ms);
+#endif
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0
+static bool GetArgsLine(int argc, char* argv[], int index, char* line);
+#endif
+#if UECLI_01_SCHED>0
+static uint16_t SchedAdd(const char* cmdline, uint32_t delayms, uint32_t periodms);
+static bool SchedCancel(uint32_t id);
+static void SchedList(void);
+#endif
+
+#if UECLI_01_STATS>0
+static CmdStats* FindCmdStats(const uecli_MenuItem* item, bool add);
+static uint64_t GetStatsPercentile(const CmdStats* pstat, uint32_t permille);
+#endif
+
+static inline void OutputData(const char* buff, int len);
+#if UECLI_01_PAGER>0
+static inline uint8_t PageRows(void);
+static bool CanPage(void);
+#endif
+
+#if UECLI_01_HELP_CACHE>0
+// 命令表版本 命令表内容改变时递增，缓存的帮助随之失效
+static uint32_t uecli_helpgen;
 
-// ӡб
-static void PrintHandleList(const uecli_MenuItem* ptr)
+// 向正在渲染的帮助缓存追加文本 超过上限或内存不足时放弃缓存
+static void HelpCacheAppend(HelpCache* pc, const char* str)
+{
+    uint32_t num = uecli_strlen(str);
+
+    if (pc->overflow)
+        return;
+    if (pc->len + num > pc->size)
+    {
+        uint32_t size = pc->size ? pc->size : 256;
+        while (size < pc->len + num)
+            size *= 2;
+        char* text = size <= UECLI_CFG_HELP_CACHEMAX ? (char*)uecli_realloc(pc->text, size) : NULL;
+        if (NULL == text)
+        {
+            pc->overflow = true;
+            return;
+        }
+        pc->text = text;
+        pc->size = size;
+    }
+    memcpy(&pc->text[pc->len], str, num);
+    pc->len += num;
+    for (; *str; ++str)
+        pc->lines += '\n' == *str;
+}
+
+#if UECLI_01_SESSION>0
+// 释放帮助缓存
+static void FreeHelpCache(void)
+{
+    for (int i = 0; i < (int)(sizeof(uecli.helpcache) / sizeof(uecli.helpcache[0])); ++i)
+    {
+        uecli_free(uecli.helpcache[i].text);
+        memset(&uecli.helpcache[i], 0, sizeof(uecli.helpcache[i]));
+    }
+}
+#endif
+#endif
+
+// 输出帮助内容 渲染帮助缓存时写入缓存
+static void HelpEmit(const char* str)
+{
+#if UECLI_01_HELP_CACHE>0
+    if (uecli.helprender)
+    {
+        HelpCacheAppend(uecli.helprender, str);
+        return;
+    }
+#endif
+    uecli_PrintString(str);
+}
+
+// 打印一个命令项
+static void PrintHandleItem(const uecli_MenuItem* ptr)
 {
     const char* strformat;
     
-    if (ptr)
+#if UECLI_01_JSON>0
+    uecli_Json* js = uecli_JsonOutput();
+    if (js)
+    {
+        uecli_JsonObjectBegin(js, NULL);
+        uecli_JsonString(js, "name", ptr->exename);
+        uecli_JsonString(js, "type", UECLI_TYPE_SUBMENU == ptr->itemType ? "menu" : "cmd");
+        uecli_JsonString(js, "desc", ptr->desc);
+        uecli_JsonObjectEnd(js);
+        return;
+    }
+#endif
+
+    if (uecli.helpwidth)
+    {
+        // help -l 名称按最长的名称对齐
+        char* pstr = uecli.tmpString;
+        int len = 0;
+
+        if (UECLI_TYPE_SUBMENU == ptr->itemType)
+            pstr[len++] = '/';
+        uecli_strncpy(&pstr[len], ptr->exename, UECLI_CFG_TEMP_MAXLEN - len);
+        len = uecli_strlen(pstr);
+        while (len < uecli.helpwidth && len < UECLI_CFG_TEMP_MAXLEN - 1)
+            pstr[len++] = ' ';
+        pstr[len] = '\0';
+    }
+    else
     {
-        for (; ptr->pdata; ++ptr)
+        strformat = (ptr->itemType==UECLI_TYPE_SUBMENU) ? 
+            STRING_SUBMENU_LIST : STRING_CMD_LIST;
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, strformat,ptr->exename);
+    }
+    HelpEmit(uecli.tmpString);
+
+    // 打印帮助信息
+    HelpEmit(ptr->desc);
+    HelpEmit(UECLI_NEWLINE);
+}
+
+// help -l的名称列宽 为最长的名称加2
+static uint8_t GetHelpWidth(void)
+{
+    const uecli_MenuItem* lists[2] = {GetSyscmdHandle(), GetUserCmdHandle()};
+    const uecli_MenuItem* ptr;
+    int width = 0;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        for (ptr = SkipMenuIndex(lists[i]); ptr && ptr->pdata; ++ptr)
         {
-            strformat = (ptr->itemType==UECLI_TYPE_SUBMENU) ? 
-                STRING_SUBMENU_LIST : STRING_CMD_LIST;
-            uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, strformat,ptr->exename);
-            uecli_PrintString(uecli.tmpString);
+            int len = uecli_strlen(ptr->exename) + (UECLI_TYPE_SUBMENU == ptr->itemType);
+            width = len > width ? len : width;
+        }
+    }
+#if UECLI_01_SECTION>0
+    for (uint32_t i = 0; NULL != (ptr = GetSectionCmd(i)); ++i)
+    {
+        int len = uecli_strlen(ptr->exename) + (UECLI_TYPE_SUBMENU == ptr->itemType);
+        width = len > width ? len : width;
+    }
+#endif
+    width += 2;
+    return (uint8_t)(width < UECLI_CFG_TEMP_MAXLEN - 1 ? width : UECLI_CFG_TEMP_MAXLEN - 1);
+}
 
-            // ӡϢ
-            uecli_PrintString(ptr->desc);
-            uecli_PrintString(UECLI_NEWLINE);
+// 逐项生成命令列表 第0项为版本信息，之后依次为系统命令、用户命令和链接段命令
+// ctx为正在输出的命令表 0:系统命令 1:用户命令 2:链接段命令，cursor为下一项的指针或链接段命令序号
+static bool HelpListNext(uecli_Pager* pager)
+{
+    uintptr_t table = (uintptr_t)pager->ctx;
+
+    // help -l只列出命令
+    if (0 == pager->index)
+    {
+    #if UECLI_01_JSON>0
+        if (!uecli_JsonOutput())
+    #endif
+        if (!uecli.helpwidth)
+            HelpEmit(STRING_COPYRIGHT_INFO);
+        return true;
+    }
+
+    for (; table < 2; pager->ctx = (void*)++table)
+    {
+        const uecli_MenuItem* ptr = (const uecli_MenuItem*)pager->cursor;
+        if (ptr && ptr->pdata)
+        {
+            PrintHandleItem(ptr);
+            pager->cursor = (uintptr_t)(ptr + 1);
+            return true;
         }
+        pager->cursor = 0 == table ? (uintptr_t)SkipMenuIndex(GetUserCmdHandle()) : 0;
     }
+
+#if UECLI_01_SECTION>0
+    const uecli_MenuItem* pitem = GetSectionCmd((uint32_t)pager->cursor);
+    if (pitem)
+    {
+        PrintHandleItem(pitem);
+        ++pager->cursor;
+        return true;
+    }
+#endif
+    return false;
 }
 
-// help
-static void Cmd_HelpMain(int argc, char* argv[])
+#if UECLI_01_HELP_CACHE>0
+#if UECLI_01_PAGER>0
+// 逐行输出缓存的帮助 ctx为缓存，cursor为下一行的位置
+static bool HelpTextNext(uecli_Pager* pager)
+{
+    const HelpCache* pc = (const HelpCache*)pager->ctx;
+    uint32_t start = (uint32_t)pager->cursor;
+    uint32_t end = start;
+
+    if (start >= pc->len)
+        return false;
+    while (end < pc->len && '\n' != pc->text[end++]);
+    OutputData(&pc->text[start], (int)(end - start));
+    pager->cursor = end;
+    return true;
+}
+#endif
+
+// 获取当前菜单的帮助缓存 没有缓存或已失效时重新渲染，不能缓存时返回NULL
+static const HelpCache* GetHelpCache(void)
 {
-    // Ϣ
+    const uecli_MenuItem* list = GetUserCmdHandle();
+    int level = 0;
+
+#if UECLI_01_SUBMENU>0
+    level = uecli.stackpos;
+#endif
+    HelpCache* pc = &uecli.helpcache[level];
+    if (pc->valid && pc->list == list && pc->width == uecli.helpwidth && pc->gen == uecli_helpgen)
+        return pc;
+
+    uecli_Pager pager = {HelpListNext, NULL, NULL, (uintptr_t)GetSyscmdHandle(), 0};
+    pc->valid = pc->overflow = false;
+    pc->len = pc->lines = 0;
+    uecli.helprender = pc;
+    while (HelpListNext(&pager))
+        ++pager.index;
+    uecli.helprender = NULL;
+    if (pc->overflow)
+        return NULL;
+
+    pc->list = list;
+    pc->width = uecli.helpwidth;
+    pc->gen = uecli_helpgen;
+    pc->valid = true;
+    return pc;
+}
+
+// 输出缓存的帮助 超过一页时分页，否则一次写入
+static int OutputHelpCache(const HelpCache* pc)
+{
+#if UECLI_01_PAGER>0
+    if (pc->lines >= PageRows() && CanPage())
+    {
+        uecli_Pager pager = {HelpTextNext, NULL, (void*)pc, 0, 0};
+        return uecli_PageOutput(&pager);
+    }
+#endif
+    OutputData(pc->text, (int)pc->len);
+    return UECLI_STATUS_OK;
+}
+#endif
+
+// help命令
+static int Cmd_HelpMain(int argc, char* argv[])
+{
+    uecli.helpwidth = 0;
+    if (argc >= 2 && !uecli_strcasecmp(argv[1], "-l"))
+    {
+        uecli.helpwidth = GetHelpWidth();
+        argc = 1;
+    }
+
+    // 长帮助信息
 #if UECLI_01_LONG_HELP>0
     if (argc >= 2)
     {
         const uecli_MenuItem* pitem = SearchMatchCommand(argv[1]);
-        if (pitem && UECLI_TYPE_FUN == pitem->itemType)
+    #if UECLI_01_JSON>0
+        uecli_Json* js = uecli_JsonOutput();
+        if (js && pitem && UECLI_TYPE_SUBMENU != pitem->itemType)
+        {
+            uecli_JsonObjectBegin(js, NULL);
+            uecli_JsonString(js, "name", pitem->exename);
+            uecli_JsonString(js, "desc", pitem->desc);
+            uecli_JsonString(js, "help", pitem->helpstr);
+            uecli_JsonObjectEnd(js);
+            return UECLI_STATUS_OK;
+        }
+    #endif
+        int status = UECLI_STATUS_OK;
+        if (pitem && UECLI_TYPE_SUBMENU != pitem->itemType)
         {
             if (pitem->helpstr)
                 uecli_PrintString(pitem->helpstr);
@@ -89,24 +434,34 @@ static void Cmd_HelpMain(int argc, char* argv[])
         {
             uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_INVALID_COMMAND, argv[1]);
             uecli_PrintString(uecli.tmpString);
+            status = UECLI_STATUS_ERROR;
         }
         
         uecli_PrintString(UECLI_NEWLINE);
-        return;
+        return status;
     }
 #endif
 
-    //ӡϵͳϢ
-    uecli_PrintString(STRING_COPYRIGHT_INFO);
-    
-    PrintHandleList(GetSyscmdHandle());     // ӡϵͳ
-    PrintHandleList(GetUserCmdHandle());    // ӡû
+    // 命令表不变时直接输出缓存的帮助
+#if UECLI_01_HELP_CACHE>0
+    const HelpCache* pc = NULL;
+#if UECLI_01_JSON>0
+    if (!uecli_JsonOutput())
+#endif
+    pc = GetHelpCache();
+    if (pc)
+        return OutputHelpCache(pc);
+#endif
+
+    // 打印版本信息和命令列表 超过一页时分页显示
+    uecli_Pager pager = {HelpListNext, NULL, NULL, (uintptr_t)GetSyscmdHandle(), 0};
 
     (void)argc;
     (void)argv;
+    return uecli_PageOutput(&pager);
 }
 
-// ver汾Ϣס
+// ver版本信息命令住函数
 static void Cmd_VerMain(int argc, char* argv[])
 {
     uecli_PrintString(STRING_VERSIONS);
@@ -115,7 +470,7 @@ static void Cmd_VerMain(int argc, char* argv[])
     (void)argv;
 }
 
-// CLEAR
+// CLEAR命令
 static void Cmd_ClearMain(int argc, char* argv[])
 {
     uecli_PrintString(STRING_CLEAR_SCREEN);
@@ -123,7 +478,7 @@ static void Cmd_ClearMain(int argc, char* argv[])
     (void)argv;
 }
 
-// ..һ
+// ..返回上一级命令
 static void Cmd_UpperMain(int argc, char* argv[])
 {
     PopMenuStack();
@@ -131,13 +486,399 @@ static void Cmd_UpperMain(int argc, char* argv[])
     (void)argv;
 }
 
-// ϵͳ
+#if UECLI_01_STATS>0
+// 64位无符号数转换为十进制字符串 buff至少21字节，返回字符串开头
+static const char* FormatUint64(char* buff, uint64_t value)
+{
+    char* p = &buff[20];
+
+    *p = '\0';
+    do
+    {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return p;
+}
+
+// 打印一条命令的统计信息
+static void PrintCmdStats(const CmdStats* pstat, bool json)
+{
+    char bytes[21];
+
+    // 耗时以微秒为单位 保留三位小数，超过32位的耗时按最大值显示
+    uint64_t ns = GetStatsPercentile(pstat, 500);
+    uint32_t p50 = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+    ns = GetStatsPercentile(pstat, 990);
+    uint32_t p99 = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+    uint32_t max = pstat->maxns > UINT32_MAX ? UINT32_MAX : (uint32_t)pstat->maxns;
+
+#if UECLI_01_JSON>0
+    uecli_Json* js = uecli_JsonOutput();
+    if (js)
+    {
+        uecli_JsonObjectBegin(js, NULL);
+        uecli_JsonString(js, "cmd", pstat->item->exename);
+        uecli_JsonInt(js, "calls", pstat->calls);
+        uecli_JsonInt(js, "bytes", (int64_t)pstat->bytes);
+        uecli_JsonFixed(js, "p50_us", (int64_t)GetStatsPercentile(pstat, 500), 3);
+        uecli_JsonFixed(js, "p99_us", (int64_t)GetStatsPercentile(pstat, 990), 3);
+        uecli_JsonFixed(js, "max_us", (int64_t)pstat->maxns, 3);
+        uecli_JsonObjectEnd(js);
+        return;
+    }
+#endif
+
+    if (json)
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_STATS_JSON1,
+            pstat->item->exename, pstat->calls, FormatUint64(bytes, pstat->bytes));
+        uecli_PrintString(uecli.tmpString);
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_STATS_JSON2,
+            p50 / 1000, p50 % 1000, p99 / 1000, p99 % 1000, max / 1000, max % 1000);
+    }
+    else
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_CMD_LIST, pstat->item->exename);
+        uecli_PrintString(uecli.tmpString);
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_STATS_ROW, pstat->calls,
+            p50 / 1000, p50 % 1000, p99 / 1000, p99 % 1000, max / 1000, max % 1000,
+            FormatUint64(bytes, pstat->bytes));
+    }
+    uecli_PrintString(uecli.tmpString);
+}
+
+// stats命令 显示命令执行统计
+static int Cmd_StatsMain(int argc, char* argv[])
+{
+    bool json = false;
+    int i = 1;
+
+    // 解析选项
+    for (; i < argc && '-' == argv[i][0]; ++i)
+    {
+        if (!uecli_strcasecmp(argv[i], "-m"))
+            json = true;
+        else if (!uecli_strcasecmp(argv[i], "-r"))
+        {
+            // 当前的stats命令和嵌套执行时的外层命令都不再记录
+            memset(uecli_stats, 0, sizeof(uecli_stats));
+            uecli.statcur = NULL;
+            return UECLI_STATUS_OK;
+        }
+    }
+
+    // 显示指定命令的统计
+    if (i < argc)
+    {
+        const uecli_MenuItem* pitem = SearchMatchCommand(argv[i]);
+        const CmdStats* pstat = pitem ? FindCmdStats(pitem, false) : NULL;
+        if (NULL == pitem)
+        {
+            uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_INVALID_COMMAND, argv[i]);
+            uecli_PrintString(uecli.tmpString);
+            uecli_PrintString(UECLI_NEWLINE);
+            return UECLI_STATUS_ERROR;
+        }
+    #if UECLI_01_JSON>0
+        json = json || uecli_JsonOutput();
+    #endif
+        if (!json)
+            uecli_PrintString(STRING_STATS_HEAD);
+        if (pstat && pstat->calls)
+            PrintCmdStats(pstat, json);
+        return UECLI_STATUS_OK;
+    }
+
+    // 显示所有命令的统计 结构化输出模式下不需要表头
+#if UECLI_01_JSON>0
+    json = json || uecli_JsonOutput();
+#endif
+    if (!json)
+        uecli_PrintString(STRING_STATS_HEAD);
+    for (i = 0; i < UECLI_CFG_STATS_NUM; ++i)
+    {
+        if (uecli_stats[i].calls)
+            PrintCmdStats(&uecli_stats[i], json);
+    }
+    return UECLI_STATUS_OK;
+}
+#endif
+
+#if UECLI_01_TRACE>0
+// trace命令 控制运行过程跟踪
+static int Cmd_TraceMain(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_TRACE_STATUS,
+            uecli_traceOn ? "on" : "off", uecli_TraceCount());
+        uecli_PrintString(uecli.tmpString);
+    }
+    else if (!uecli_strcasecmp(argv[1], "on"))
+        uecli_TraceEnable(true);
+    else if (!uecli_strcasecmp(argv[1], "off"))
+        uecli_TraceEnable(false);
+    else if (!uecli_strcasecmp(argv[1], "clear"))
+        uecli_TraceClear();
+    else if (!uecli_strcasecmp(argv[1], "dump"))
+        uecli_TraceExport(uecli_PrintString);
+    else
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_INVALID_COMMAND, argv[1]);
+        uecli_PrintString(uecli.tmpString);
+        uecli_PrintString(UECLI_NEWLINE);
+        return UECLI_STATUS_ERROR;
+    }
+    return UECLI_STATUS_OK;
+}
+#endif
+
+#if UECLI_01_JSON>0
+// format命令 切换输出格式
+static int Cmd_FormatMain(int argc, char* argv[])
+{
+    static const char* names[] = { "text", "json", "cbor" };
+
+    if (argc < 2)
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_FORMAT_STATUS, names[uecli.format]);
+        uecli_PrintString(uecli.tmpString);
+        return UECLI_STATUS_OK;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!uecli_strcasecmp(argv[1], names[i]))
+        {
+            uecli_SetFormat((uecli_Format)i);
+            return UECLI_STATUS_OK;
+        }
+    }
+    uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_INVALID_COMMAND, argv[1]);
+    uecli_PrintString(uecli.tmpString);
+    uecli_PrintString(UECLI_NEWLINE);
+    return UECLI_STATUS_ERROR;
+}
+#endif
+
+#if UECLI_01_WATCH>0 || UECLI_01_SCHED>0 || UECLI_01_PAGER>0
+// 提示命令格式错误 返回UECLI_STATUS_SYNTAX
+static int SyntaxError(const char* msg)
+{
+    uecli_PrintString(msg);
+    uecli_PrintString(UECLI_NEWLINE);
+    return UECLI_STATUS_SYNTAX;
+}
+#endif
+
+#if UECLI_01_WATCH>0
+// watch命令 定时重复执行命令
+static int Cmd_WatchMain(int argc, char* argv[])
+{
+    char line[UECLI_CFG_STR_MAXLEN];
+    int32_t ms = 1000;
+    int i = 1;
+
+    if (i + 1 < argc && !uecli_strcasecmp(argv[i], "-n"))
+    {
+        if (!estrtoi(argv[i + 1], &ms) || ms <= 0)
+            return SyntaxError(STRING_WATCH_USAGE);
+        i += 2;
+    }
+    if (i >= argc)
+        return SyntaxError(STRING_WATCH_USAGE);
+#if UECLI_01_JSON>0
+    if (UECLI_FORMAT_TEXT != uecli.format)
+        return UECLI_STATUS_ERROR;
+#endif
+
+    if (!GetArgsLine(argc, argv, i, line))
+        return SyntaxError(STRING_LINE_TOO_LONG);
+    return WatchStart(line, (uint32_t)ms) ? UECLI_STATUS_OK : UECLI_STATUS_ERROR;
+}
+#endif
+
+#if UECLI_01_SCHED>0
+// 定时命令的最大毫秒数 为节拍的整数倍
+#define SCHED_MAXMS (0x7FFFFFFF / UECLI_CFG_SCHED_TICK * UECLI_CFG_SCHED_TICK)
+
+// 解析时间 数字后接单位ms、s、m、h，没有单位时为秒
+//
+// 按节拍向上取整后的毫秒数不超过int32，数字溢出时返回false
+static bool ParseDuration(const char* str, uint32_t* pms)
+{
+    static const struct { const char* unit; uint32_t ms; } units[] =
+    {
+        { "ms", 1 }, { "s", 1000 }, { "", 1000 }, { "m", 60000 }, { "h", 3600000 }
+    };
+    uint32_t value = 0;
+
+    if (!*str)
+        return false;
+    for (; *str >= '0' && *str <= '9'; ++str)
+    {
+        uint32_t digit = (uint32_t)(*str - '0');
+        if (value > (0x7FFFFFFF - digit) / 10)
+            return false;
+        value = value * 10 + digit;
+    }
+    for (int i = 0; i < (int)(sizeof(units) / sizeof(units[0])); ++i)
+    {
+        if (!uecli_strcasecmp(str, units[i].unit))
+        {
+            if (!value || value > SCHED_MAXMS / units[i].ms)
+                return false;
+            *pms = value * units[i].ms;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 添加第index个参数开始的定时命令 delayms为首次执行的延迟，periodms为0时只执行一次
+static int AddSchedCmd(uint32_t delayms, uint32_t periodms, int argc, char* argv[], int index)
+{
+    char line[UECLI_CFG_STR_MAXLEN];
+    uint16_t id;
+
+    if (!GetArgsLine(argc, argv, index, line))
+        return SyntaxError(STRING_LINE_TOO_LONG);
+    if (0 == (id = SchedAdd(line, delayms, periodms)))
+    {
+        uecli_PrintString(STRING_SCHED_FULL);
+        return UECLI_STATUS_ERROR;
+    }
+    uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_SCHED_ADDED, id);
+    uecli_PrintString(uecli.tmpString);
+    return UECLI_STATUS_OK;
+}
+
+// every命令 周期执行命令
+static int Cmd_EveryMain(int argc, char* argv[])
+{
+    uint32_t ms;
+
+    if (argc < 3 || !ParseDuration(argv[1], &ms))
+        return SyntaxError(STRING_EVERY_USAGE);
+    return AddSchedCmd(ms, ms, argc, argv, 2);
+}
+
+// at命令 延迟执行一次命令
+static int Cmd_AtMain(int argc, char* argv[])
+{
+    uint32_t ms;
+
+    if (argc < 3 || !ParseDuration('+' == argv[1][0] ? &argv[1][1] : argv[1], &ms))
+        return SyntaxError(STRING_AT_USAGE);
+    return AddSchedCmd(ms, 0, argc, argv, 2);
+}
+
+// sched命令 显示或取消定时命令
+static int Cmd_SchedMain(int argc, char* argv[])
+{
+    int32_t id;
+
+    if (argc < 2)
+    {
+        SchedList();
+        return UECLI_STATUS_OK;
+    }
+    if (3 != argc || uecli_strcasecmp(argv[1], "cancel"))
+        return SyntaxError(STRING_SCHED_USAGE);
+    if (!uecli_strcasecmp(argv[2], "all"))
+    {
+        for (id = 1; id <= (int32_t)UECLI_CFG_SCHED_NUM; ++id)
+            SchedCancel((uint32_t)id);
+        return UECLI_STATUS_OK;
+    }
+    if (!estrtoi(argv[2], &id) || !SchedCancel((uint32_t)id))
+    {
+        uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_SCHED_INVALID, argv[2]);
+        uecli_PrintString(uecli.tmpString);
+        return UECLI_STATUS_ERROR;
+    }
+    return UECLI_STATUS_OK;
+}
+#endif
+
+#if UECLI_01_PAGER>0
+// more命令 设置分页行数或关闭分页
+static int Cmd_MoreMain(int argc, char* argv[])
+{
+    int32_t rows;
+
+    if (argc < 2)
+    {
+        if (uecli.pageoff)
+            uecli_PrintString("more: off" UECLI_NEWLINE);
+        else
+        {
+            uecli_snprintf(uecli.tmpString, UECLI_CFG_TEMP_MAXLEN, STRING_PAGER_STATUS,
+                uecli.pagerows ? uecli.pagerows : UECLI_CFG_PAGER_ROWS);
+            uecli_PrintString(uecli.tmpString);
+        }
+        return UECLI_STATUS_OK;
+    }
+    if (!uecli_strcasecmp(argv[1], "off") || !uecli_strcasecmp(argv[1], "on"))
+    {
+        uecli.pageoff = !uecli_strcasecmp(argv[1], "off");
+        return UECLI_STATUS_OK;
+    }
+    if (!estrtoi(argv[1], &rows) || rows < 2 || rows > 255)
+        return SyntaxError(STRING_MORE_USAGE);
+    uecli.pagerows = (uint8_t)rows;
+    uecli.pageoff = false;
+    return UECLI_STATUS_OK;
+}
+#endif
+
+// 系统命令表
 static const uecli_MenuItem uecli_syscmdList[] =
 {
-    UECLI_DECLARE_COMMAND(Cmd_UpperMain,   "..",       "ϼӲ˵"),
-    UECLI_DECLARE_COMMAND(Cmd_HelpMain,    "help",     "ʾֵ֧б"),
-    UECLI_DECLARE_COMMAND(Cmd_VerMain,     "ver",      "ʾ汾ͰϢ"),
-    UECLI_DECLARE_COMMAND(Cmd_ClearMain,   "cls",      "Ļ"),
+    UECLI_DECLARE_COMMAND(Cmd_UpperMain,      "..",       "返回上级子菜单"),
+    UECLI_DECLARE_COMMAND_EX(Cmd_HelpMain,    "help",     "显示支持的命令列表",
+        "help [-l|命令]" UECLI_NEWLINE
+        "  -l  只列出命令，名称按最长的名称对齐"),
+    UECLI_DECLARE_COMMAND(Cmd_VerMain,        "ver",      "显示版本和帮助信息"),
+    UECLI_DECLARE_COMMAND(Cmd_ClearMain,      "cls",      "清空屏幕"),
+#if UECLI_01_STATS>0
+    UECLI_DECLARE_COMMAND_EX(Cmd_StatsMain,   "stats",    "显示命令执行统计",
+        "stats [-m] [-r] [命令]" UECLI_NEWLINE
+        "  -m  每行输出一个JSON对象" UECLI_NEWLINE
+        "  -r  清除所有统计数据"),
+#endif
+#if UECLI_01_TRACE>0
+    UECLI_DECLARE_COMMAND_EX(Cmd_TraceMain,   "trace",    "运行过程跟踪",
+        "trace [on|off|clear|dump]" UECLI_NEWLINE
+        "  dump  以Chrome Trace Event格式输出跟踪事件，可重定向到文件"),
+#endif
+#if UECLI_01_JSON>0
+    UECLI_DECLARE_COMMAND_EX(Cmd_FormatMain,  "format",   "切换输出格式",
+        "format [text|json|cbor]" UECLI_NEWLINE
+        "  json  每条命令输出一行JSON记录，不回显输入也不显示提示符" UECLI_NEWLINE
+        "  cbor  每条命令输出一个CBOR记录"),
+#endif
+#if UECLI_01_WATCH>0
+    UECLI_DECLARE_COMMAND_EX(Cmd_WatchMain,   "watch",    "定时重复执行命令",
+        "watch [-n 毫秒] 命令" UECLI_NEWLINE
+        "  只发送与上次输出不同的部分，按任意键退出"),
+#endif
+#if UECLI_01_SCHED>0
+    UECLI_DECLARE_COMMAND_EX(Cmd_EveryMain,   "every",    "周期执行命令",
+        "every 间隔 命令" UECLI_NEWLINE
+        "  间隔为数字后接ms、s、m、h，如every 5s stats"),
+    UECLI_DECLARE_COMMAND_EX(Cmd_AtMain,      "at",       "延迟执行一次命令",
+        "at +延迟 命令" UECLI_NEWLINE
+        "  延迟为数字后接ms、s、m、h，如at +30s dump"),
+    UECLI_DECLARE_COMMAND_EX(Cmd_SchedMain,   "sched",    "显示或取消定时命令",
+        "sched                 显示定时命令" UECLI_NEWLINE
+        "sched cancel 编号|all 取消定时命令"),
+#endif
+#if UECLI_01_PAGER>0
+    UECLI_DECLARE_COMMAND_EX(Cmd_MoreMain,    "more",     "设置分页输出",
+        "more [行数|on|off]" UECLI_NEWLINE
+        "  输出超过一页时暂停 空格下一页，回车下一行，/查找，n查找下一个，q退出"),
+#endif
     UECLI_DECLARE_END()
 };
 
@@ -0,0 +1,317 @@
+﻿/// \file uecli_file.c
+/// \brief 输出重定向文件接口
+///
+/// \details
+/// 为uecli的输出重定向(`cmd > file`)提供文件写入接口
+/// 命令输出先写入大块缓存，写满的缓存块交给后台线程写入磁盘，
+/// 命令执行过程中不会因为磁盘操作而阻塞，只有全部缓存块都在等待写入时才会等待，
+/// 关闭文件时等待剩余数据写入完成，以便报告准确的写入结果
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uecli.h"
+
+#if UECLI_01_REDIRECT>0
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// ********************************************************************************************
+// 平台相关的线程同步
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION FileLock;
+typedef CONDITION_VARIABLE FileCond;
+#define FILE_LOCK_INIT(m)       InitializeCriticalSection(m)
+#define FILE_LOCK(m)            EnterCriticalSection(m)
+#define FILE_UNLOCK(m)          LeaveCriticalSection(m)
+#define FILE_COND_INIT(c)       InitializeConditionVariable(c)
+#define FILE_COND_WAIT(c, m)    SleepConditionVariableCS(c, m, INFINITE)
+#define FILE_COND_SIGNAL(c)     WakeConditionVariable(c)
+#define FILE_COND_BROADCAST(c)  WakeAllConditionVariable(c)
+#else
+typedef pthread_mutex_t FileLock;
+typedef pthread_cond_t FileCond;
+#define FILE_LOCK_INIT(m)       pthread_mutex_init(m, NULL)
+#define FILE_LOCK(m)            pthread_mutex_lock(m)
+#define FILE_UNLOCK(m)          pthread_mutex_unlock(m)
+#define FILE_COND_INIT(c)       pthread_cond_init(c, NULL)
+#define FILE_COND_WAIT(c, m)    pthread_cond_wait(c, m)
+#define FILE_COND_SIGNAL(c)     pthread_cond_signal(c)
+#define FILE_COND_BROADCAST(c)  pthread_cond_broadcast(c)
+#endif
+
+// ********************************************************************************************
+// 内部类型定义
+
+struct FileChunk;
+
+// 打开的重定向文件
+typedef struct
+{
+    FILE* fp;               // 文件指针 由后台线程关闭
+    struct FileChunk* chunk;// 正在写入的缓存块
+    bool error;             // 写入出错标记 由writer.lock保护
+    bool closed;            // 后台线程已关闭文件 由writer.lock保护
+}FileHandle;
+
+// 文件缓存块
+typedef struct FileChunk
+{
+    struct FileChunk* next; // 队列中的下一块
+    FileHandle* file;       // 所属文件
+    uint32_t length;        // 有效数据长度
+    bool close;             // 写入后关闭文件
+    char data[UECLI_CFG_FILE_CHUNKSIZE];  // 数据缓存
+}FileChunk;
+
+// 后台写入对象
+static struct
+{
+    FileLock lock;
+    FileCond workcond;      // 有待写入的缓存块
+    FileCond freecond;      // 有空闲的缓存块
+    FileCond closecond;     // 有文件关闭完成
+    FileChunk* freelist;    // 空闲缓存块链表
+    FileChunk* head;        // 待写入队列头
+    FileChunk* tail;        // 待写入队列尾
+    bool started;           // 后台线程已启动 只在初始化时写入
+    FileChunk chunks[UECLI_CFG_FILE_CHUNKS];
+}writer;
+
+// 后台写入对象只初始化一次 多个会话线程同时打开第一个文件时也只启动一个后台线程
+#ifdef _WIN32
+static INIT_ONCE writeronce = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t writeronce = PTHREAD_ONCE_INIT;
+#endif
+
+// ********************************************************************************************
+// 内部函数
+
+// 后台写入线程 依次将队列中的缓存块写入磁盘
+#ifdef _WIN32
+static DWORD WINAPI WriterThread(LPVOID arg)
+#else
+static void* WriterThread(void* arg)
+#endif
+{
+    FileChunk* chunk;
+
+    for (;;)
+    {
+        FILE_LOCK(&writer.lock);
+        while (NULL == writer.head)
+            FILE_COND_WAIT(&writer.workcond, &writer.lock);
+        chunk = writer.head;
+        writer.head = chunk->next;
+        FILE_UNLOCK(&writer.lock);
+
+        // 在锁外写入磁盘
+        FileHandle* file = chunk->file;
+        bool error = false;
+        if (chunk->length && fwrite(chunk->data, 1, chunk->length, file->fp) != chunk->length)
+            error = true;
+        if (chunk->close && fclose(file->fp))
+            error = true;
+        if (error)
+        {
+            UECLI_LOG("写入重定向文件出错");
+        }
+
+        // 归还缓存块 关闭文件后通知等待关闭的线程，之后不能再访问file
+        FILE_LOCK(&writer.lock);
+        if (error)
+            file->error = true;
+        if (chunk->close)
+        {
+            file->closed = true;
+            FILE_COND_BROADCAST(&writer.closecond);
+        }
+        chunk->next = writer.freelist;
+        writer.freelist = chunk;
+        FILE_COND_SIGNAL(&writer.freecond);
+        FILE_UNLOCK(&writer.lock);
+    }
+
+    (void)arg;
+#ifndef _WIN32
+    return NULL;
+#endif
+}
+
+// 初始化缓存块并启动后台线程 只执行一次，启动失败时之后打开文件都失败
+#ifdef _WIN32
+static BOOL CALLBACK StartWriter(PINIT_ONCE once, PVOID param, PVOID* context)
+#else
+static void StartWriter(void)
+#endif
+{
+    FILE_LOCK_INIT(&writer.lock);
+    FILE_COND_INIT(&writer.workcond);
+    FILE_COND_INIT(&writer.freecond);
+    FILE_COND_INIT(&writer.closecond);
+    for (int i = 0; i < UECLI_CFG_FILE_CHUNKS; ++i)
+    {
+        writer.chunks[i].next = writer.freelist;
+        writer.freelist = &writer.chunks[i];
+    }
+
+#ifdef _WIN32
+    HANDLE thread = CreateThread(NULL, 0, WriterThread, NULL, 0, NULL);
+    if (NULL != thread)
+    {
+        CloseHandle(thread);
+        writer.started = true;
+    }
+    (void)once;
+    (void)param;
+    (void)context;
+    return TRUE;
+#else
+    pthread_t thread;
+    if (0 == pthread_create(&thread, NULL, WriterThread, NULL))
+    {
+        pthread_detach(thread);
+        writer.started = true;
+    }
+#endif
+}
+
+// 获取一个空闲缓存块 全部缓存块都在等待写入时等待后台线程
+static FileChunk* GetFreeChunk(FileHandle* file)
+{
+    FileChunk* chunk;
+
+    FILE_LOCK(&writer.lock);
+    while (NULL == writer.freelist)
+        FILE_COND_WAIT(&writer.freecond, &writer.lock);
+    chunk = writer.freelist;
+    writer.freelist = chunk->next;
+    FILE_UNLOCK(&writer.lock);
+
+    chunk->next = NULL;
+    chunk->file = file;
+    chunk->length = 0;
+    chunk->close = false;
+    return chunk;
+}
+
+// 将缓存块提交给后台线程
+static void CommitChunk(FileChunk* chunk)
+{
+    FILE_LOCK(&writer.lock);
+    if (writer.head)
+        writer.tail->next = chunk;
+    else
+        writer.head = chunk;
+    writer.tail = chunk;
+    FILE_COND_SIGNAL(&writer.workcond);
+    FILE_UNLOCK(&writer.lock);
+}
+
+// ********************************************************************************************
+// 接口函数
+
+/// \brief 打开重定向文件
+///
+/// \param name 文件名
+/// \param append true追加到文件末尾，false清空文件
+/// \return void* 文件句柄 失败返回NULL
+void* uecli_port_fopen(const char* name, bool append)
+{
+#ifdef _WIN32
+    InitOnceExecuteOnce(&writeronce, StartWriter, NULL, NULL);
+#else
+    pthread_once(&writeronce, StartWriter);
+#endif
+    if (!writer.started)
+        return NULL;
+
+    FileHandle* file = (FileHandle*)malloc(sizeof(FileHandle));
+    if (NULL == file)
+        return NULL;
+    file->error = file->closed = false;
+    file->fp = fopen(name, append ? "ab" : "wb");
+    if (NULL == file->fp)
+    {
+        free(file);
+        return NULL;
+    }
+
+    file->chunk = GetFreeChunk(file);
+    return file;
+}
+
+/// \brief 写入重定向文件 数据只复制到缓存中，由后台线程写入磁盘
+///
+/// \param file 文件句柄
+/// \param buff 数据
+/// \param num 数据长度
+/// \return void
+void uecli_port_fwrite(void* file, const void* buff, uint32_t num)
+{
+    FileHandle* handle = (FileHandle*)file;
+    const char* pdata = (const char*)buff;
+    uint32_t len;
+
+    while (num)
+    {
+        FileChunk* chunk = handle->chunk;
+        len = UECLI_CFG_FILE_CHUNKSIZE - chunk->length;
+        if (len > num)
+            len = num;
+        memcpy(&chunk->data[chunk->length], pdata, len);
+        chunk->length += len;
+        pdata += len;
+        num -= len;
+
+        // 缓存块写满后提交
+        if (UECLI_CFG_FILE_CHUNKSIZE == chunk->length)
+        {
+            CommitChunk(chunk);
+            handle->chunk = GetFreeChunk(handle);
+        }
+    }
+}
+
+/// \brief 关闭重定向文件 剩余数据和关闭操作交给后台线程完成，等待文件关闭后返回
+///
+/// \param file 文件句柄
+/// \return bool 全部数据写入并成功关闭文件返回true
+bool uecli_port_fclose(void* file)
+{
+    FileHandle* handle = (FileHandle*)file;
+    bool result;
+
+    handle->chunk->close = true;
+    CommitChunk(handle->chunk);
+
+    FILE_LOCK(&writer.lock);
+    while (!handle->closed)
+        FILE_COND_WAIT(&writer.closecond, &writer.lock);
+    result = !handle->error;
+    FILE_UNLOCK(&writer.lock);
+
+    free(handle);
+    return result;
+}
+
+#endif
@@ -0,0 +1,518 @@
+﻿/// \file uecli_json.c
+/// \brief 流式JSON/CBOR输出
+///
+/// \details
+/// JSON字符串按连续的不需要转义的字符段整段写入，只有控制字符、引号和反斜杠逐个转义。
+/// CBOR使用不定长度的映射、数组和文本(RFC 8949)，定点数使用十进制小数标记(tag 4)。
+/// 文本都按UTF-8检查，不是有效UTF-8的字节(如GBK编码的中文)按Latin-1映射为U+0080~U+00FF，
+/// JSON中写为\u00XX，CBOR中写为对应的两字节UTF-8，保证输出的文本都是有效的UTF-8
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <string.h>
+#include "uecli_json.h"
+
+#if UECLI_01_JSON>0
+
+// ********************************************************************************************
+// 内部宏定义
+
+// CBOR主类型
+#define CBOR_UINT       (0x00)
+#define CBOR_NEGINT     (0x20)
+#define CBOR_TEXT       (0x60)
+#define CBOR_TAG        (0xc0)
+#define CBOR_ARRAY      (0x80)
+
+// CBOR单字节数据
+#define CBOR_TEXT_BEGIN     (0x7f)  // 不定长度文本
+#define CBOR_ARRAY_BEGIN    (0x9f)  // 不定长度数组
+#define CBOR_MAP_BEGIN      (0xbf)  // 不定长度映射
+#define CBOR_FALSE          (0xf4)
+#define CBOR_TRUE           (0xf5)
+#define CBOR_NULL           (0xf6)
+#define CBOR_BREAK          (0xff)  // 不定长度数据结束
+
+// ********************************************************************************************
+// 内部函数
+
+// 写入数据 大块数据直接输出
+static void Write(uecli_Json* js, const char* buff, uint32_t len)
+{
+    if (js->len + len > UECLI_CFG_JSON_BUFFSIZE)
+    {
+        uecli_JsonFlush(js);
+        if (len > UECLI_CFG_JSON_BUFFSIZE / 2)
+        {
+            js->out(js->ctx, buff, len);
+            return;
+        }
+    }
+    memcpy(&js->buff[js->len], buff, len);
+    js->len += (uint16_t)len;
+}
+
+static inline void WriteChar(uecli_Json* js, char c)
+{
+    if (js->len == UECLI_CFG_JSON_BUFFSIZE)
+        uecli_JsonFlush(js);
+    js->buff[js->len++] = c;
+}
+
+// 写入CBOR数据头
+static void WriteCborHead(uecli_Json* js, uint8_t major, uint64_t value)
+{
+    char head[9];
+    uint32_t len;
+
+    if (value < 24)
+    {
+        WriteChar(js, (char)(major | value));
+        return;
+    }
+    if (value <= 0xff)
+        len = 1, head[0] = (char)(major | 24);
+    else if (value <= 0xffff)
+        len = 2, head[0] = (char)(major | 25);
+    else if (value <= 0xffffffffu)
+        len = 4, head[0] = (char)(major | 26);
+    else
+        len = 8, head[0] = (char)(major | 27);
+
+    // 大端序
+    for (uint32_t i = 0; i < len; ++i)
+        head[len - i] = (char)(value >> (8 * i));
+    Write(js, head, len + 1);
+}
+
+// 检查str开始的UTF-8字符 返回字符长度，无效返回0，数据不完整返回-1
+static int Utf8Char(const unsigned char* str, uint32_t len)
+{
+    unsigned char lo = 0x80, hi = 0xbf;
+    unsigned char c = str[0];
+    int num;
+
+    if (c < 0x80)
+        return 1;
+    if (c < 0xc2 || c > 0xf4)
+        return 0;
+    num = c < 0xe0 ? 2 : (c < 0xf0 ? 3 : 4);
+
+    // 排除过长编码、代理区和超出U+10FFFF的字符
+    if (0xe0 == c)
+        lo = 0xa0;
+    else if (0xed == c)
+        hi = 0x9f;
+    else if (0xf0 == c)
+        lo = 0x90;
+    else if (0xf4 == c)
+        hi = 0x8f;
+    for (int i = 1; i < num; ++i, lo = 0x80, hi = 0xbf)
+    {
+        if ((uint32_t)i >= len)
+            return -1;
+        if (str[i] < lo || str[i] > hi)
+            return 0;
+    }
+    return num;
+}
+
+// 流式文本末尾未完整的UTF-8字符长度
+static uint32_t Utf8Tail(const unsigned char* str, uint32_t len)
+{
+    for (uint32_t i = 1; i <= 3 && i <= len; ++i)
+    {
+        unsigned char c = str[len - i];
+        if (c < 0x80)
+            break;
+        if (c >= 0xc0)
+            return Utf8Char(&str[len - i], i) < 0 ? i : 0;
+    }
+    return 0;
+}
+
+// 写入文本内容 JSON转义且不包括引号，CBOR为一段定长文本
+//
+// 不是有效UTF-8的字节按Latin-1映射，JSON写为\u00XX，CBOR写为两字节UTF-8
+static void WriteText(uecli_Json* js, const char* str, uint32_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char* pstr = (const unsigned char*)str;
+    uint32_t start = 0;
+    uint32_t i = 0;
+    int num;
+
+    // CBOR先计算映射后的长度
+    if (js->cbor)
+    {
+        uint32_t size = 0;
+        for (i = 0; i < len; i += num > 0 ? num : 1)
+            size += (num = Utf8Char(&pstr[i], len - i)) > 0 ? num : 2;
+        WriteCborHead(js, CBOR_TEXT, size);
+    }
+
+    for (i = 0; i < len; )
+    {
+        unsigned char c = pstr[i];
+        if (c >= 0x80)
+        {
+            if ((num = Utf8Char(&pstr[i], len - i)) > 0)
+            {
+                i += num;
+                continue;
+            }
+        }
+        else if (js->cbor || (c >= 0x20 && '"' != c && '\\' != c))
+        {
+            ++i;
+            continue;
+        }
+
+        // 先整段写入前面不需要转义的字符
+        Write(js, &str[start], i - start);
+        start = ++i;
+
+        char esc[6] = { '\\', 0, 0, 0, 0, 0 };
+        uint32_t n = 2;
+        if (js->cbor)
+        {
+            esc[0] = (char)(0xc0 | (c >> 6));
+            esc[1] = (char)(0x80 | (c & 0x3f));
+            Write(js, esc, n);
+            continue;
+        }
+        switch (c)
+        {
+        case '"':  esc[1] = '"'; break;
+        case '\\': esc[1] = '\\'; break;
+        case '\n': esc[1] = 'n'; break;
+        case '\r': esc[1] = 'r'; break;
+        case '\t': esc[1] = 't'; break;
+        case '\b': esc[1] = 'b'; break;
+        case '\f': esc[1] = 'f'; break;
+        default:
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0x0f];
+            n = 6;
+            break;
+        }
+        Write(js, esc, n);
+    }
+    Write(js, &str[start], len - start);
+}
+
+// 写入字符串 JSON加引号转义，CBOR为定长文本
+static void WriteString(uecli_Json* js, const char* str)
+{
+    uint32_t len = (uint32_t)strlen(str);
+
+    if (js->cbor)
+    {
+        WriteText(js, str, len);
+        return;
+    }
+    WriteChar(js, '"');
+    WriteText(js, str, len);
+    WriteChar(js, '"');
+}
+
+// 结束流式文本成员 末尾未完整的UTF-8字符按无效字节写入
+static void EndText(uecli_Json* js)
+{
+    if (js->text)
+    {
+        if (js->pendlen)
+            WriteText(js, js->pend, js->pendlen);
+        js->pendlen = 0;
+        js->text = false;
+        WriteChar(js, js->cbor ? (char)CBOR_BREAK : '"');
+    }
+}
+
+// 开始写入一个成员 写入分隔符和名称
+static void BeginMember(uecli_Json* js, const char* key)
+{
+    uint32_t bit = 1u << (js->depth & 31);
+
+    EndText(js);
+    if (js->depth && !js->cbor && (js->member & bit))
+        WriteChar(js, ',');
+    js->member |= bit;
+    if (key)
+    {
+        WriteString(js, key);
+        if (!js->cbor)
+            WriteChar(js, ':');
+    }
+}
+
+// 写入十进制整数 decimals为小数位数
+static void WriteDecimal(uecli_Json* js, int64_t value, uint8_t decimals)
+{
+    char buff[24];
+    char* p = &buff[sizeof(buff)];
+    uint64_t abs = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    int digits = 0;
+
+    do
+    {
+        if (decimals && digits == decimals)
+            *--p = '.';
+        *--p = (char)('0' + abs % 10);
+        abs /= 10;
+        ++digits;
+    } while (abs || digits <= decimals);
+    if (value < 0)
+        *--p = '-';
+    Write(js, p, (uint32_t)(&buff[sizeof(buff)] - p));
+}
+
+// 写入CBOR整数
+static void WriteCborInt(uecli_Json* js, int64_t value)
+{
+    if (value < 0)
+        WriteCborHead(js, CBOR_NEGINT, (uint64_t)(-1 - value));
+    else
+        WriteCborHead(js, CBOR_UINT, (uint64_t)value);
+}
+
+// ********************************************************************************************
+// 接口函数
+
+/// \brief 初始化写入器
+///
+/// \param js 写入器
+/// \param cbor 输出CBOR格式，否则输出JSON
+/// \param out 输出函数
+/// \param ctx 输出函数上下文
+/// \return void
+void uecli_JsonInit(uecli_Json* js, bool cbor, uecli_JsonOut out, void* ctx)
+{
+    memset(js, 0, sizeof(*js));
+    js->cbor = cbor;
+    js->out = out;
+    js->ctx = ctx;
+}
+
+/// \brief 输出缓存中的数据
+///
+/// \param js 写入器
+/// \return void
+void uecli_JsonFlush(uecli_Json* js)
+{
+    if (js->len)
+        js->out(js->ctx, js->buff, js->len);
+    js->len = 0;
+}
+
+/// \brief 开始一个对象
+///
+/// \param js 写入器
+/// \param key 成员名称 数组成员或顶层为NULL
+/// \return void
+void uecli_JsonObjectBegin(uecli_Json* js, const char* key)
+{
+    BeginMember(js, key);
+    WriteChar(js, js->cbor ? (char)CBOR_MAP_BEGIN : '{');
+    ++js->depth;
+    js->member &= ~(1u << (js->depth & 31));
+}
+
+/// \brief 结束对象
+///
+/// \param js 写入器
+/// \return void
+void uecli_JsonObjectEnd(uecli_Json* js)
+{
+    EndText(js);
+    --js->depth;
+    WriteChar(js, js->cbor ? (char)CBOR_BREAK : '}');
+}
+
+/// \brief 开始一个数组
+///
+/// \param js 写入器
+/// \param key 成员名称 数组成员或顶层为NULL
+/// \return void
+void uecli_JsonArrayBegin(uecli_Json* js, const char* key)
+{
+    BeginMember(js, key);
+    WriteChar(js, js->cbor ? (char)CBOR_ARRAY_BEGIN : '[');
+    ++js->depth;
+    js->member &= ~(1u << (js->depth & 31));
+}
+
+/// \brief 结束数组
+///
+/// \param js 写入器
+/// \return void
+void uecli_JsonArrayEnd(uecli_Json* js)
+{
+    EndText(js);
+    --js->depth;
+    WriteChar(js, js->cbor ? (char)CBOR_BREAK : ']');
+}
+
+/// \brief 写入字符串成员
+///
+/// \param js 写入器
+/// \param key 成员名称
+/// \param value 字符串 NULL写入null
+/// \return void
+void uecli_JsonString(uecli_Json* js, const char* key, const char* value)
+{
+    if (!value)
+    {
+        uecli_JsonNull(js, key);
+        return;
+    }
+    BeginMember(js, key);
+    WriteString(js, value);
+}
+
+/// \brief 写入整数成员
+///
+/// \param js 写入器
+/// \param key 成员名称
+/// \param value 整数
+/// \return void
+void uecli_JsonInt(uecli_Json* js, const char* key, int64_t value)
+{
+    BeginMember(js, key);
+    if (js->cbor)
+        WriteCborInt(js, value);
+    else
+        WriteDecimal(js, value, 0);
+}
+
+/// \brief 写入定点数成员 如value=12345,decimals=3表示12.345
+///
+/// \param js 写入器
+/// \param key 成员名称
+/// \param value 定点数的整数值
+/// \param decimals 小数位数
+/// \return void
+void uecli_JsonFixed(uecli_Json* js, const char* key, int64_t value, uint8_t decimals)
+{
+    BeginMember(js, key);
+    if (!js->cbor)
+        WriteDecimal(js, value, decimals);
+    else if (!decimals)
+        WriteCborInt(js, value);
+    else
+    {
+        // 十进制小数 [指数, 尾数]
+        WriteCborHead(js, CBOR_TAG, 4);
+        WriteCborHead(js, CBOR_ARRAY, 2);
+        WriteCborInt(js, -(int64_t)decimals);
+        WriteCborInt(js, value);
+    }
+}
+
+/// \brief 写入布尔成员
+///
+/// \param js 写入器
+/// \param key 成员名称
+/// \param value 布尔值
+/// \return void
+void uecli_JsonBool(uecli_Json* js, const char* key, bool value)
+{
+    BeginMember(js, key);
+    if (js->cbor)
+        WriteChar(js, (char)(value ? CBOR_TRUE : CBOR_FALSE));
+    else if (value)
+        Write(js, "true", 4);
+    else
+        Write(js, "false", 5);
+}
+
+/// \brief 写入null成员
+///
+/// \param js 写入器
+/// \param key 成员名称
+/// \return void
+void uecli_JsonNull(uecli_Json* js, const char* key)
+{
+    BeginMember(js, key);
+    if (js->cbor)
+        WriteChar(js, (char)CBOR_NULL);
+    else
+        Write(js, "null", 4);
+}
+
+/// \brief 流式写入文本 连续调用的文本合并为数组中的一个字符串成员
+///
+/// 写入其他成员或结束数组时文本成员自动结束，被分在两次调用中的UTF-8字符合并后写入
+/// \param js 写入器
+/// \param buff 文本数据
+/// \param len 数据长度
+/// \return void
+void uecli_JsonText(uecli_Json* js, const char* buff, uint32_t len)
+{
+    if (!js->text)
+    {
+        BeginMember(js, NULL);
+        js->text = true;
+        WriteChar(js, js->cbor ? (char)CBOR_TEXT_BEGIN : '"');
+    }
+    if (!len)
+        return;
+
+    // 先补全上次末尾未完整的字符
+    if (js->pendlen)
+    {
+        char temp[8];
+        uint32_t take = len < 4u - js->pendlen ? len : 4u - js->pendlen;
+        memcpy(temp, js->pend, js->pendlen);
+        memcpy(&temp[js->pendlen], buff, take);
+
+        int num = Utf8Char((const unsigned char*)temp, js->pendlen + take);
+        if (num < 0)
+        {
+            memcpy(&js->pend[js->pendlen], buff, len);
+            js->pendlen += (uint8_t)len;
+            return;
+        }
+        if (num > 0)
+        {
+            WriteText(js, temp, (uint32_t)num);
+            buff += num - js->pendlen;
+            len -= num - js->pendlen;
+        }
+        else
+            WriteText(js, js->pend, js->pendlen);
+        js->pendlen = 0;
+    }
+
+    // 末尾未完整的字符留到下一次
+    uint32_t tail = Utf8Tail((const unsigned char*)buff, len);
+    if (len > tail)
+        WriteText(js, buff, len - tail);
+    memcpy(js->pend, &buff[len - tail], tail);
+    js->pendlen = (uint8_t)tail;
+}
+
+/// \brief 写入原始数据 如记录之间的分隔符
+///
+/// \param js 写入器
+/// \param buff 数据
+/// \param len 数据长度
+/// \return void
+void uecli_JsonRaw(uecli_Json* js, const char* buff, uint32_t len)
+{
+    EndText(js);
+    Write(js, buff, len);
+}
+
+#endif
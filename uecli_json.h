@@ -0,0 +1,75 @@
+﻿/// \file uecli_json.h
+/// \brief 流式JSON/CBOR输出
+///
+/// \details
+/// 不分配内存的流式结构化数据写入接口，同一套接口可以输出JSON文本或CBOR二进制。
+/// 写入的数据先合并到写入器内部的小缓存中，缓存满或记录结束时通过输出函数发送
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+#ifndef _U_E_CLI_JSON_H_
+#define _U_E_CLI_JSON_H_
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uecli_cfg.h"
+
+// ********************************************************************************************
+// 类型定义
+
+/// \brief 写入器输出函数
+typedef void(*uecli_JsonOut)(void* ctx, const char* buff, uint32_t num);
+
+/// \brief 流式写入器
+///
+/// 对象或数组中的成员使用key指定名称，数组中的成员和顶层数据key为NULL
+typedef struct
+{
+    uecli_JsonOut out;          ///< 输出函数
+    void* ctx;                  ///< 输出函数上下文
+    uint32_t member;            ///< 每一层是否已有成员 按位表示，最多32层
+    uint8_t depth;              ///< 当前嵌套层数
+    bool cbor;                  ///< 输出CBOR格式
+    bool text;                  ///< 正在写入流式文本成员
+    uint8_t pendlen;            ///< 流式文本末尾未完整的UTF-8字符长度
+    char pend[4];               ///< 流式文本末尾未完整的UTF-8字符 与下一段文本合并后写入
+    uint16_t len;               ///< 缓存中的数据长度
+    char buff[UECLI_CFG_JSON_BUFFSIZE]; ///< 合并缓存
+}uecli_Json;
+
+// ********************************************************************************************
+// 接口函数
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void uecli_JsonInit(uecli_Json* js, bool cbor, uecli_JsonOut out, void* ctx);
+void uecli_JsonFlush(uecli_Json* js);
+void uecli_JsonObjectBegin(uecli_Json* js, const char* key);
+void uecli_JsonObjectEnd(uecli_Json* js);
+void uecli_JsonArrayBegin(uecli_Json* js, const char* key);
+void uecli_JsonArrayEnd(uecli_Json* js);
+void uecli_JsonString(uecli_Json* js, const char* key, const char* value);
+void uecli_JsonInt(uecli_Json* js, const char* key, int64_t value);
+void uecli_JsonFixed(uecli_Json* js, const char* key, int64_t value, uint8_t decimals);
+void uecli_JsonBool(uecli_Json* js, const char* key, bool value);
+void uecli_JsonNull(uecli_Json* js, const char* key);
+void uecli_JsonText(uecli_Json* js, const char* buff, uint32_t len);
+void uecli_JsonRaw(uecli_Json* js, const char* buff, uint32_t len);
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,209 @@
+﻿/// \file uecli_trace.c
+/// \brief 运行过程跟踪
+///
+/// \details
+/// 每个线程第一次记录事件时分配一个环形缓存，之后只由该线程写入，
+/// 写入位置以原子操作发布，导出时无需停止写入线程
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+// ********************************************************************************************
+// 头文件
+
+#include <stddef.h>
+#include "uecli_trace.h"
+
+#if UECLI_01_TRACE>0
+
+// ********************************************************************************************
+// 内部类型定义
+
+#if (UECLI_CFG_TRACE_EVENTS & (UECLI_CFG_TRACE_EVENTS - 1))
+#error "UECLI_CFG_TRACE_EVENTS必须为2的幂"
+#endif
+
+// 跟踪事件
+typedef struct
+{
+    uint64_t start;         // 开始时间 ns
+    uint32_t duration;      // 持续时间 ns
+    uint32_t stage;         // 跟踪阶段
+    const char* name;       // 附加名称 如命令名
+}TraceEvent;
+
+// 线程环形缓存
+typedef struct
+{
+    volatile uint32_t head;     // 已写入事件总数 只由所属线程修改
+    volatile uint32_t start;    // 清除时的写入位置 之前的事件不再导出
+    char pad[UECLI_CFG_CACHELINE - 2 * sizeof(uint32_t)];  // 避免不同线程的写入位置共享缓存行
+    TraceEvent events[UECLI_CFG_TRACE_EVENTS];
+}TraceRing;
+
+// ********************************************************************************************
+// 内部变量
+
+// 跟踪阶段名称
+static const char* const stagename[UECLI_TRACE_STAGE_NUM] =
+{
+    "decode", "split", "lookup", "handler", "output", "user"
+};
+
+static TraceRing rings[UECLI_CFG_TRACE_THREADS];    // 线程环形缓存
+static volatile uint32_t ringcount;                 // 已分配的环形缓存数量
+static UECLI_THREAD_LOCAL TraceRing* threadring;    // 当前线程的环形缓存
+static UECLI_THREAD_LOCAL bool threadfull;          // 环形缓存已分配完 当前线程不记录
+static uint64_t tracebase;                          // 打开跟踪的时间 导出时间的起点
+
+volatile uint32_t uecli_traceOn;
+
+// ********************************************************************************************
+// 内部函数
+
+// 为当前线程分配环形缓存
+static TraceRing* ClaimRing(void)
+{
+    if (threadfull)
+        return NULL;
+
+    uint32_t index = uecli_atomic_fetch_add(&ringcount, 1);
+    if (index >= UECLI_CFG_TRACE_THREADS)
+    {
+        threadfull = true;
+        return NULL;
+    }
+    threadring = &rings[index];
+    return threadring;
+}
+
+// 导出一个事件
+static void ExportEvent(void(*pfun)(const char*), const TraceEvent* pev, int tid, bool first)
+{
+    char buff[160];
+    uint64_t ts = pev->start > tracebase ? (pev->start - tracebase) : 0;
+
+    esnprintf(buff, sizeof(buff),
+        "%s{\"name\":\"%s\",\"cat\":\"uecli\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+        "\"ts\":%d.%03d,\"dur\":%d.%03d",
+        first ? "" : "," UECLI_NEWLINE, stagename[pev->stage], tid,
+        (uint32_t)(ts / 1000), (uint32_t)(ts % 1000), pev->duration / 1000, pev->duration % 1000);
+    pfun(buff);
+
+    if (pev->name)
+    {
+        esnprintf(buff, sizeof(buff), ",\"args\":{\"name\":\"%s\"}", pev->name);
+        pfun(buff);
+    }
+    pfun("}");
+}
+
+// ********************************************************************************************
+// 接口函数
+
+/// \brief 打开或关闭跟踪
+///
+/// \param enable true打开跟踪
+/// \return void
+void uecli_TraceEnable(bool enable)
+{
+    if (enable && !uecli_traceOn)
+        tracebase = uecli_gettime_ns();
+    uecli_traceOn = enable;
+}
+
+/// \brief 清除已记录的跟踪事件
+///
+/// \return void
+void uecli_TraceClear(void)
+{
+    uint32_t num = uecli_atomic_load(&ringcount);
+    for (uint32_t i = 0; i < num && i < UECLI_CFG_TRACE_THREADS; ++i)
+        uecli_atomic_store(&rings[i].start, uecli_atomic_load(&rings[i].head));
+}
+
+/// \brief 获取可导出的跟踪事件数量
+///
+/// \return uint32_t 事件数量
+uint32_t uecli_TraceCount(void)
+{
+    uint32_t num = uecli_atomic_load(&ringcount);
+    uint32_t count = 0, head, start;
+
+    for (uint32_t i = 0; i < num && i < UECLI_CFG_TRACE_THREADS; ++i)
+    {
+        head = uecli_atomic_load(&rings[i].head);
+        start = uecli_atomic_load(&rings[i].start);
+        count += (head - start) < UECLI_CFG_TRACE_EVENTS ? (head - start) : UECLI_CFG_TRACE_EVENTS - 1;
+    }
+    return count;
+}
+
+/// \brief 记录一个跟踪事件 一般通过UECLI_TRACE_BEGIN/UECLI_TRACE_END调用
+///
+/// \param stage 跟踪阶段 uecli_TraceStage
+/// \param name 附加名称 必须为常量字符串，可为NULL
+/// \param start 开始时间 ns
+/// \param end 结束时间 ns
+/// \return void
+void uecli_TraceRecord(int stage, const char* name, uint64_t start, uint64_t end)
+{
+    TraceRing* ring = threadring;
+    if (NULL == ring && NULL == (ring = ClaimRing()))
+        return;
+
+    uint32_t head = ring->head;
+    TraceEvent* pev = &ring->events[head & (UECLI_CFG_TRACE_EVENTS - 1)];
+    pev->start = start;
+    pev->duration = (uint32_t)(end - start);
+    pev->stage = (uint32_t)stage;
+    pev->name = name;
+
+    // 事件写完后再发布写入位置
+    uecli_atomic_store(&ring->head, head + 1);
+}
+
+/// \brief 以Chrome Trace Event格式导出跟踪事件 可在chrome://tracing或Perfetto中打开
+///
+/// 导出期间暂停跟踪，导出前已开始的事件仍可能写入，导出过程中被覆盖的事件将被跳过
+/// \param pfun 字符串输出函数
+/// \return void
+void uecli_TraceExport(void(*pfun)(const char*))
+{
+    uint32_t enable = uecli_traceOn;
+    uint32_t num = uecli_atomic_load(&ringcount);
+    uint32_t head, start;
+    TraceEvent event;
+    bool first = true;
+
+    uecli_traceOn = 0;
+    pfun("{\"traceEvents\":[" UECLI_NEWLINE);
+    for (uint32_t i = 0; i < num && i < UECLI_CFG_TRACE_THREADS; ++i)
+    {
+        TraceRing* ring = &rings[i];
+        head = uecli_atomic_load(&ring->head);
+        start = uecli_atomic_load(&ring->start);
+        // 写入线程先写head所在的槽再递增head，相差一圈的槽可能正在被覆盖
+        if (head - start >= UECLI_CFG_TRACE_EVENTS)
+            start = head - UECLI_CFG_TRACE_EVENTS + 1;
+
+        for (; start != head; ++start)
+        {
+            event = ring->events[start & (UECLI_CFG_TRACE_EVENTS - 1)];
+
+            // 复制期间已被写入线程覆盖的事件不导出
+            if (uecli_atomic_load(&ring->head) - start >= UECLI_CFG_TRACE_EVENTS)
+                continue;
+            ExportEvent(pfun, &event, (int)i, first);
+            first = false;
+        }
+    }
+    pfun(UECLI_NEWLINE "],\"displayTimeUnit\":\"ns\"}" UECLI_NEWLINE);
+    uecli_traceOn = enable;
+}
+
+#endif
@@ -0,0 +1,88 @@
+﻿/// \file uecli_trace.h
+/// \brief 运行过程跟踪
+///
+/// \details
+/// 在输入解析、命令行分割、命令查找、命令执行和端口输出等阶段记录跟踪事件
+/// 每个线程拥有独立的环形缓存，记录时无需加锁，可导出为Chrome Trace Event格式
+///
+/// \author 张诗星
+/// \par
+/// (C) Copyright 杭州大仁科技有限公司
+///
+/// \version
+/// 2017/07/24 张诗星 初始版本\n
+
+#ifndef _U_E_CLI_TRACE_H_
+#define _U_E_CLI_TRACE_H_
+
+// ********************************************************************************************
+// 头文件
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uecli_cfg.h"
+
+// ********************************************************************************************
+// 类型定义
+
+/// \brief 跟踪阶段
+///
+typedef enum
+{
+    UECLI_TRACE_DECODE = 0,     ///< 输入字符解析
+    UECLI_TRACE_SPLIT,          ///< 命令行分割
+    UECLI_TRACE_LOOKUP,         ///< 命令查找
+    UECLI_TRACE_HANDLER,        ///< 命令执行
+    UECLI_TRACE_OUTPUT,         ///< 端口输出
+    UECLI_TRACE_USER,           ///< 用户自定义事件
+    UECLI_TRACE_STAGE_NUM
+}uecli_TraceStage;
+
+// ********************************************************************************************
+// 跟踪点
+
+#if UECLI_01_TRACE>0
+
+/// \brief 跟踪开关 关闭时每个跟踪点只有一次判断
+extern volatile uint32_t uecli_traceOn;
+
+/// \defgroup  UECLI_TRACE跟踪点定义
+/// \{
+///< 跟踪开始 跟踪打开时记录开始时间到局部变量VAR中
+#define UECLI_TRACE_BEGIN(VAR) \
+    uint64_t VAR = uecli_traceOn ? uecli_gettime_ns() : 0
+
+///< 跟踪结束 开始时跟踪已打开才记录事件
+#define UECLI_TRACE_END(STAGE, NAME, VAR) \
+    do { if (VAR) uecli_TraceRecord(STAGE, NAME, VAR, uecli_gettime_ns()); } while (0)
+/// \}
+
+#else
+
+#define UECLI_TRACE_BEGIN(VAR)
+#define UECLI_TRACE_END(STAGE, NAME, VAR)
+
+#endif
+
+// ********************************************************************************************
+// 接口函数
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t uecli_port_time_ns(void);
+
+void uecli_TraceEnable(bool enable);
+void uecli_TraceClear(void);
+uint32_t uecli_TraceCount(void);
+void uecli_TraceRecord(int stage, const char* name, uint64_t start, uint64_t end);
+void uecli_TraceExport(void(*pfun)(const char*));
+
+//兼容C C++混合编程
+#ifdef __cplusplus
+}
+#endif
+
+#endif
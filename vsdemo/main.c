@@ -12,7 +12,7 @@ void estrtoitest(int argc, char** argv)
         int res = estrtoi(argv[1], &temp);
 
         char tcharbuff[128];
-        esnprintf(tcharbuff, 128, "ִн%d %o %x, ֵ%d\r\n", temp, temp, temp, res);
+        esnprintf(tcharbuff, 128, "执行结果：%d %o %x, 返回值：%d\r\n", temp, temp, temp, res);
         uecli_PrintString(tcharbuff);
     }
 
@@ -30,12 +30,12 @@ void testprintf(int argc, char** argv)
         if (estrtoi(argv[2], &valu))
             esnprintf(tstr,128,argv[1], valu);
         else
-            esnprintf(tstr, 128, "%s", "ȷĲ\r\n");
+            esnprintf(tstr, 128, "%s", "请输入正确的参数\r\n");
     }
     else if (argc > 1)
         esnprintf(tstr, 128, argv[1]);
     else
-        esnprintf(tstr, 128, "%s", "ȷĲ\r\n");
+        esnprintf(tstr, 128, "%s", "请输入正确的参数\r\n");
 
     uecli_PrintString(tstr);
     argc;
@@ -51,7 +51,7 @@ void menufun(int argc, char** argv)
 
 const uecli_MenuItem submenu[] =
 {
-    UECLI_DECLARE_COMMAND(menufun,"testmenu", "Ӳ˵",""),
+    UECLI_DECLARE_COMMAND(menufun,"testmenu", "子菜单函数",""),
     UECLI_DECLARE_END()
 };
 
@@ -62,9 +62,9 @@ void eputchar(char chr)
 
 const uecli_MenuItem handtalbe[]=
 {
-    UECLI_DECLARE_COMMAND(estrtoitest,"estrtoi", "estrtoi"),
-    UECLI_DECLARE_COMMAND(testprintf,"eprintf", "eprintf"),
-    UECLI_DECLARE_SUBMENU(submenu,"menu1", "Ӳ˵"),
+    UECLI_DECLARE_COMMAND(estrtoitest,"estrtoi", "测试estrtoi"),
+    UECLI_DECLARE_COMMAND(testprintf,"eprintf", "测试eprintf"),
+    UECLI_DECLARE_SUBMENU(submenu,"menu1", "子菜单测试"),
     UECLI_DECLARE_END()
 };
 
@@ -77,7 +77,7 @@ int main(void)
 
     for (;;)
     {
-        len = uecli_port_in(buff, 1024);	/* ȡ */
+        len = uecli_port_in(buff, 1024);	/* 读取数据 */
         uecli_ProcessRecChar(buff, len);
     }
 }
@@ -7,6 +7,7 @@
 #include <tchar.h>
 
 #include "uecli_cfg.h"
+#include "uecli.h"
 
 // ********************************************************************************************
 // 内部变量
@@ -20,6 +21,40 @@ static OVERLAPPED _ro;
 // 写异步对象
 static OVERLAPPED _wo;
 
+#if UECLI_01_TX_RING>0
+// 发送线程 从uecli发送队列取出数据写入串口
+static HANDLE _txthread = NULL;
+// 队列中有新数据
+static HANDLE _txkick = NULL;
+// 发送完成一段数据
+static HANDLE _txdone = NULL;
+
+static DWORD WINAPI TxThread(LPVOID param)
+{
+    const char* pbuff;
+    uint32_t num;
+    DWORD len;
+
+    for (;;)
+    {
+        WaitForSingleObject(_txkick, INFINITE);
+
+        // 等待期间写入的数据一次发送
+        while ((num = uecli_TxPeek(&pbuff)) > 0)
+        {
+            if (!WriteFile(_hCom, pbuff, num, NULL, &_wo) && ERROR_IO_PENDING != GetLastError())
+                len = num;      // 出错时丢弃数据 避免命令一直等待
+            else if (!GetOverlappedResult(_hCom, &_wo, &len, TRUE) || !len)
+                len = num;
+            uecli_TxConsume(len);
+            SetEvent(_txdone);
+        }
+    }
+    (void)param;
+    return 0;
+}
+#endif
+
 // ********************************************************************************************
 // 接口函数
 
@@ -106,11 +141,42 @@ bool uecli_port_init(void)
         FALSE,      // 初始化状态-无信号
         NULL);      // 无事件名
 
+#if UECLI_01_TX_RING>0
+    _txkick = CreateEvent(NULL, FALSE, FALSE, NULL);
+    _txdone = CreateEvent(NULL, FALSE, FALSE, NULL);
+    _txthread = CreateThread(NULL, 0, TxThread, NULL, 0, NULL);
+    if (!_txkick || !_txdone || !_txthread)
+    {
+        CloseHandle(_hCom);
+        _hCom = NULL;
+        UECLI_LOG("创建发送线程出错,错误码%d.", GetLastError());
+        return false;
+    }
+#endif
+
     //初始化临界区
     UECLI_LOG("打开端口 %s 成功", comName);
     return true;
 }
 
+#if UECLI_01_TX_RING>0
+/**
+ * \brief      发送队列中有新数据 唤醒发送线程
+ */
+void uecli_port_tx_kick(void)
+{
+    SetEvent(_txkick);
+}
+
+/**
+ * \brief      发送队列超过高水位时调用 等待发送线程完成一段数据
+ */
+void uecli_port_tx_wait(void)
+{
+    WaitForSingleObject(_txdone, 10);
+}
+#endif
+
 /**
  * \brief      调用该函数以发送数据
  * \param[in] buff   待发送内存区
@@ -144,3 +210,19 @@ int uecli_port_in(void* buff, uint16_t maxnum)
     GetOverlappedResult(_hCom, &_ro, &len, TRUE);
     return len;
 }
+
+/**
+* \brief      获取单调时钟计数
+* \return     返回纳秒计数
+*/
+uint64_t uecli_port_time_ns(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)(count.QuadPart / freq.QuadPart * 1000000000 +
+        count.QuadPart % freq.QuadPart * 1000000000 / freq.QuadPart);
+}